@@ -0,0 +1,234 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/data_types/TrackBatch.hpp"
+#include "../src/detector/DetectorVolume.hpp"
+#include "../src/utility/CalculationAndAlgorithms.hpp"
+#include "../src/utility/GeometryKernels.hpp"
+#include "../src/utility/SyntheticBrick.hpp"
+#include "../src/vertex_search/VertexSearcher.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/* Microbenchmarks of the hot paths of the search: geometry kernels, detector volume indexing and tracks queries.
+ * Inputs are synthetic bricks with fixed seeds, so numbers of different builds are comparable.
+ * Run: kernels_benchmark [--benchmark_filter=regex] [--benchmark_format=json]
+ */
+
+namespace
+{
+    const u_int VOLUME_DIMENSION = 20000;        // microns, the same as the search uses
+    const u_long KERNEL_BRICK_TRACKS = 100000;   // tracks of the brick giving inputs to geometry kernels
+    const size_t INPUTS_COUNT = 4096;            // inputs are cycled, they fit in L2 cache
+    const size_t IMPACT_PARAMETERS_BATCH = 64;   // about the tracks count around a vertex at the standard density
+
+    const SyntheticBrick &getBrick(u_long tracksCount)
+    {
+        static std::map<u_long, SyntheticBrick> bricks;
+        auto found = bricks.find(tracksCount);
+        if (found == bricks.end())
+        {
+            SyntheticBrickConfig config;
+            config.tracksCount = tracksCount;
+            found = bricks.emplace(tracksCount, generateSyntheticBrick(config)).first;
+        }
+        return found->second;
+    }
+
+    /* Pairs of daughters of the same true vertex, the calculations reach the end as in the search. */
+    std::vector<std::pair<Track, Track>> createConvergingPairs()
+    {
+        auto &brick = getBrick(KERNEL_BRICK_TRACKS);
+        auto tracks = brick.createTracks();
+        std::vector<std::pair<Track, Track>> pairs;
+        for (auto &vertex : brick.truthVertexes)
+        {
+            for (size_t d = 1; d < vertex.daughters.size() && pairs.size() < INPUTS_COUNT; d++)
+            {
+                pairs.emplace_back(tracks[vertex.daughters[0]], tracks[vertex.daughters[d]]);
+            }
+        }
+        return pairs;
+    }
+
+    std::vector<Vertex> createTruthVertexes()
+    {
+        std::vector<Vertex> vertexes;
+        for (auto &vertex : getBrick(KERNEL_BRICK_TRACKS).truthVertexes)
+        {
+            vertexes.emplace_back(vertex.X, vertex.Y, vertex.Z);
+        }
+        return vertexes;
+    }
+
+    /* Positions and directions of tracks as the kernels take them, 3 floats each. */
+    std::vector<float> createVectors(bool directions)
+    {
+        auto &tracks = getBrick(KERNEL_BRICK_TRACKS).tracks;
+        std::vector<float> vectors;
+        for (size_t t = 0; t < INPUTS_COUNT; t++)
+        {
+            vectors.push_back(directions ? tracks.tanX[t] : tracks.X[t]);
+            vectors.push_back(directions ? tracks.tanY[t] : tracks.Y[t]);
+            vectors.push_back(directions ? 1 : tracks.Z[t]);
+        }
+        return vectors;
+    }
+
+    void BM_CrossProduct(benchmark::State &state, const GeometryKernels *kernels)
+    {
+        auto vectors = createVectors(true);
+        float result[3];
+        size_t v = 0;
+        for (auto _ : state)
+        {
+            kernels->crossProduct(&vectors[v * 3], &vectors[((v + 1) % INPUTS_COUNT) * 3], result);
+            benchmark::DoNotOptimize(result);
+            v = (v + 1) % INPUTS_COUNT;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_MixedProduct(benchmark::State &state, const GeometryKernels *kernels)
+    {
+        auto positions = createVectors(false);
+        auto directions = createVectors(true);
+        size_t v = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(kernels->mixedProduct(&positions[v * 3], &directions[v * 3], &directions[((v + 1) % INPUTS_COUNT) * 3]));
+            v = (v + 1) % INPUTS_COUNT;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_ImpactParameters(benchmark::State &state, const GeometryKernels *kernels)
+    {
+        auto vertexes = createTruthVertexes();
+        auto tracks = getBrick(KERNEL_BRICK_TRACKS).createTracks();
+        TrackBatch batch;
+        for (size_t t = 0; t < IMPACT_PARAMETERS_BATCH; t++)
+        {
+            batch.add(&tracks[t]);
+        }
+        auto columns = CalculationAndAlgorithms::getBatchColumns(batch);
+        std::vector<float> impactParameters(IMPACT_PARAMETERS_BATCH);
+        size_t v = 0;
+        for (auto _ : state)
+        {
+            float vertexPosition[3] = {vertexes[v].getX(), vertexes[v].getY(), vertexes[v].getZ()};
+            kernels->impactParameters(vertexPosition, columns, impactParameters.data());
+            benchmark::DoNotOptimize(impactParameters.data());
+            v = (v + 1) % vertexes.size();
+        }
+        state.SetItemsProcessed(state.iterations() * IMPACT_PARAMETERS_BATCH);
+    }
+
+    void BM_CalculateImpactParameter(benchmark::State &state)
+    {
+        auto vertexes = createTruthVertexes();
+        auto tracks = getBrick(KERNEL_BRICK_TRACKS).createTracks();
+        size_t v = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(CalculationAndAlgorithms::calculateImpactParameter(vertexes[v % vertexes.size()], &tracks[v]));
+            v = (v + 1) % INPUTS_COUNT;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_CalculateVertexCoordinates(benchmark::State &state)
+    {
+        auto pairs = createConvergingPairs();
+        VertexSearcher searcher;
+        size_t p = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(searcher.calculateVertexCoordinates(pairs[p].first, pairs[p].second));
+            p = (p + 1) % pairs.size();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_GetLinearCellIndex(benchmark::State &state)
+    {
+        auto &tracks = getBrick(KERNEL_BRICK_TRACKS).tracks;
+        DetectorVolume detectorVolume(VOLUME_DIMENSION, CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VOLUME_DIMENSION, tracks.size()));
+        size_t t = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(detectorVolume.getLinearCellIndex(tracks.X[t], tracks.Y[t], tracks.Z[t]));
+            t = (t + 1) % INPUTS_COUNT;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /* Arguments: tracks count of the brick (density), XY and Z distance of the query. Queries are around tracks positions. */
+    void BM_GetTracksAround(benchmark::State &state)
+    {
+        auto &brick = getBrick(state.range(0));
+        auto distance = (u_int)state.range(1);
+        DetectorVolume detectorVolume(VOLUME_DIMENSION, CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VOLUME_DIMENSION, brick.tracks.size()));
+        detectorVolume.addTracks(brick.createTracks());
+
+        auto &tracks = brick.tracks;
+        size_t t = 0, found = 0;
+        for (auto _ : state)
+        {
+            auto around = detectorVolume.getTracksAround(tracks.X[t], tracks.Y[t], tracks.Z[t], distance, distance, true, false);
+            found += around.size();
+            benchmark::DoNotOptimize(around.data());
+            t = (t + 1) % INPUTS_COUNT;
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["tracksFound"] = benchmark::Counter(found, benchmark::Counter::kAvgIterations);
+    }
+
+    /* Argument: tracks count. Volume creation and tracks copying are not measured. */
+    void BM_AddTracks(benchmark::State &state)
+    {
+        auto &brick = getBrick(state.range(0));
+        auto cellSize = CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VOLUME_DIMENSION, brick.tracks.size());
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto tracks = brick.createTracks();
+            auto detectorVolume = std::make_unique<DetectorVolume>(VOLUME_DIMENSION, cellSize);
+            state.ResumeTiming();
+
+            detectorVolume->addTracks(std::move(tracks));
+
+            state.PauseTiming();
+            detectorVolume.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * brick.tracks.size());
+    }
+}
+
+BENCHMARK(BM_CalculateImpactParameter);
+BENCHMARK(BM_CalculateVertexCoordinates);
+BENCHMARK(BM_GetLinearCellIndex);
+BENCHMARK(BM_GetTracksAround)->ArgsProduct({{20000, 100000, 500000}, {100, 500, 2000}});
+BENCHMARK(BM_AddTracks)->Arg(20000)->Arg(100000)->Arg(500000)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv)
+{
+    // every kernels variant the CPU supports is measured, the others use the selected one
+    for (auto kernels : getSupportedGeometryKernels())
+    {
+        std::string variant = std::string("/") + kernels->name;
+        benchmark::RegisterBenchmark(("BM_CrossProduct" + variant).c_str(), BM_CrossProduct, kernels);
+        benchmark::RegisterBenchmark(("BM_MixedProduct" + variant).c_str(), BM_MixedProduct, kernels);
+        benchmark::RegisterBenchmark(("BM_ImpactParameters" + variant).c_str(), BM_ImpactParameters, kernels);
+    }
+    benchmark::AddCustomContext("geometry_kernels", getGeometryKernels().name);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,413 @@
+#include "../src/downloaders/FedraDownloader.hpp"
+#include "../src/downloaders/NativeTrackFile.hpp"
+#include "../src/downloaders/NativeVertexFile.hpp"
+#include "../src/main/BrickPipeline.hpp"
+#include "../src/utility/GeometryKernels.hpp"
+#include "../src/utility/SyntheticBrick.hpp"
+#include "../src/utility/VertexMatching.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* End-to-end benchmark of the brick pipeline: load (read, prefilter and bin tracks), search and write, the same processBrick
+ * (src/main/BrickPipeline.hpp) as batch mode of AppLogic runs for every brick. Every case runs threads bricks at once, one per worker with its own downloader and volume.
+ * Usage: pipeline_benchmark [--sizes 20000,100000] [--threads 1,2] [--tracks a.trk,b.trk [--truth a.vtx,b.vtx]] [--output result.json]
+ *                           [--baseline baseline.json] [--physics-tolerance 0.01] [--tolerance 0.3]
+ * Synthetic bricks of the given sizes are generated with fixed seed unless --tracks files are given. Found vertexes are matched
+ * to the truth ones (generated with the brick or given by --truth) for efficiency, purity and position resolution. Results are printed
+ * as JSON (or written to --output, which could be stored as the next baseline). With --baseline exit code is 1 if any case has
+ * vertexes or tested pairs count differing from the baseline case of the same name, or physics performance worse, by more than
+ * the physics tolerance, so optimizations losing vertexes fail. These results do not depend on the machine. Times and memory
+ * depend on it and are compared only if --tolerance is given, a case slower or using more memory by more than it fails as well.
+ */
+
+namespace
+{
+    const double MIN_COMPARED_TIME_MS = 50;    // shorter stages are dominated by noise and not compared with baseline
+    const float DEFAULT_PHYSICS_TOLERANCE = 0.01; // the search is deterministic, only kernels rounding could move a vertex
+
+    /* Metrics of one case. Stage times are the longest among the workers. */
+    struct CaseResult
+    {
+        std::string name;
+        std::map<std::string, double> metrics;
+    };
+
+    enum class BetterValue
+    {
+        Larger,
+        Smaller,
+        Same // any change is regression
+    };
+
+    struct ComparedMetric
+    {
+        const char *name;
+        BetterValue better;
+        bool machineDependent; // compared with performance tolerance only if it is given, others with physics tolerance
+    };
+
+    /* Metrics compared with baseline. */
+    const ComparedMetric COMPARED_METRICS[] = {
+        {"vertexes", BetterValue::Same, false}, {"testedPairs", BetterValue::Same, false}, {"efficiency", BetterValue::Larger, false},
+        {"purity", BetterValue::Larger, false}, {"resolutionX", BetterValue::Smaller, false}, {"resolutionY", BetterValue::Smaller, false},
+        {"resolutionZ", BetterValue::Smaller, false}, {"loadMs", BetterValue::Smaller, true}, {"searchMs", BetterValue::Smaller, true},
+        {"writeMs", BetterValue::Smaller, true}, {"wallMs", BetterValue::Smaller, true}, {"tracksPerSecond", BetterValue::Larger, true},
+        {"pairsPerSecond", BetterValue::Larger, true}, {"peakRssMB", BetterValue::Smaller, true}};
+
+    /* Tracks file of the brick with optional truth vertexes file. */
+    struct BrickFiles
+    {
+        std::string namePrefix;
+        std::string tracksFileName;
+        std::string truthFileName;
+    };
+
+    double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /* Peak resident memory is reset before every case, so cases do not inherit the peak of the previous ones (Linux only). */
+    void resetPeakRss()
+    {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    double readPeakRssMB()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("VmHWM:", 0) == 0)
+                return std::stod(line.substr(6)) / 1024;
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+    }
+
+    std::vector<std::string> splitList(const std::string &list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+    std::string getBaseName(const std::string &fileName)
+    {
+        auto slash = fileName.find_last_of('/');
+        auto name = slash == std::string::npos ? fileName : fileName.substr(slash + 1);
+        return name.substr(0, name.find_last_of('.'));
+    }
+
+    /* Efficiency, purity and resolution of the written vertexes file, read back as analysis reads it. */
+    void addPhysicsMetrics(std::map<std::string, double> &metrics, const std::string &vertexesFileName, const std::string &truthFileName,
+                           const SearchConfig &config)
+    {
+        VertexMatchingConfig matchingConfig;
+        matchingConfig.volumeDimension = VOLUME_DIMENSION;
+        matchingConfig.minTruthDaughters = config.daughtersCountCut;
+        auto matching = matchVertexes(readVertexPoints(MappedVertexFile(vertexesFileName)), readVertexPoints(MappedVertexFile(truthFileName)),
+                                      matchingConfig);
+        metrics["truthVertexes"] = matching.truthCount;
+        metrics["matchedVertexes"] = matching.matchedTruthCount;
+        metrics["efficiency"] = matching.getEfficiency();
+        metrics["purity"] = matching.getPurity();
+        metrics["resolutionX"] = matching.resolutionX;
+        metrics["resolutionY"] = matching.resolutionY;
+        metrics["resolutionZ"] = matching.resolutionZ;
+    }
+
+    CaseResult runCase(const std::string &name, const BrickFiles &brick, u_long tracksCount, u_int threadsCount, const SearchConfig &config)
+    {
+        printf("Running case %s \n", name.c_str());
+        std::vector<BrickPipelineResult> results(threadsCount);
+        std::vector<std::exception_ptr> errors(threadsCount);
+        std::vector<std::thread> workers;
+
+        resetPeakRss();
+        auto start = std::chrono::steady_clock::now();
+        for (u_int w = 0; w < threadsCount; w++)
+        {
+            workers.emplace_back([&, w]()
+                                 {
+                try
+                {
+                    FedraDownloader downloader;
+                    results[w] = processBrick(downloader, config, brick.tracksFileName, {name + "_" + std::to_string(w) + ".vtx"});
+                }
+                catch (...)
+                {
+                    errors[w] = std::current_exception();
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        double wallMs = elapsedMs(start);
+        for (auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+        double peakRssMB = readPeakRssMB();
+
+        CaseResult result{name, {}};
+        auto &metrics = result.metrics;
+        metrics["tracks"] = tracksCount;
+        metrics["threads"] = threadsCount;
+        metrics["vertexes"] = results[0].vertexesCount;
+        metrics["testedPairs"] = results[0].testedPairs;
+        for (auto &brick : results)
+        {
+            metrics["loadMs"] = std::max(metrics["loadMs"], brick.loadMs);
+            metrics["searchMs"] = std::max(metrics["searchMs"], brick.searchMs);
+            metrics["writeMs"] = std::max(metrics["writeMs"], brick.writeMs);
+        }
+        metrics["wallMs"] = wallMs;
+        metrics["tracksPerSecond"] = tracksCount * threadsCount / (wallMs / 1000);
+        metrics["pairsPerSecond"] = (double)results[0].testedPairs * threadsCount / (metrics["searchMs"] / 1000);
+        metrics["peakRssMB"] = peakRssMB;
+
+        // workers search the same brick, so the first one is matched
+        if (!brick.truthFileName.empty())
+            addPhysicsMetrics(metrics, name + "_0.vtx", brick.truthFileName, config);
+        for (u_int w = 0; w < threadsCount; w++)
+        {
+            std::remove((name + "_" + std::to_string(w) + ".vtx").c_str());
+        }
+        return result;
+    }
+
+    void writeResults(FILE *file, const std::vector<CaseResult> &results)
+    {
+        fprintf(file, "{\n  \"context\": {\"geometryKernels\": \"%s\", \"hardwareThreads\": %u},\n  \"cases\": [\n",
+                getGeometryKernels().name, std::thread::hardware_concurrency());
+        for (size_t c = 0; c < results.size(); c++)
+        {
+            fprintf(file, "    {\"name\": \"%s\"", results[c].name.c_str());
+            for (auto &metric : results[c].metrics)
+            {
+                bool integral = metric.second == std::floor(metric.second);
+                fprintf(file, integral ? ", \"%s\": %.0f" : ", \"%s\": %.3f", metric.first.c_str(), metric.second);
+            }
+            fprintf(file, "}%s\n", c + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+    }
+
+    /* Reads the cases written by writeResults, other JSON is not supported. */
+    std::map<std::string, std::map<std::string, double>> readBaseline(const std::string &fileName)
+    {
+        std::ifstream file(fileName);
+        if (!file)
+        {
+            throw std::runtime_error("ERROR - could not open baseline file " + fileName);
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        auto text = content.str();
+        auto casesBegin = text.find("\"cases\"");
+        if (casesBegin == std::string::npos)
+        {
+            throw std::runtime_error("ERROR - no cases in baseline file " + fileName);
+        }
+
+        std::map<std::string, std::map<std::string, double>> baseline;
+        const std::regex caseRegex("\\{[^{}]*\\}");
+        const std::regex nameRegex("\"name\":\\s*\"([^\"]*)\"");
+        const std::regex metricRegex("\"(\\w+)\":\\s*([-+0-9.eE]+)");
+        for (std::sregex_iterator caseMatch(text.begin() + casesBegin, text.end(), caseRegex), end; caseMatch != end; ++caseMatch)
+        {
+            auto caseText = caseMatch->str();
+            std::smatch name;
+            if (!std::regex_search(caseText, name, nameRegex))
+                continue;
+            auto &metrics = baseline[name[1]];
+            for (std::sregex_iterator metric(caseText.begin(), caseText.end(), metricRegex); metric != end; ++metric)
+            {
+                metrics[(*metric)[1]] = std::stod((*metric)[2]);
+            }
+        }
+        return baseline;
+    }
+
+    /* Returns count of the regressed metrics. Cases missing in baseline are reported and skipped. Machine dependent metrics are
+    skipped without performance tolerance. */
+    u_int compareWithBaseline(const std::vector<CaseResult> &results, const std::map<std::string, std::map<std::string, double>> &baseline,
+                              std::optional<float> tolerance, float physicsTolerance)
+    {
+        u_int regressions = 0;
+        for (auto &result : results)
+        {
+            auto baselineCase = baseline.find(result.name);
+            if (baselineCase == baseline.end())
+            {
+                printf("Case %s is not in baseline, skipped. \n", result.name.c_str());
+                continue;
+            }
+            for (auto &[metricName, better, machineDependent] : COMPARED_METRICS)
+            {
+                if (machineDependent && !tolerance)
+                    continue;
+                auto baselineMetric = baselineCase->second.find(metricName);
+                auto measuredMetric = result.metrics.find(metricName);
+                if (baselineMetric == baselineCase->second.end())
+                    continue;
+                if (measuredMetric == result.metrics.end())
+                {
+                    printf("REGRESSION %s %s: not measured, baseline %.3f \n", result.name.c_str(), metricName, baselineMetric->second);
+                    regressions++;
+                    continue;
+                }
+                double expected = baselineMetric->second, measured = measuredMetric->second;
+                if (std::string(metricName).find("Ms") != std::string::npos && std::max(expected, measured) < MIN_COMPARED_TIME_MS)
+                    continue;
+
+                float metricTolerance = machineDependent ? *tolerance : physicsTolerance;
+                bool regressed = better != BetterValue::Smaller && measured < expected * (1 - metricTolerance);
+                regressed |= better != BetterValue::Larger && measured > expected * (1 + metricTolerance);
+                printf("%s %s %s: %.4f, baseline %.4f \n", regressed ? "REGRESSION" : "ok", result.name.c_str(), metricName, measured, expected);
+                regressions += regressed;
+            }
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> sizes{"20000", "100000"}, threads{"1", "2"}, tracksFileNames, truthFileNames;
+    std::string outputFileName, baselineFileName;
+    std::optional<float> tolerance;
+    float physicsTolerance = DEFAULT_PHYSICS_TOLERANCE;
+
+    try
+    {
+        for (int a = 1; a < argc; a++)
+        {
+            std::string option = argv[a];
+            if (a + 1 == argc)
+            {
+                throw std::invalid_argument("ERROR - option " + option + " has no value.");
+            }
+            std::string value = argv[++a];
+            if (option == "--sizes")
+                sizes = splitList(value);
+            else if (option == "--threads")
+                threads = splitList(value);
+            else if (option == "--tracks")
+                tracksFileNames = splitList(value);
+            else if (option == "--truth")
+                truthFileNames = splitList(value);
+            else if (option == "--output")
+                outputFileName = value;
+            else if (option == "--baseline")
+                baselineFileName = value;
+            else if (option == "--tolerance")
+                tolerance = std::stof(value);
+            else if (option == "--physics-tolerance")
+                physicsTolerance = std::stof(value);
+            else
+                throw std::invalid_argument("ERROR - unknown option " + option);
+        }
+        if (!truthFileNames.empty() && truthFileNames.size() != tracksFileNames.size())
+        {
+            throw std::invalid_argument("ERROR - every tracks file must have its truth vertexes file.");
+        }
+
+        // bricks are generated once and read from native track files by every case, as the search reads them
+        std::vector<BrickFiles> bricks;
+        std::vector<std::string> generatedFileNames;
+        if (tracksFileNames.empty())
+        {
+            for (auto &size : sizes)
+            {
+                SyntheticBrickConfig brickConfig;
+                brickConfig.tracksCount = std::stoul(size);
+                auto brick = generateSyntheticBrick(brickConfig);
+                auto fileName = "pipeline_benchmark_" + size + ".trk", truthFileName = "pipeline_benchmark_" + size + "_truth.vtx";
+                writeNativeTrackFile(fileName, brick.tracks);
+                if (!brick.writeTruthVertexes(truthFileName))
+                {
+                    throw std::runtime_error("ERROR - could not write truth vertexes file " + truthFileName);
+                }
+                generatedFileNames.push_back(fileName);
+                generatedFileNames.push_back(truthFileName);
+                bricks.push_back(BrickFiles{"synthetic_" + size, fileName, truthFileName});
+            }
+        }
+        for (size_t f = 0; f < tracksFileNames.size(); f++)
+        {
+            bricks.push_back(BrickFiles{getBaseName(tracksFileNames[f]), tracksFileNames[f], truthFileNames.empty() ? "" : truthFileNames[f]});
+        }
+
+        std::vector<CaseResult> results;
+        SearchConfig config;
+        for (auto &brick : bricks)
+        {
+            auto tracksCount = FedraDownloader().countTracksInFile(brick.tracksFileName);
+            for (auto &threadsCount : threads)
+            {
+                results.push_back(runCase(brick.namePrefix + "_t" + threadsCount, brick, tracksCount, std::stoul(threadsCount), config));
+            }
+        }
+        for (auto &fileName : generatedFileNames)
+        {
+            std::remove(fileName.c_str());
+        }
+
+        writeResults(stdout, results);
+        if (!outputFileName.empty())
+        {
+            FILE *output = fopen(outputFileName.c_str(), "w");
+            if (output == nullptr)
+            {
+                throw std::runtime_error("ERROR - could not create results file " + outputFileName);
+            }
+            writeResults(output, results);
+            fclose(output);
+        }
+
+        if (!baselineFileName.empty())
+        {
+            auto regressions = compareWithBaseline(results, readBaseline(baselineFileName), tolerance, physicsTolerance);
+            if (tolerance)
+                printf("%u metrics regressed more than %.0f%% (physics %.1f%%) against baseline %s \n", regressions, *tolerance * 100,
+                       physicsTolerance * 100, baselineFileName.c_str());
+            else
+                printf("%u metrics regressed more than %.1f%% against baseline %s, times and memory are not compared \n", regressions,
+                       physicsTolerance * 100, baselineFileName.c_str());
+            return regressions == 0 ? 0 : 1;
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        printf("%s \n", exception.what());
+        return 1;
+    }
+    return 0;
+}
@@ -15,6 +15,10 @@ public:
     Float_t getX() const { return X; }
     Float_t getY() const { return Y; }
     Float_t getZ() const { return Z; }
+    Float_t getTanX() const { return tanX; }
+    Float_t getTanY() const { return tanY; }
+    Float_t getTanZ() const { return tanZ; }
+    ULong_t getTrackId() const { return trackId; }
     
     Segment(ULong_t trackId, Float_t x, Float_t y, Float_t z, Float_t tanX, Float_t tanY, Float_t tanZ = 1) : DataObject(x, y, z) 
     {
@@ -34,6 +34,13 @@ public:
         segments.push_back(segment);
     }
 
+    /** @brief Tracks files store only tracks parameters, their segments are placeholders of the same values. */
+    void addPlaceholderSegments(u_int count)
+    {
+        Segment segment(index, 111, 111, 111, 222, 222);
+        segments.insert(segments.end(), count, segment);
+    }
+
     Segment &getSegment(int index)
     {
         if (segments.size() - 1 < index)
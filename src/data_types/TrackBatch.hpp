@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Track.hpp"
+
+#include <vector>
+
+/** @brief Tracks coordinates and directions stored by columns (structure of arrays) for SIMD calculations over many tracks.
+ * Batch keeps pointers to the gathered tracks, so results could be matched back by the track number in batch.
+ */
+class TrackBatch
+{
+private:
+    std::vector<float> X, Y, Z;
+    std::vector<float> tanX, tanY, tanZ;
+    std::vector<Track *> tracks;
+
+public:
+    void add(Track *track)
+    {
+        X.push_back(track->getX());
+        Y.push_back(track->getY());
+        Z.push_back(track->getZ());
+        tanX.push_back(track->getTanX());
+        tanY.push_back(track->getTanY());
+        tanZ.push_back(track->getTanZ());
+        tracks.push_back(track);
+    }
+
+    /** @brief Replace batch content by the tracks. */
+    void assign(const std::vector<Track *> &tracksToGather)
+    {
+        clear();
+        reserve(tracksToGather.size());
+        for (auto track : tracksToGather)
+        {
+            add(track);
+        }
+    }
+
+    void reserve(size_t count)
+    {
+        X.reserve(count);
+        Y.reserve(count);
+        Z.reserve(count);
+        tanX.reserve(count);
+        tanY.reserve(count);
+        tanZ.reserve(count);
+        tracks.reserve(count);
+    }
+
+    /** @brief Remove tracks, memory is kept for the next gathering. */
+    void clear()
+    {
+        X.clear();
+        Y.clear();
+        Z.clear();
+        tanX.clear();
+        tanY.clear();
+        tanZ.clear();
+        tracks.clear();
+    }
+
+    size_t size() const { return tracks.size(); }
+
+    Track *getTrack(size_t number) const { return tracks[number]; }
+
+    const float *getX() const { return X.data(); }
+    const float *getY() const { return Y.data(); }
+    const float *getZ() const { return Z.data(); }
+    const float *getTanX() const { return tanX.data(); }
+    const float *getTanY() const { return tanY.data(); }
+    const float *getTanZ() const { return tanZ.data(); }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Rtypes.h>
+#include <vector>
+
+/** @brief Tracks parameters read from file as columns (structure of arrays). */
+struct TrackColumns
+{
+    std::vector<Float_t> X, Y, Z;
+    std::vector<Float_t> tanX, tanY;
+    std::vector<ULong_t> index; // tracks indexes if they were reordered, empty if track index is its number in columns
+
+    ULong_t getIndex(size_t number) const { return index.empty() ? number : index[number]; }
+
+    void resize(size_t count)
+    {
+        X.resize(count);
+        Y.resize(count);
+        Z.resize(count);
+        tanX.resize(count);
+        tanY.resize(count);
+    }
+
+    void clear()
+    {
+        X.clear();
+        Y.clear();
+        Z.clear();
+        tanX.clear();
+        tanY.clear();
+        index.clear();
+    }
+
+    size_t size() const { return X.size(); }
+};
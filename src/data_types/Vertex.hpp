@@ -6,6 +6,7 @@
 #include <Rtypes.h>
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
 
 /** @brief Particle interaction Vertex */
 class Vertex : public DataObject
@@ -66,6 +67,19 @@ public:
         parentTracks = std::move(vertexToCopyFrom.parentTracks);
     }
 
+    /** @brief Replace stored daughter and parent tracks pointers, used when tracks were shifted in memory. */
+    void relinkTracks(const std::function<Track *(Track *)> &relink)
+    {
+        for (auto &track : daughterTracks)
+        {
+            track = relink(track);
+        }
+        for (auto &track : parentTracks)
+        {
+            track = relink(track);
+        }
+    }
+
     Track *getDaughterTrack(u_int index) { return daughterTracks[index]; }
 
     Track *getParentTrack(u_int index) { return parentTracks[index]; }
@@ -130,7 +144,8 @@ public:
     /** @brief Copy constructor will copy all vars and arrays. */
     Vertex(const Vertex &vertex) : DataObject(vertex.X, vertex.Y, vertex.Z)
     {
-        this->setIndex(vertex.index);
+        index = vertex.index;
+        indexInited = vertex.indexInited;
         daughterTracks = vertex.daughterTracks;
         parentTracks = vertex.parentTracks;
     }
@@ -138,14 +153,16 @@ public:
     /** @brief Move constructor will copy all vars and move arrays. */
     Vertex(const Vertex &&vertex) : DataObject(vertex.X, vertex.Y, vertex.Z)
     {
-        this->setIndex(vertex.index);
+        index = vertex.index;
+        indexInited = vertex.indexInited;
         daughterTracks = std::move(vertex.daughterTracks);
         parentTracks = std::move(vertex.parentTracks);
     }
 
     Vertex &operator=(const Vertex &vertex)
     {
-        this->setIndex(vertex.index);
+        index = vertex.index;
+        indexInited = vertex.indexInited;
         X = vertex.X;
         Y = vertex.Y;
         Z = vertex.Z;
@@ -156,7 +173,8 @@ public:
 
     Vertex &operator=(const Vertex &&vertex)
     {
-        this->setIndex(vertex.index);
+        index = vertex.index;
+        indexInited = vertex.indexInited;
         X = vertex.X;
         Y = vertex.Y;
         Z = vertex.Z;
@@ -9,164 +9,316 @@
 #include <set>
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Snapshot records are written and read in place, host must be little-endian.");
 
 namespace
 {
-    std::vector<VolumeCell> cells; // Cells storing all the data objects
+    const float MAX_REL_DIFF = 6; // Microns, used for comparing Vertex or Track coordinates equality.
 
-    u_int volumeDim = 0, cellDim = 0, cellsInDim = 0, cellsCount = 0, coordinateCorrection = 0;
+    // ================= SNAPSHOT ======================================================================================
 
-    const float MAX_REL_DIFF = 6; // Microns, used for comparing Vertex or Track coordinates equality.
+    const char SNAPSHOT_MAGIC[8] = {'D', 'S', 'T', 'A', 'U', 'D', 'V', 'S'};
+    const uint32_t SNAPSHOT_VERSION = 2;
+
+    /* Snapshot file is little-endian: header, tracks and vertexes counts of every cell, then records of all tracks and vertexes in
+    cells order, tracks references of vertexes (daughters, then parents) as track numbers in cells order, dirty cells. Tracks segments
+    are not stored, they are placeholders recreated by their count as the tracks files loader creates them. */
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t volumeDim, cellDim, windowLayers;
+        float windowZBegin, windowZEnd;
+        uint64_t vertexUniqueIndex;
+        uint64_t tracksCount, vertexesCount, tracksReferencesCount;
+        uint32_t cellsCount, dirtyCellsCount;
+    };
+
+    struct TrackRecord
+    {
+        uint64_t index;
+        float X, Y, Z, tanX, tanY, tanZ;
+        uint32_t segmentsCount;
+        uint32_t excluded;
+    };
 
-    u_long vertexUniqueIndex = 0;
+    struct VertexRecord
+    {
+        uint64_t index;
+        float X, Y, Z;
+        uint32_t daughtersCount, parentsCount;
+        uint8_t indexInited, excluded;
+        uint8_t padding[2];
+    };
 
-    // ==================================================================================================================
+    static_assert(sizeof(SnapshotHeader) == 72 && sizeof(TrackRecord) == 40 && sizeof(VertexRecord) == 32,
+                  "Snapshot records layout must not change within the version.");
+
+    template <class T>
+    void writeSnapshotSection(std::ofstream &file, const std::vector<T> &section)
+    {
+        file.write(reinterpret_cast<const char *>(section.data()), section.size() * sizeof(T));
+    }
 
-    void testBordersFit(float x, float y, float z)
+    template <class T>
+    void readSnapshotSection(std::ifstream &file, std::vector<T> &section, uint64_t count)
     {
-        if (std::abs(x) > coordinateCorrection || std::abs(y) > coordinateCorrection || z < 0 || z > volumeDim)
+        section.resize(count);
+        file.read(reinterpret_cast<char *>(section.data()), count * sizeof(T));
+    }
+
+    /* Tracks of one cell in memory and the number of its first track in cells order. */
+    struct CellTracksRange
+    {
+        const Track *begin;
+        u_int count;
+        uint64_t firstNumber;
+    };
+
+    /* Number of the track in cells order by its address, vertexes store only tracks pointers. */
+    uint64_t findTrackNumber(const std::vector<CellTracksRange> &ranges, const Track *track)
+    {
+        std::less<const Track *> addressLess;
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), track, [&addressLess](const Track *address, const CellTracksRange &range)
+                                   { return addressLess(address, range.begin); });
+        if (it == ranges.begin() || !addressLess(track, (--it)->begin + it->count))
         {
-            throw std::out_of_range("ERROR - at least one of the data coordinate goes beyond the detector borders.");
+            throw std::logic_error("ERROR in detector volume snapshot: vertex references track, which is not stored in the volume.");
         }
+        return it->firstNumber + (track - it->begin);
     }
 
-    /* Each data (vertex, track and so on) is stored in it's corresponding spatial cell.
-    Correspondance is defined by data coordinates, cell coordinates and cell dimension. */
-    u_int getLinearCellIndex(float x, float y, float z)
+} // ================================== end of file private namespace ==========================================
+
+void DetectorVolume::rememberCellTracks(std::unordered_map<u_int, CellTracksBefore> &cellsBefore, u_int cellInd)
+{
+    if (cellsBefore.count(cellInd) != 0)
+        return;
+    auto &cell = cells[cellInd];
+    CellTracksBefore cellBefore{cell.getTracksBegin(), cell.getTracksCount(), std::vector<bool>(cell.getTracksCount())};
+    for (u_int t = 0; t < cellBefore.count; t++)
     {
-        u_int X = (u_int)std::floor((x + coordinateCorrection) / cellDim);
-        u_int Y = (u_int)std::floor((y + coordinateCorrection) / cellDim);
-        u_int Z = (u_int)std::floor(z / cellDim);
+        cellBefore.excluded[t] = cell.getTrack(t).isExcluded();
+    }
+    cellsBefore.emplace(cellInd, std::move(cellBefore));
+}
 
-        return Z * cellsInDim * cellsInDim + Y * cellsInDim + X;
+void DetectorVolume::relinkShiftedTracks(const std::unordered_map<u_int, CellTracksBefore> &cellsBefore)
+{
+    std::vector<std::pair<const Track *, u_int>> shiftedCells; // old tracks begin and cell index
+    for (auto &cellBefore : cellsBefore)
+    {
+        if (cellBefore.second.count > 0 && cells[cellBefore.first].getTracksBegin() != cellBefore.second.begin)
+        {
+            shiftedCells.emplace_back(cellBefore.second.begin, cellBefore.first);
+            for (u_int t = 0; t < cellBefore.second.count; t++)
+            {
+                if (cellBefore.second.excluded[t])
+                    cells[cellBefore.first].getTrack(t).setAsExcluded();
+            }
+        }
     }
+    if (shiftedCells.empty())
+        return;
+
+    std::less<const Track *> addressLess;
+    std::sort(shiftedCells.begin(), shiftedCells.end(), [&addressLess](auto &a, auto &b)
+              { return addressLess(a.first, b.first); });
 
-    void getDataObjectsAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded, bool antiDuplicateBorder,
-                              std::function<void(VolumeCell &cell, float x, float y, float z, u_int XYdistance, u_int Zdistance)> callBackFunc)
+    auto relink = [&](Track *track) -> Track *
     {
-        // Create qubic search border that not go beyond the detector borders and get rid of negative coordinates
-        float objectX = x + coordinateCorrection;
-        float objectY = y + coordinateCorrection;
-        float objectZ = z; // Z is always positive
+        auto it = std::upper_bound(shiftedCells.begin(), shiftedCells.end(), track, [&addressLess](const Track *address, auto &shifted)
+                                   { return addressLess(address, shifted.first); });
+        if (it == shiftedCells.begin())
+            return track;
+        --it;
+        auto &cellBefore = cellsBefore.at(it->second);
+        if (addressLess(track, cellBefore.begin + cellBefore.count))
+            return &cells[it->second].getTrack(track - cellBefore.begin);
+        return track;
+    };
 
-        // -1 micron used because: 0 cell index is from x=0 to x=cellSize-1, than 1 cell index is from x=cellSize to... and so on
-        float Xmin = objectX - XYdistance < 0 ? 0 : objectX - XYdistance;
-        float Xmax = objectX + XYdistance >= volumeDim - 1 ? volumeDim - 1 : objectX + XYdistance;
+    for (auto &cell : cells)
+    {
+        for (u_int v = 0; v < cell.getVertexesCount(); v++)
+        {
+            cell.getVertex(v).relinkTracks(relink);
+        }
+    }
+}
 
-        float Ymin = objectY - XYdistance < 0 ? 0 : objectY - XYdistance;
-        float Ymax = objectY + XYdistance >= volumeDim ? volumeDim - 1 : objectY + XYdistance;
+void DetectorVolume::markCellAsDirty(u_int cellInd)
+{
+    if (!cellIsDirty[cellInd])
+    {
+        cellIsDirty[cellInd] = true;
+        dirtyCells.push_back(cellInd);
+    }
+}
 
-        float Zmin = objectZ - Zdistance < 0 ? 0 : objectZ - Zdistance;
-        float Zmax = objectZ + Zdistance >= volumeDim ? volumeDim - 1 : objectZ + Zdistance;
+void DetectorVolume::testBordersFit(float x, float y, float z)
+{
+    if (std::abs(x) > coordinateCorrection || std::abs(y) > coordinateCorrection || z < windowZBegin || z > windowZEnd ||
+        (z == windowZEnd && windowZEnd != volumeDim)) // window end is the begin of the reused layer
+    {
+        throw std::out_of_range("ERROR - at least one of the data coordinate goes beyond the detector borders.");
+    }
+}
 
-        float searchX, searchY, searchZ, algZmin;
+u_int DetectorVolume::getLinearCellIndex(float x, float y, float z)
+{
+    u_int X = (u_int)std::floor((x + coordinateCorrection) / cellDim);
+    u_int Y = (u_int)std::floor((y + coordinateCorrection) / cellDim);
+    u_int Z = (u_int)std::floor(z / cellDim);
+    if (Z >= windowLayers)
+        Z %= windowLayers;
 
-        float XYborder = std::sqrt(std::pow(XYdistance, 2) + std::pow(XYdistance, 2));
+    return Z * cellsInDim * cellsInDim + Y * cellsInDim + X;
+}
 
-        if (antiDuplicateBorder)
-        {
-            searchX = std::floor(objectX / cellDim) * cellDim;
-            searchY = std::floor(objectY / cellDim) * cellDim;
-            algZmin = searchZ = std::floor(objectZ / cellDim) * cellDim;
-        }
-        else
-        {
-            searchX = Xmin;
-            searchY = Ymin;
-            searchZ = Zmin;
-        }
+u_int DetectorVolume::getDataObjectsAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded, bool antiDuplicateBorder,
+                                           std::function<void(VolumeCell &cell, float x, float y, float z, u_int XYdistance, u_int Zdistance)> callBackFunc)
+{
+    u_int cellsVisited = 0;
+
+    // Create qubic search border that not go beyond the detector borders and get rid of negative coordinates
+    float objectX = x + coordinateCorrection;
+    float objectY = y + coordinateCorrection;
+    float objectZ = z; // Z is always positive
+
+    // -1 micron used because: 0 cell index is from x=0 to x=cellSize-1, than 1 cell index is from x=cellSize to... and so on
+    float Xmin = objectX - XYdistance < 0 ? 0 : objectX - XYdistance;
+    float Xmax = objectX + XYdistance >= volumeDim - 1 ? volumeDim - 1 : objectX + XYdistance;
+
+    float Ymin = objectY - XYdistance < 0 ? 0 : objectY - XYdistance;
+    float Ymax = objectY + XYdistance >= volumeDim ? volumeDim - 1 : objectY + XYdistance;
 
-        while (searchX <= Xmax)
+    float Zmin = objectZ - Zdistance < windowZBegin ? windowZBegin : objectZ - Zdistance;
+    float Zmax = objectZ + Zdistance >= windowZEnd ? windowZEnd - 1 : objectZ + Zdistance;
+
+    float searchX, searchY, searchZ, algZmin;
+
+    float XYborder = std::sqrt(std::pow(XYdistance, 2) + std::pow(XYdistance, 2));
+
+    if (antiDuplicateBorder)
+    {
+        searchX = std::floor(objectX / cellDim) * cellDim;
+        searchY = std::floor(objectY / cellDim) * cellDim;
+        algZmin = searchZ = std::floor(objectZ / cellDim) * cellDim;
+    }
+    else
+    {
+        searchX = Xmin;
+        searchY = Ymin;
+        searchZ = Zmin;
+    }
+
+    while (searchX <= Xmax)
+    {
+        while (searchY <= Ymax)
         {
-            while (searchY <= Ymax)
+            while (searchZ <= Zmax)
             {
-                while (searchZ <= Zmax)
-                {
-                    auto searchCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
-                    auto &searchCell = cells[searchCellInd];
-
-                    callBackFunc(searchCell, x, y, z, XYdistance, Zdistance);
-
-                    searchZ += cellDim;
-                    if (searchZ > Zmax)
-                    {
-                        searchZ = Zmax;
-                        auto nextCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
-                        if (nextCellInd == searchCellInd)
-                            break;
-                    }
-                }
                 auto searchCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
-                searchY += cellDim;
-                if (searchY > Ymax)
-                {
-                    searchY = Ymax;
+                auto &searchCell = cells[searchCellInd];
+
+                callBackFunc(searchCell, x, y, z, XYdistance, Zdistance);
+                cellsVisited++;
 
+                searchZ += cellDim;
+                if (searchZ > Zmax)
+                {
+                    searchZ = Zmax;
                     auto nextCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
                     if (nextCellInd == searchCellInd)
                         break;
-
-                    if (antiDuplicateBorder)
-                    {
-                        objectX - searchX >= 0 ? searchZ = algZmin : searchZ = Zmin;
-                    }
-                    else
-                    {
-                        searchZ = Zmin;
-                    }
-                }
-                else
-                {
-                    searchZ = Zmin;
                 }
             }
             auto searchCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
-            searchX += cellDim;
-            if (searchX > Xmax)
+            searchY += cellDim;
+            if (searchY > Ymax)
             {
-                searchX = Xmax;
+                searchY = Ymax;
 
                 auto nextCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
                 if (nextCellInd == searchCellInd)
                     break;
 
-                searchZ = Zmin;
-                searchY = Ymin;
+                if (antiDuplicateBorder)
+                {
+                    objectX - searchX >= 0 ? searchZ = algZmin : searchZ = Zmin;
+                }
+                else
+                {
+                    searchZ = Zmin;
+                }
             }
             else
             {
                 searchZ = Zmin;
-                searchY = Ymin;
             }
         }
-    }
+        auto searchCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
+        searchX += cellDim;
+        if (searchX > Xmax)
+        {
+            searchX = Xmax;
 
-} // ================================== end of file private namespace ==========================================
+            auto nextCellInd = getLinearCellIndex(searchX - coordinateCorrection, searchY - coordinateCorrection, searchZ);
+            if (nextCellInd == searchCellInd)
+                break;
+
+            searchZ = Zmin;
+            searchY = Ymin;
+        }
+        else
+        {
+            searchZ = Zmin;
+            searchY = Ymin;
+        }
+    }
+    return cellsVisited;
+}
 
 void DetectorVolume::addTracks(std::vector<Track> &unsortedTracks) // copy
 {
+    std::unordered_map<u_int, CellTracksBefore> cellsBefore;
     for (Track &track : unsortedTracks)
     {
         testBordersFit(track.getX(), track.getY(), track.getZ());
 
         auto cellInd = getLinearCellIndex(track.getX(), track.getY(), track.getZ());
         auto &cell = cells[cellInd];
+        if (vertexesCount > 0)
+            rememberCellTracks(cellsBefore, cellInd);
         cell.addTrack(track);
+        markCellAsDirty(cellInd);
         tracksCount++;
     }
+    relinkShiftedTracks(cellsBefore);
 }
 
 void DetectorVolume::addTracks(std::vector<Track> &&unsortedTracks) // move
 {
+    std::unordered_map<u_int, CellTracksBefore> cellsBefore;
     for (Track &track : unsortedTracks)
     {
         testBordersFit(track.getX(), track.getY(), track.getZ());
 
         auto cellInd = getLinearCellIndex(track.getX(), track.getY(), track.getZ());
         auto &cell = cells[cellInd];
+        if (vertexesCount > 0)
+            rememberCellTracks(cellsBefore, cellInd);
         cell.addTrack(std::move(track));
+        markCellAsDirty(cellInd);
         tracksCount++;
     }
+    relinkShiftedTracks(cellsBefore);
 }
 
 void DetectorVolume::addNewUnindexedVertex(Vertex &vertex)
@@ -226,7 +378,7 @@ bool DetectorVolume::checkVertexPresenceByCoordinates(float x, float y, float z)
 
 bool DetectorVolume::checkDataObjectInDetectorBounds(DataObject &object)
 {
-    if (std::abs(object.getX()) < coordinateCorrection && std::abs(object.getY()) < coordinateCorrection && object.getZ() < volumeDim && object.getZ() >= 0)
+    if (std::abs(object.getX()) < coordinateCorrection && std::abs(object.getY()) < coordinateCorrection && object.getZ() < windowZEnd && object.getZ() >= windowZBegin)
     {
         return true;
     }
@@ -287,11 +439,82 @@ std::vector<Vertex *> DetectorVolume::getAllVertexes()
     return vertexes;
 }
 
+std::vector<Track *> DetectorVolume::getTracksFromDirtyCells()
+{
+    std::vector<Track *> objectsToReturn;
+    for (auto c : dirtyCells)
+    {
+        auto &cell = cells[c];
+        for (u_int t = 0; t < cell.getTracksCount(); t++)
+        {
+            objectsToReturn.emplace_back(&cell.getTrack(t));
+        }
+    }
+    return objectsToReturn;
+}
+
+u_int DetectorVolume::getDirtyCellsCount()
+{
+    return dirtyCells.size();
+}
+
+void DetectorVolume::clearDirtyCells()
+{
+    for (auto c : dirtyCells)
+    {
+        cellIsDirty[c] = false;
+    }
+    dirtyCells.clear();
+}
+
 u_int DetectorVolume::getVolumeDimension()
 {
     return volumeDim;
 }
 
+u_int DetectorVolume::getCellDimension()
+{
+    return cellDim;
+}
+
+float DetectorVolume::getWindowZBegin()
+{
+    return windowZBegin;
+}
+
+float DetectorVolume::getWindowZEnd()
+{
+    return windowZEnd;
+}
+
+void DetectorVolume::releaseCellsBelowZ(float z)
+{
+    while (windowZBegin + cellDim <= z && windowZBegin < volumeDim)
+    {
+        u_int layer = (u_int)std::floor(windowZBegin / cellDim) % windowLayers;
+        u_int layerBegin = layer * cellsInDim * cellsInDim;
+        u_int layerEnd = layerBegin + cellsInDim * cellsInDim;
+
+        for (u_int c = layerBegin; c < layerEnd; c++)
+        {
+            auto &cell = cells[c];
+            tracksCount -= cell.getTracksCount();
+            vertexesCount -= cell.getVertexesCount();
+            cell.clear();
+        }
+        if (!dirtyCells.empty())
+        {
+            dirtyCells.erase(std::remove_if(dirtyCells.begin(), dirtyCells.end(), [layerBegin, layerEnd](u_int c)
+                                            { return c >= layerBegin && c < layerEnd; }),
+                             dirtyCells.end());
+            std::fill(cellIsDirty.begin() + layerBegin, cellIsDirty.begin() + layerEnd, false);
+        }
+
+        windowZBegin += cellDim;
+        windowZEnd = std::min<float>(windowZBegin + windowLayers * cellDim, volumeDim);
+    }
+}
+
 bool DetectorVolume::deleteVertex(u_long index, float x, float y, float z)
 {
     auto cellInd = getLinearCellIndex(x, y, z);
@@ -299,14 +522,210 @@ bool DetectorVolume::deleteVertex(u_long index, float x, float y, float z)
     return cell.deleteVertex(index);
 }
 
+void DetectorVolume::writeSnapshot(const std::string &fileName)
+{
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.volumeDim = volumeDim;
+    header.cellDim = cellDim;
+    header.windowLayers = windowLayers;
+    header.windowZBegin = windowZBegin;
+    header.windowZEnd = windowZEnd;
+    header.vertexUniqueIndex = vertexUniqueIndex;
+    header.cellsCount = cellsCount;
+    header.dirtyCellsCount = dirtyCells.size();
+
+    std::vector<uint32_t> cellsTracksCounts(cellsCount), cellsVertexesCounts(cellsCount);
+    std::vector<TrackRecord> tracks;
+    std::vector<CellTracksRange> tracksRanges;
+    tracks.reserve(tracksCount);
+    for (u_int c = 0; c < cellsCount; c++)
+    {
+        auto &cell = cells[c];
+        cellsTracksCounts[c] = cell.getTracksCount();
+        cellsVertexesCounts[c] = cell.getVertexesCount();
+        if (cell.getTracksCount() > 0)
+            tracksRanges.push_back(CellTracksRange{cell.getTracksBegin(), cell.getTracksCount(), tracks.size()});
+
+        for (u_int t = 0; t < cell.getTracksCount(); t++)
+        {
+            auto &track = cell.getTrack(t);
+            tracks.push_back(TrackRecord{track.getIndex(), track.getX(), track.getY(), track.getZ(), track.getTanX(), track.getTanY(),
+                                         track.getTanZ(), (uint32_t)track.getSegmentsCount(), track.isExcluded()});
+        }
+    }
+    std::less<const Track *> addressLess;
+    std::sort(tracksRanges.begin(), tracksRanges.end(), [&addressLess](auto &a, auto &b)
+              { return addressLess(a.begin, b.begin); });
+
+    std::vector<VertexRecord> vertexes;
+    std::vector<uint64_t> tracksReferences;
+    for (auto &cell : cells)
+    {
+        for (u_int v = 0; v < cell.getVertexesCount(); v++)
+        {
+            auto &vertex = cell.getVertex(v);
+            vertexes.push_back(VertexRecord{vertex.getIndex(), vertex.getX(), vertex.getY(), vertex.getZ(), vertex.getDaughterTracksCount(),
+                                            vertex.getParentTracksCount(), vertex.indexIsInited(), vertex.isExcluded(), {}});
+            for (u_int t = 0; t < vertex.getDaughterTracksCount(); t++)
+                tracksReferences.push_back(findTrackNumber(tracksRanges, vertex.getDaughterTrack(t)));
+            for (u_int t = 0; t < vertex.getParentTracksCount(); t++)
+                tracksReferences.push_back(findTrackNumber(tracksRanges, vertex.getParentTrack(t)));
+        }
+    }
+    header.tracksCount = tracks.size();
+    header.vertexesCount = vertexes.size();
+    header.tracksReferencesCount = tracksReferences.size();
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("ERROR - could not create detector volume snapshot " + fileName);
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeSnapshotSection(file, cellsTracksCounts);
+    writeSnapshotSection(file, cellsVertexesCounts);
+    writeSnapshotSection(file, tracks);
+    writeSnapshotSection(file, vertexes);
+    writeSnapshotSection(file, tracksReferences);
+    writeSnapshotSection(file, std::vector<uint32_t>(dirtyCells.begin(), dirtyCells.end()));
+    if (!file.good())
+    {
+        throw std::runtime_error("ERROR in detector volume snapshot writing " + fileName);
+    }
+}
+
+std::unique_ptr<DetectorVolume> DetectorVolume::restoreSnapshot(const std::string &fileName)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("ERROR - could not open detector volume snapshot " + fileName);
+    }
+    uint64_t fileSize = file.tellg();
+    file.seekg(0);
+
+    SnapshotHeader header = {};
+    if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION)
+    {
+        throw std::invalid_argument("ERROR - file " + fileName + " is not a detector volume snapshot of version " + std::to_string(SNAPSHOT_VERSION) + ".");
+    }
+    uint64_t expectedSize = sizeof(header) + header.cellsCount * 2 * sizeof(uint32_t) + header.tracksCount * sizeof(TrackRecord) +
+                            header.vertexesCount * sizeof(VertexRecord) +
+                            header.tracksReferencesCount * sizeof(uint64_t) + header.dirtyCellsCount * sizeof(uint32_t);
+    if (header.cellDim == 0 || header.windowLayers == 0 || fileSize != expectedSize)
+    {
+        throw std::invalid_argument("ERROR - detector volume snapshot " + fileName + " is truncated or has wrong sections sizes.");
+    }
+
+    auto volume = std::make_unique<DetectorVolume>(header.volumeDim, header.cellDim, header.windowLayers * header.cellDim);
+    if (header.cellsCount != volume->cellsCount)
+    {
+        throw std::invalid_argument("ERROR - detector volume snapshot " + fileName + " has wrong cells count.");
+    }
+    volume->windowZBegin = header.windowZBegin;
+    volume->windowZEnd = header.windowZEnd;
+    volume->vertexUniqueIndex = header.vertexUniqueIndex;
+
+    std::vector<uint32_t> cellsTracksCounts, cellsVertexesCounts, restoredDirtyCells;
+    std::vector<TrackRecord> tracks;
+    std::vector<VertexRecord> vertexes;
+    std::vector<uint64_t> tracksReferences;
+    readSnapshotSection(file, cellsTracksCounts, header.cellsCount);
+    readSnapshotSection(file, cellsVertexesCounts, header.cellsCount);
+    readSnapshotSection(file, tracks, header.tracksCount);
+    readSnapshotSection(file, vertexes, header.vertexesCount);
+    readSnapshotSection(file, tracksReferences, header.tracksReferencesCount);
+    readSnapshotSection(file, restoredDirtyCells, header.dirtyCellsCount);
+    if (!file.good())
+    {
+        throw std::runtime_error("ERROR in detector volume snapshot reading " + fileName);
+    }
+
+    auto corrupted = [&fileName]()
+    {
+        return std::invalid_argument("ERROR - detector volume snapshot " + fileName + " has inconsistent sections.");
+    };
+
+    // all tracks are stored before vertexes are linked, so tracks pointers do not change
+    std::vector<Track *> tracksByNumber;
+    tracksByNumber.reserve(tracks.size());
+    for (u_int c = 0; c < volume->cellsCount; c++)
+    {
+        auto &cell = volume->cells[c];
+        if (tracksByNumber.size() + cellsTracksCounts[c] > tracks.size())
+            throw corrupted();
+        cell.reserve(cellsTracksCounts[c], cellsVertexesCounts[c]);
+
+        for (u_int t = 0; t < cellsTracksCounts[c]; t++)
+        {
+            auto &record = tracks[tracksByNumber.size()];
+            Track track(record.index, record.X, record.Y, record.Z, record.tanX, record.tanY, record.tanZ);
+            track.addPlaceholderSegments(record.segmentsCount);
+            cell.addTrack(std::move(track));
+            if (record.excluded)
+                cell.getTrack(t).setAsExcluded(); // exclusion is not moved with the track
+            tracksByNumber.push_back(&cell.getTrack(t));
+        }
+    }
+
+    size_t vertexNumber = 0, referenceNumber = 0;
+    auto referencedTrack = [&]()
+    {
+        if (referenceNumber >= tracksReferences.size() || tracksReferences[referenceNumber] >= tracksByNumber.size())
+            throw corrupted();
+        return tracksByNumber[tracksReferences[referenceNumber++]];
+    };
+    for (u_int c = 0; c < volume->cellsCount; c++)
+    {
+        auto &cell = volume->cells[c];
+        if (vertexNumber + cellsVertexesCounts[c] > vertexes.size())
+            throw corrupted();
+
+        for (u_int v = 0; v < cellsVertexesCounts[c]; v++)
+        {
+            auto &record = vertexes[vertexNumber++];
+            Vertex vertex(record.X, record.Y, record.Z);
+            if (record.indexInited)
+                vertex.setIndex(record.index);
+            for (u_int t = 0; t < record.daughtersCount; t++)
+                vertex.addDaughterTrack(referencedTrack());
+            for (u_int t = 0; t < record.parentsCount; t++)
+                vertex.addParentTrack(referencedTrack());
+            cell.addVertex(vertex);
+            if (record.excluded)
+                cell.getVertex(v).setAsExcluded(); // exclusion is not copied with the vertex
+        }
+    }
+    if (tracksByNumber.size() != tracks.size() || vertexNumber != vertexes.size() ||
+        referenceNumber != tracksReferences.size())
+    {
+        throw corrupted();
+    }
+    volume->tracksCount = tracks.size();
+    volume->vertexesCount = vertexes.size();
+
+    for (auto cellInd : restoredDirtyCells)
+    {
+        if (cellInd >= volume->cellsCount)
+            throw corrupted();
+        volume->markCellAsDirty(cellInd);
+    }
+    return volume;
+}
+
 std::vector<Track *> DetectorVolume::getTracksAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded, bool antiDuplicateBorder)
 {
     testBordersFit(x, y, z);
 
     std::vector<Track *> objectsToReturn;
+    u_long candidatesCount = 0;
 
-    auto getObjectsLambda = [&objectsToReturn](VolumeCell &searchCell, float x, float y, float z, u_int XYdistance, u_int Zdistance)
+    auto getObjectsLambda = [&objectsToReturn, &candidatesCount](VolumeCell &searchCell, float x, float y, float z, u_int XYdistance, u_int Zdistance)
     {
+        candidatesCount += searchCell.getTracksCount();
         for (size_t i = 0; i < searchCell.getTracksCount(); i++)
         {
             auto &obj = searchCell.getTrack(i);
@@ -323,7 +742,9 @@ std::vector<Track *> DetectorVolume::getTracksAround(float x, float y, float z,
         }
     };
 
-    getDataObjectsAround(x, y, z, XYdistance, Zdistance, withOutExcluded, antiDuplicateBorder, getObjectsLambda);
+    auto cellsVisited = getDataObjectsAround(x, y, z, XYdistance, Zdistance, withOutExcluded, antiDuplicateBorder, getObjectsLambda);
+    if (indexStatistics)
+        indexStatistics->trackQueries.addQuery(cellsVisited, candidatesCount, objectsToReturn.size());
     return objectsToReturn;
 }
 
@@ -332,9 +753,11 @@ std::vector<Vertex *> DetectorVolume::getVertexesAround(float x, float y, float
     testBordersFit(x, y, z);
 
     std::vector<Vertex *> objectsToReturn;
+    u_long candidatesCount = 0;
 
-    auto getObjectsLambda = [&objectsToReturn](VolumeCell &searchCell, float x, float y, float z, u_int XYdistance, u_int Zdistance)
+    auto getObjectsLambda = [&objectsToReturn, &candidatesCount](VolumeCell &searchCell, float x, float y, float z, u_int XYdistance, u_int Zdistance)
     {
+        candidatesCount += searchCell.getVertexesCount();
         for (size_t i = 0; i < searchCell.getVertexesCount(); i++)
         {
             auto &obj = searchCell.getVertex(i);
@@ -351,11 +774,53 @@ std::vector<Vertex *> DetectorVolume::getVertexesAround(float x, float y, float
         }
     };
 
-    getDataObjectsAround(x, y, z, XYdistance, Zdistance, withOutExcluded, antiDuplicateBorder, getObjectsLambda);
+    auto cellsVisited = getDataObjectsAround(x, y, z, XYdistance, Zdistance, withOutExcluded, antiDuplicateBorder, getObjectsLambda);
+    if (indexStatistics)
+        indexStatistics->vertexQueries.addQuery(cellsVisited, candidatesCount, objectsToReturn.size());
     return objectsToReturn;
 }
 
-DetectorVolume::DetectorVolume(u_int volumeDimension, u_int cellDimension)
+void DetectorVolume::setIndexStatisticsEnabled(bool enabled)
+{
+    indexStatistics = enabled ? std::make_unique<IndexStatistics>() : nullptr;
+}
+
+void DetectorVolume::reportIndexStatistics()
+{
+    if (!indexStatistics)
+        return;
+
+    Log2Histogram tracksPerCell;
+    u_long emptyCells = 0, storedTracks = 0; // window cells only
+    for (auto &cell : cells)
+    {
+        tracksPerCell.add(cell.getTracksCount());
+        emptyCells += cell.getTracksCount() == 0;
+        storedTracks += cell.getTracksCount();
+    }
+
+    auto &trackQueries = indexStatistics->trackQueries;
+    auto perQuery = [&trackQueries](u_long total)
+    { return trackQueries.queries == 0 ? 0.0 : (double)total / trackQueries.queries; };
+    printf("Index: cell size %u microns, %lu cells, %.1f%% empty, %.2f tracks per occupied cell. \n", cellDim, cells.size(),
+           100.0 * emptyCells / cells.size(), emptyCells == cells.size() ? 0.0 : (double)storedTracks / (cells.size() - emptyCells));
+    printf("Index: %lu tracks queries, per query %.1f cells visited, %.1f candidates, %.1f accepted. \n", trackQueries.queries,
+           perQuery(trackQueries.cellsVisited), perQuery(trackQueries.candidates), perQuery(trackQueries.accepted));
+
+    auto &metrics = getMetrics();
+    metrics.setGauge("index.cellSize", cellDim); // volume state, reported again by every search of the volume
+    metrics.setGauge("index.cells", cells.size());
+    metrics.setGauge("index.emptyCells", emptyCells);
+    tracksPerCell.addToMetrics("index.tracksPerCell");
+    trackQueries.addToMetrics("index.trackQueries");
+    indexStatistics->vertexQueries.addToMetrics("index.vertexQueries");
+}
+
+DetectorVolume::DetectorVolume(u_int volumeDimension, u_int cellDimension) : DetectorVolume(volumeDimension, cellDimension, volumeDimension)
+{
+}
+
+DetectorVolume::DetectorVolume(u_int volumeDimension, u_int cellDimension, u_int windowDepth)
 {
     if (volumeDimension % cellDimension != 0)
     {
@@ -364,12 +829,21 @@ DetectorVolume::DetectorVolume(u_int volumeDimension, u_int cellDimension)
     volumeDim = volumeDimension;
     cellDim = cellDimension;
     cellsInDim = volumeDim / cellDim;
-    cellsCount = cellsInDim * cellsInDim * cellsInDim;
+    windowLayers = std::min(cellsInDim, (windowDepth + cellDim - 1) / cellDim);
+    if (windowLayers == 0)
+    {
+        std::__throw_invalid_argument("ERROR arguments: windowDepth must be positive!");
+    }
+    cellsCount = cellsInDim * cellsInDim * windowLayers;
+    windowZBegin = 0;
+    windowZEnd = windowLayers * cellDim;
 
     // Move the coordinate system to get rid of negative XY coordinates, Z is always positive.
     coordinateCorrection = volumeDim / 2;
 
     cells.resize(cellsCount);
+    cellIsDirty.assign(cellsCount, false);
+    dirtyCells.clear();
 
     // posix_memalign((void **)cellsArray, CELL_ALIGNMENT, cellsCount * sizeof(VolumeCell));
     // for (size_t i = 0; i < cellsCount; i++)
@@ -4,9 +4,15 @@
 #include "../data_types/Track.hpp"
 #include "../data_types/Vertex.hpp"
 
+#include "IndexStatistics.hpp"
 #include "VolumeCell.hpp"
 
+#include <functional>
+#include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <type_traits>
 
 /**
@@ -20,16 +26,62 @@
 class DetectorVolume
 {
 private:
+    std::vector<VolumeCell> cells; // Cells storing all the data objects
+
+    u_int volumeDim = 0, cellDim = 0, cellsInDim = 0, cellsCount = 0, coordinateCorrection = 0;
+
+    // Only windowLayers of cells Z layers are stored, they are reused as ring buffer when the window moves along Z.
+    // For the whole volume window is [0, volumeDim] with windowLayers == cellsInDim.
+    u_int windowLayers = 0;
+    float windowZBegin = 0, windowZEnd = 0;
+
+    u_long vertexUniqueIndex = 0;
     u_long tracksCount = 0, vertexesCount = 0;
 
+    std::vector<u_int> dirtyCells; // cells got new tracks since the last search
+    std::vector<bool> cellIsDirty;
+
+    std::unique_ptr<IndexStatistics> indexStatistics; // null unless enabled
+
+    /* Tracks storage of the cell as it was before adding new tracks. */
+    struct CellTracksBefore
+    {
+        const Track *begin;
+        u_int count;
+        std::vector<bool> excluded; // exclusion is not moved with the track
+    };
+
+    /* Remember tracks storage of the cell before the first new track is added to it. */
+    void rememberCellTracks(std::unordered_map<u_int, CellTracksBefore> &cellsBefore, u_int cellInd);
+
+    /* Vertexes keep pointers to tracks, when cell tracks storage grows, tracks are moved to another address.
+    Every pointer to the moved tracks is replaced by pointer to the same track at its new place, exclusion of the moved tracks is restored. */
+    void relinkShiftedTracks(const std::unordered_map<u_int, CellTracksBefore> &cellsBefore);
+
+    void markCellAsDirty(u_int cellInd);
+
+    void testBordersFit(float x, float y, float z);
+
+    /* Calls callBackFunc for every cell intersecting the search box, returns count of the visited cells. */
+    u_int getDataObjectsAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded, bool antiDuplicateBorder,
+                               std::function<void(VolumeCell &cell, float x, float y, float z, u_int XYdistance, u_int Zdistance)> callBackFunc);
+
 public:
     /**
-     * @brief Download tracks to detector with copying.
+     * @brief Each data (vertex, track and so on) is stored in it's corresponding spatial cell.
+     * Correspondance is defined by data coordinates, cell coordinates and cell dimension.
+     */
+    u_int getLinearCellIndex(float x, float y, float z);
+
+    /**
+     * @brief Download tracks to detector with copying. Cells got tracks are marked as dirty for incremental search.
+     * Tracks pointers stored by vertexes are updated if tracks were shifted in memory.
      */
     void addTracks(std::vector<Track> &unsortedTracks);
 
     /**
-     * @brief Download tracks to detector with moving.
+     * @brief Download tracks to detector with moving. Cells got tracks are marked as dirty for incremental search.
+     * Tracks pointers stored by vertexes are updated if tracks were shifted in memory.
      */
     void addTracks(std::vector<Track> &&unsortedTracks);
 
@@ -64,25 +116,81 @@ public:
      */
     std::vector<Vertex *> getAllVertexes();
 
+    /**
+     *  @brief Get all the tracks from the cells, which got new tracks since dirty cells were cleared last time.
+     */
+    std::vector<Track *> getTracksFromDirtyCells();
+
+    u_int getDirtyCellsCount();
+
+    /**
+     *  @brief Forget changed cells, called when search has processed all the tracks.
+     */
+    void clearDirtyCells();
+
     u_long getTracksCount() { return tracksCount; }
 
     u_long getVertexesCount() { return vertexesCount; }
 
     u_int getVolumeDimension();
 
+    u_int getCellDimension();
+
+    /** @return Z of the lowest stored cells layer, moves up when cells are released. */
+    float getWindowZBegin();
+
+    /** @return Z of the window end, objects could be added only in [getWindowZBegin, getWindowZEnd). */
+    float getWindowZEnd();
+
+    /**
+     *  @brief Remove all the tracks and vertexes from cells layers lying fully below z and free their memory.
+     * Window moves up and released layers are reused for the next Z range.
+     * @warning All pointers to released objects become invalid.
+     */
+    void releaseCellsBelowZ(float z);
+
     bool deleteVertex(u_long index, float x, float y, float z);
 
+    /**
+     *  @brief Write binary snapshot of the volume: cells tracks with segments count and exclusion state, vertexes with daughter and parent
+     * tracks references, dirty cells and the Z window. Objects are written as plain records per section, so restoring is a few reads.
+     * @throws std::runtime_error if file could not be written, std::logic_error if vertex references track outside of the volume.
+     */
+    void writeSnapshot(const std::string &fileName);
+
+    /**
+     *  @brief Create the volume from snapshot written by writeSnapshot, search could continue from the state it was written at.
+     * @throws std::runtime_error if file could not be read, std::invalid_argument if it is not a snapshot of this version.
+     */
+    static std::unique_ptr<DetectorVolume> restoreSnapshot(const std::string &fileName);
+
     /**
      *  @brief Get tracks from the selected sphere.
      * @warning If some object will be added or removed from the detector, this vector of pointers will become invalid! Object addreses becomes shifted.
      */
-    std::vector<Track *> getTracksAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool antiDuplicateBorder = false, bool withOutExcluded = true);
+    std::vector<Track *> getTracksAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded = true, bool antiDuplicateBorder = false);
 
     /**
      *  @brief Get vertexes from the selected sphere.
      * @warning If some object will be added or removed from the detector, this vector of pointers will become invalid! Object addreses becomes shifted.
      */
-    std::vector<Vertex *> getVertexesAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool antiDuplicateBorder = false, bool withOutExcluded = true);
+    std::vector<Vertex *> getVertexesAround(float x, float y, float z, u_int XYdistance, u_int Zdistance, bool withOutExcluded = true, bool antiDuplicateBorder = false);
+
+    /**
+     *  @brief Collect spatial index statistics for tuning the cell size: cells visited, objects stored in them (candidates) and objects
+     * within distance (accepted) for every tracks and vertexes query. Off by default, when enabled costs a few increments per query.
+     * Enabling again resets the collected statistics.
+     */
+    void setIndexStatisticsEnabled(bool enabled);
+
+    /** @return collected statistics, nullptr if they are not enabled. */
+    const IndexStatistics *getIndexStatistics() const { return indexStatistics.get(); }
+
+    /**
+     *  @brief Print cells occupancy and queries cost, and add them to the metrics registry: index.cellSize, index.cells, index.emptyCells,
+     * index.tracksPerCell histogram and index.trackQueries / index.vertexQueries counters and histograms. Does nothing if not enabled.
+     */
+    void reportIndexStatistics();
 
 public:
     /**
@@ -91,6 +199,12 @@ public:
      */
     DetectorVolume(u_int volumeDimension, u_int cellDimension);
 
+    /**
+     *  @brief Create detector's volume object storing only the Z window of windowDepth (rounded up to cells) instead of the whole volume.
+     * Window starts at Z=0 and is moved along Z by releaseCellsBelowZ, so memory depends on window depth, not on volume depth.
+     */
+    DetectorVolume(u_int volumeDimension, u_int cellDimension, u_int windowDepth);
+
     virtual ~DetectorVolume(){};
 
     DetectorVolume(const DetectorVolume &) = delete;
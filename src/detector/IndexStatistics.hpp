@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../utility/Metrics.hpp"
+
+#include <array>
+#include <string>
+#include <sys/types.h>
+
+/**
+ * @brief Histogram with power of two buckets: bucket 0 counts zeros, bucket b counts values in [2^(b-1), 2^b).
+ * Adding a value is a count of leading zeros and an increment.
+ */
+struct Log2Histogram
+{
+    std::array<u_long, 65> buckets{};
+
+    void add(u_long value) { buckets[value == 0 ? 0 : 64 - __builtin_clzl(value)]++; }
+
+    /** @brief Add non-empty buckets to the metrics registry as counters <name>.<first value>-<last value>. */
+    void addToMetrics(const std::string &name) const
+    {
+        for (size_t b = 0; b < buckets.size(); b++)
+        {
+            if (buckets[b] == 0)
+                continue;
+            u_long first = b == 0 ? 0 : 1ul << (b - 1);
+            u_long last = b == 0 ? 0 : first * 2 - 1;
+            getMetrics().addCount(name + "." + std::to_string(first) + (first == last ? "" : "-" + std::to_string(last)), buckets[b]);
+        }
+    }
+};
+
+/** @brief Cost of the spatial queries of one kind: cells visited, objects stored in them (candidates) and objects within distance. */
+struct QueryStatistics
+{
+    u_long queries = 0, cellsVisited = 0, candidates = 0, accepted = 0;
+    Log2Histogram cellsPerQuery, candidatesPerQuery, acceptedPerQuery;
+
+    void addQuery(u_long cells, u_long candidatesCount, u_long acceptedCount)
+    {
+        queries++;
+        cellsVisited += cells;
+        candidates += candidatesCount;
+        accepted += acceptedCount;
+        cellsPerQuery.add(cells);
+        candidatesPerQuery.add(candidatesCount);
+        acceptedPerQuery.add(acceptedCount);
+    }
+
+    void addToMetrics(const std::string &name) const
+    {
+        auto &metrics = getMetrics();
+        metrics.addCount(name + ".queries", queries);
+        metrics.addCount(name + ".cellsVisited", cellsVisited);
+        metrics.addCount(name + ".candidates", candidates);
+        metrics.addCount(name + ".accepted", accepted);
+        cellsPerQuery.addToMetrics(name + ".cellsPerQuery");
+        candidatesPerQuery.addToMetrics(name + ".candidatesPerQuery");
+        acceptedPerQuery.addToMetrics(name + ".acceptedPerQuery");
+    }
+};
+
+/** @brief Spatial index statistics of the detector volume, collected only when enabled. */
+struct IndexStatistics
+{
+    QueryStatistics trackQueries, vertexQueries;
+};
@@ -38,6 +38,23 @@ public:
         return false;
     }
 
+    /** @brief Reserve storage, so adding up to these counts does not move stored objects. */
+    void reserve(u_int tracksCount, u_int vertexesCount)
+    {
+        tracks.reserve(tracksCount);
+        vertexes.reserve(vertexesCount);
+    }
+
+    /** @brief Remove all stored objects and free their memory. */
+    void clear()
+    {
+        std::vector<Track>().swap(tracks);
+        std::vector<Vertex>().swap(vertexes);
+    }
+
+    /** @brief Address of the first stored Track, it changes when tracks storage grows. */
+    const Track *getTracksBegin() const { return tracks.data(); }
+
     /** @brief Get Track by its stored number. */
      Track &getTrack(u_int number) { return tracks.at(number); }
 
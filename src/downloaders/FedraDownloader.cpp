@@ -1,4 +1,5 @@
 #include "FedraDownloader.hpp"
+#include "NativeTrackFile.hpp"
 
 #include <TTree.h>
 #include <TEventList.h>
@@ -6,12 +7,328 @@
 #include <TTreeReader.h>
 #include <TTreeReaderValue.h>
 #include <TClonesArray.h>
+#include <TROOT.h>
 #include <Rtypes.h>
+#include <RConfigure.h>
+#ifdef R__USE_IMT
+#include <ROOT/TTreeProcessorMT.hxx>
+#endif
 
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <utility>
+#include <atomic>
+#include <charconv>
+#include <thread>
+
+namespace
+{
+    const u_int TRACK_SEGMENTS_COUNT = 30; // placeholder segments of every track read from file
+
+    Track createTrack(u_long index, Float_t X, Float_t Y, Float_t Z, Float_t tanX, Float_t tanY)
+    {
+        Track track(index, X, Y, Z, tanX, tanY);
+        track.addPlaceholderSegments(TRACK_SEGMENTS_COUNT);
+        return track;
+    }
+
+    /* Prefilter the chunk columns, then create Track objects of the passed tracks and of the rejected ones after them if they are requested. */
+    void sendTracksChunk(TrackColumns &chunkColumns, const ColumnsPartition &partition, bool createRejected, const TracksSink &chunkCallBack)
+    {
+        size_t passedCount = partition ? partition(chunkColumns) : chunkColumns.size();
+        size_t count = createRejected ? chunkColumns.size() : passedCount;
+        std::vector<Track> chunk;
+        chunk.reserve(count);
+        for (size_t t = 0; t < count; t++)
+        {
+            chunk.push_back(createTrack(chunkColumns.getIndex(t), chunkColumns.X[t], chunkColumns.Y[t], chunkColumns.Z[t], chunkColumns.tanX[t],
+                                        chunkColumns.tanY[t]));
+        }
+        chunkCallBack(std::move(chunk), passedCount);
+    }
+
+    /* Copy the columns range to the chunk columns, the caller fills their index column. */
+    void copyColumnsRange(const float *X, const float *Y, const float *Z, const float *tanX, const float *tanY, size_t begin, size_t end,
+                          TrackColumns &chunkColumns)
+    {
+        chunkColumns.X.assign(X + begin, X + end);
+        chunkColumns.Y.assign(Y + begin, Y + end);
+        chunkColumns.Z.assign(Z + begin, Z + end);
+        chunkColumns.tanX.assign(tanX + begin, tanX + end);
+        chunkColumns.tanY.assign(tanY + begin, tanY + end);
+    }
+
+    const size_t TEXT_BLOCK_VERTEXES = 1024;   // vertexes formatted by one task into one buffer
+    const size_t TEXT_CHUNK_BLOCKS = 64;       // blocks formatted in parallel before writing them, limits buffers memory
+
+    void appendInteger(std::string &buffer, u_long value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+        buffer.push_back(' ');
+    }
+
+    /* Number with 6 decimals truncated to 2 decimals, the format processed vertexes files always had. */
+    void appendCoordinate(std::string &buffer, float value)
+    {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+        auto point = std::find(digits, result.ptr, '.');
+        buffer.append(digits, std::min(point + 3, result.ptr));
+        buffer.push_back(' ');
+    }
+
+    /* Vertex line, its daughter tracks lines and empty line after them. */
+    void formatVertex(std::string &buffer, Vertex *vertex)
+    {
+        bool secondary = vertex->getParentTracksCount() != 0; // decay vertex linked to the primary one by parent tracks
+
+        buffer.append(secondary ? "2ry_vtx " : "1ry_vtx ");
+        buffer.append("0 0 0 0 ");
+        appendInteger(buffer, vertex->getIndex());
+        size_t positionBegin = buffer.size();
+        appendCoordinate(buffer, vertex->getX());
+        appendCoordinate(buffer, vertex->getY());
+        appendCoordinate(buffer, vertex->getZ());
+        std::string position = buffer.substr(positionBegin);
+        buffer.append("0 0 ");
+        appendInteger(buffer, vertex->getDaughterTracksCount());
+        buffer.append("0 0 0 0 \n");
+
+        for (u_int t = 0; t < vertex->getDaughterTracksCount(); t++)
+        {
+            auto track = vertex->getDaughterTrack(t);
+
+            buffer.append(secondary ? "2ry_trk " : "1ry_trk ");
+            buffer.append("0 0 0 0 ");
+            appendInteger(buffer, vertex->getIndex());
+            buffer.append(position);
+            buffer.append("0 ");
+            appendInteger(buffer, vertex->getDaughterTracksCount());
+            buffer.append("0 0 0 ");
+            appendInteger(buffer, track->getIndex());
+            buffer.append("0 0 ");
+            appendCoordinate(buffer, track->getX());
+            appendCoordinate(buffer, track->getY());
+            appendCoordinate(buffer, track->getTanX());
+            appendCoordinate(buffer, track->getTanY());
+            appendInteger(buffer, track->getSegmentsCount());
+            buffer.append("0 0 0 0 0 0 \n");
+        }
+        buffer.push_back('\n');
+    }
+
+    /* Vertexes are formatted by blocks into separate buffers on threadsCount threads, then buffers are written in order,
+    one write per block. */
+    void writeVertexesText(std::ofstream &outFile, std::vector<Vertex *> &vertexes, size_t threadsCount)
+    {
+        size_t blocksCount = (vertexes.size() + TEXT_BLOCK_VERTEXES - 1) / TEXT_BLOCK_VERTEXES;
+        std::vector<std::string> buffers(std::min(blocksCount, TEXT_CHUNK_BLOCKS));
+
+        for (size_t chunkBegin = 0; chunkBegin < blocksCount; chunkBegin += TEXT_CHUNK_BLOCKS)
+        {
+            size_t chunkBlocks = std::min(blocksCount - chunkBegin, TEXT_CHUNK_BLOCKS);
+            std::atomic<size_t> nextBlock{0};
+            auto formatBlocks = [&]()
+            {
+                for (size_t b = nextBlock++; b < chunkBlocks; b = nextBlock++)
+                {
+                    auto &buffer = buffers[b];
+                    buffer.clear();
+                    size_t vertexesBegin = (chunkBegin + b) * TEXT_BLOCK_VERTEXES;
+                    size_t vertexesEnd = std::min(vertexesBegin + TEXT_BLOCK_VERTEXES, vertexes.size());
+                    for (size_t v = vertexesBegin; v < vertexesEnd; v++)
+                    {
+                        formatVertex(buffer, vertexes[v]);
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (size_t t = 1; t < std::min(threadsCount, chunkBlocks); t++)
+            {
+                threads.emplace_back(formatBlocks);
+            }
+            formatBlocks();
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+
+            for (size_t b = 0; b < chunkBlocks; b++)
+            {
+                outFile.write(buffers[b].data(), buffers[b].size());
+            }
+        }
+    }
+
+    using FloatColumn = std::pair<const char *, std::vector<Float_t> *>; // branch name and column to fill
+
+    /* Read the reader entries range into columns at the entries numbers. */
+    void readColumnsRange(TTreeReader &reader, const std::vector<FloatColumn> &columns)
+    {
+        std::vector<std::unique_ptr<TTreeReaderValue<Float_t>>> values;
+        for (auto &column : columns)
+        {
+            values.push_back(std::make_unique<TTreeReaderValue<Float_t>>(reader, column.first));
+        }
+
+        while (reader.Next())
+        {
+            auto entry = reader.GetCurrentEntry();
+            for (size_t c = 0; c < columns.size(); c++)
+            {
+                (*columns[c].second)[entry] = **values[c];
+            }
+        }
+    }
+
+    /* Tracks of the native file are created directly from the mapped columns, without an intermediate copy. */
+    void downloadNativeTracks(const std::string &fileName, std::vector<Track> &tracks)
+    {
+        MappedTrackFile trackFile(fileName);
+        const float *X = trackFile.getX(), *Y = trackFile.getY(), *Z = trackFile.getZ();
+        const float *tanX = trackFile.getTanX(), *tanY = trackFile.getTanY();
+        const uint64_t *index = trackFile.getIndex();
+
+        trackFile.prefetchTracks(0, trackFile.size(), true);
+        tracks.reserve(tracks.size() + trackFile.size());
+        for (size_t t = 0; t < trackFile.size(); t++)
+        {
+            tracks.push_back(createTrack(index[t], X[t], Y[t], Z[t], tanX[t], tanY[t]));
+        }
+    }
+
+    /* Only the cell ranges of the region are touched in the file sorted by cells, so the cost is proportional to the region. */
+    void downloadNativeTracksInRegion(const std::string &fileName, float minX, float maxX, float minY, float maxY, float minZ, float maxZ,
+                                      std::vector<Track> &tracks)
+    {
+        MappedTrackFile trackFile(fileName);
+        const float *X = trackFile.getX(), *Y = trackFile.getY(), *Z = trackFile.getZ();
+        const float *tanX = trackFile.getTanX(), *tanY = trackFile.getTanY();
+        const uint64_t *index = trackFile.getIndex();
+
+        std::vector<std::pair<size_t, size_t>> ranges;
+        if (trackFile.getOrder() == TrackFileOrder::ByCell)
+            ranges = trackFile.findRegionRanges(minX, maxX, minY, maxY, minZ, maxZ);
+        else
+            ranges.emplace_back(0, trackFile.size());
+        for (auto &range : ranges) // only pages of the region are read, all of them are requested before the first one is used
+        {
+            trackFile.prefetchTracks(range.first, range.second, ranges.size() == 1);
+        }
+
+        for (auto &range : ranges)
+        {
+            for (size_t t = range.first; t < range.second; t++)
+            {
+                if (X[t] >= minX && X[t] <= maxX && Y[t] >= minY && Y[t] <= maxY && Z[t] >= minZ && Z[t] <= maxZ)
+                    tracks.push_back(createTrack(index[t], X[t], Y[t], Z[t], tanX[t], tanY[t]));
+            }
+        }
+    }
+
+    void downloadNativeTracksInChunks(const std::string &fileName, u_long chunkSize, const TracksSink &chunkCallBack, const ColumnsPartition &partition,
+                                      bool createRejected)
+    {
+        MappedTrackFile trackFile(fileName);
+        const float *X = trackFile.getX(), *Y = trackFile.getY(), *Z = trackFile.getZ();
+        const float *tanX = trackFile.getTanX(), *tanY = trackFile.getTanY();
+        const uint64_t *index = trackFile.getIndex();
+
+        trackFile.prefetchTracks(0, trackFile.size(), true);
+        TrackColumns chunkColumns;
+        for (size_t begin = 0; begin < trackFile.size(); begin += chunkSize)
+        {
+            size_t end = std::min<size_t>(begin + chunkSize, trackFile.size());
+            copyColumnsRange(X, Y, Z, tanX, tanY, begin, end, chunkColumns);
+            chunkColumns.index.assign(index + begin, index + end);
+            sendTracksChunk(chunkColumns, partition, createRejected, chunkCallBack);
+        }
+    }
+
+    void downloadNativeTracksSortedByZ(const std::string &fileName, u_long chunkSize, const TracksSink &chunkCallBack, const ColumnsPartition &partition,
+                                       bool createRejected)
+    {
+        MappedTrackFile trackFile(fileName);
+        const float *X = trackFile.getX(), *Y = trackFile.getY(), *Z = trackFile.getZ();
+        const float *tanX = trackFile.getTanX(), *tanY = trackFile.getTanY();
+        const uint64_t *index = trackFile.getIndex();
+        const size_t count = trackFile.size();
+
+        std::vector<u_long> order;
+        if (!std::is_sorted(Z, Z + count))
+        {
+            order.resize(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [Z](u_long a, u_long b)
+                             { return Z[a] < Z[b]; });
+        }
+        trackFile.prefetchTracks(0, count, order.empty());
+
+        TrackColumns chunkColumns;
+        for (size_t begin = 0; begin < count; begin += chunkSize)
+        {
+            size_t end = std::min<size_t>(begin + chunkSize, count);
+            if (order.empty())
+            {
+                copyColumnsRange(X, Y, Z, tanX, tanY, begin, end, chunkColumns);
+                chunkColumns.index.assign(index + begin, index + end);
+            }
+            else
+            {
+                chunkColumns.clear();
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto t = order[i];
+                    chunkColumns.X.push_back(X[t]);
+                    chunkColumns.Y.push_back(Y[t]);
+                    chunkColumns.Z.push_back(Z[t]);
+                    chunkColumns.tanX.push_back(tanX[t]);
+                    chunkColumns.tanY.push_back(tanY[t]);
+                    chunkColumns.index.push_back(index[t]);
+                }
+            }
+            sendTracksChunk(chunkColumns, partition, createRejected, chunkCallBack);
+        }
+    }
+
+    /* Read float branches of the Tracks tree into columns resized to the entries count. If ROOT is built with implicit
+    multithreading, tree clusters are read and decompressed by parallel tasks, each one fills its own entries range of columns.
+     */
+    void readTrackColumns(const std::string &fileName, const std::vector<FloatColumn> &columns)
+    {
+        u_long entriesCount;
+        {
+            TFile file(fileName.data());
+            TTreeReader reader("Tracks", &file);
+            entriesCount = reader.GetEntries();
+            file.Close();
+        }
+        for (auto &column : columns)
+        {
+            column.second->resize(entriesCount);
+        }
+
+#ifdef R__USE_IMT
+        ROOT::TTreeProcessorMT processor(fileName, "Tracks");
+        processor.Process([&columns](TTreeReader &reader)
+                          { readColumnsRange(reader, columns); });
+#else
+        TFile file(fileName.data());
+        TTreeReader reader("Tracks", &file);
+        readColumnsRange(reader, columns);
+        file.Close();
+#endif
+    }
+}
 
 // #include "fedra_classes/EdbSegP.h"
 // #include "fedra_classes/MyClass.h"
@@ -68,8 +385,119 @@
 //     printf("FEDRA linked_tracks.root file succesfully written to downloaded_tracks.root!\n");
 // }
 
-std::vector<Track> &FedraDownloader::downloadTracksFromFile(std::string fileName)
+void FedraDownloader::downloadTrackColumnsFromFile(std::string fileName, TrackColumns &columns)
+{
+    if (isNativeTrackFile(fileName))
+    {
+        MappedTrackFile trackFile(fileName);
+        trackFile.prefetchTracks(0, trackFile.size(), true);
+        trackFile.copyColumns(columns);
+        return;
+    }
+    columns.index.clear();
+    readTrackColumns(fileName, {{"X", &columns.X}, {"Y", &columns.Y}, {"Z", &columns.Z}, {"tanX", &columns.tanX}, {"tanY", &columns.tanY}});
+}
+
+std::vector<Track> FedraDownloader::downloadTracksFromFile(std::string fileName)
+{
+    std::vector<Track> tracks;
+    if (isNativeTrackFile(fileName))
+    {
+        downloadNativeTracks(fileName, tracks);
+        return tracks;
+    }
+
+    TrackColumns columns;
+    downloadTrackColumnsFromFile(fileName, columns);
+
+    tracks.reserve(columns.size());
+    for (u_long c = 0; c < columns.size(); c++)
+    {
+        tracks.push_back(createTrack(c, columns.X[c], columns.Y[c], columns.Z[c], columns.tanX[c], columns.tanY[c]));
+    }
+    return tracks;
+}
+
+std::vector<Track> FedraDownloader::downloadTracksFromFileInRegion(std::string fileName, float minX, float maxX, float minY, float maxY, float minZ, float maxZ)
+{
+    std::vector<Track> tracks;
+    if (isNativeTrackFile(fileName))
+    {
+        downloadNativeTracksInRegion(fileName, minX, maxX, minY, maxY, minZ, maxZ, tracks);
+        return tracks;
+    }
+
+    TrackColumns columns;
+    downloadTrackColumnsFromFile(fileName, columns);
+    for (u_long c = 0; c < columns.size(); c++)
+    {
+        if (columns.X[c] >= minX && columns.X[c] <= maxX && columns.Y[c] >= minY && columns.Y[c] <= maxY && columns.Z[c] >= minZ && columns.Z[c] <= maxZ)
+            tracks.push_back(createTrack(c, columns.X[c], columns.Y[c], columns.Z[c], columns.tanX[c], columns.tanY[c]));
+    }
+    return tracks;
+}
+
+void FedraDownloader::downloadTracksFromFileInChunks(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                                     bool createRejected)
+{
+    if (isNativeTrackFile(fileName))
+    {
+        downloadNativeTracksInChunks(fileName, chunkSize, chunkCallBack, partition, createRejected);
+        return;
+    }
+
+    // Columns are read by the parallel tasks of the tree clusters, they are 20 bytes per track, so only Track objects
+    // with segments are created by chunks, while the caller processes the previous ones.
+    TrackColumns columns, chunkColumns;
+    downloadTrackColumnsFromFile(fileName, columns);
+    for (u_long begin = 0; begin < columns.size(); begin += chunkSize)
+    {
+        u_long end = std::min<u_long>(begin + chunkSize, columns.size());
+        copyColumnsRange(columns.X.data(), columns.Y.data(), columns.Z.data(), columns.tanX.data(), columns.tanY.data(), begin, end, chunkColumns);
+        chunkColumns.index.resize(end - begin);
+        std::iota(chunkColumns.index.begin(), chunkColumns.index.end(), begin);
+        sendTracksChunk(chunkColumns, partition, createRejected, chunkCallBack);
+    }
+}
+
+u_long FedraDownloader::countTracksInFile(std::string fileName)
+{
+    if (isNativeTrackFile(fileName))
+    {
+        return MappedTrackFile(fileName).size(); // only header page is read
+    }
+
+    TFile file(fileName.data());
+    TTreeReader reader("Tracks", &file);
+    u_long count = reader.GetEntries();
+    file.Close();
+    return count;
+}
+
+void FedraDownloader::downloadTracksFromFileSortedByZ(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                                      bool createRejected)
 {
+    if (isNativeTrackFile(fileName))
+    {
+        downloadNativeTracksSortedByZ(fileName, chunkSize, chunkCallBack, partition, createRejected);
+        return;
+    }
+
+    std::vector<Float_t> zColumn;
+    readTrackColumns(fileName, {{"Z", &zColumn}});
+    bool sorted = std::is_sorted(zColumn.begin(), zColumn.end());
+
+    std::vector<u_int> order;
+    if (!sorted)
+    {
+        order.resize(zColumn.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&zColumn](u_int a, u_int b)
+                         { return zColumn[a] < zColumn[b]; });
+    }
+    u_long entriesCount = zColumn.size();
+    std::vector<Float_t>().swap(zColumn);
+
     TFile file(fileName.data());
     TTreeReader reader("Tracks", &file);
 
@@ -79,29 +507,32 @@ std::vector<Track> &FedraDownloader::downloadTracksFromFile(std::string fileName
     TTreeReaderValue<Float_t> tanX(reader, "tanX");
     TTreeReaderValue<Float_t> tanY(reader, "tanY");
 
-    tracksVector.reserve(reader.GetEntries());
-
-    u_long c = 0;
-    while (reader.Next())
+    TrackColumns chunkColumns;
+    for (u_long i = 0; i < entriesCount; i++)
     {
-        Track track(c, *X, *Y, *Z, *tanX, *tanY);
-
-        for (size_t i = 0; i < 30; i++)
+        u_long entry = sorted ? i : order[i];
+        if (reader.SetEntry(entry) != TTreeReader::kEntryValid)
         {
-            Segment seg(c, 111, 111, 111, 222, 222);
-            track.addSegment(seg);
+            throw std::runtime_error("ERROR in tracks file reading, entry " + std::to_string(entry) + " is not valid.");
         }
-
-        // if (c == 300000)
-        // {
-        //     break;
-        // }
-
-        tracksVector.push_back(track);
-        c++;
+        chunkColumns.X.push_back(*X);
+        chunkColumns.Y.push_back(*Y);
+        chunkColumns.Z.push_back(*Z);
+        chunkColumns.tanX.push_back(*tanX);
+        chunkColumns.tanY.push_back(*tanY);
+        chunkColumns.index.push_back(entry);
+
+        if (chunkColumns.size() == chunkSize)
+        {
+            sendTracksChunk(chunkColumns, partition, createRejected, chunkCallBack);
+            chunkColumns.clear();
+        }
+    }
+    if (chunkColumns.size() != 0)
+    {
+        sendTracksChunk(chunkColumns, partition, createRejected, chunkCallBack);
     }
     file.Close();
-    return tracksVector;
 }
 
 bool FedraDownloader::downloadTracksToFile(std::string fileName, std::vector<Track *> &tracks)
@@ -114,87 +545,50 @@ std::vector<Vertex> &FedraDownloader::downloadVertexesFromFile(std::string fileN
     return vertexesVector;
 }
 
-bool FedraDownloader::downloadVertexesToFile(std::string fileName, std::vector<Vertex *> &vertexes)
+bool FedraDownloader::finishVertexesWriting()
+{
+    bool succeeded = true;
+    if (vertexTreeWriter)
+    {
+        succeeded = vertexTreeWriter->close();
+        if (!succeeded)
+        {
+            printf("====== ERROR in vertexes file %s writing! ======= \n", vertexTreeWriter->getFileName().c_str());
+        }
+        vertexTreeWriter.reset();
+    }
+    if (nativeVertexWriter)
+    {
+        succeeded &= nativeVertexWriter->close();
+        nativeVertexWriter.reset();
+    }
+    return succeeded;
+}
+
+bool FedraDownloader::downloadVertexesToFile(std::string fileName, std::vector<Vertex *> &vertexes, bool append)
 {
     if (fileName.find(".root") != std::string::npos)
     {
-        auto file = TFile::Open(fileName.data(), "recreate");
-        auto tree = new TTree("VertexTree", "VertexTree");
+        if (!append || !vertexTreeWriter || vertexTreeWriter->getFileName() != fileName)
+        {
+            vertexTreeWriter.reset(); // previous file is closed, other writers continue
+            vertexTreeWriter = std::make_unique<VertexTreeWriter>(fileName);
+        }
+        vertexTreeWriter->writeVertexes(vertexes); // tree is filled by the writer thread
     }
-    if (fileName.find(".txt") != std::string::npos)
+    if (isNativeVertexFile(fileName))
     {
-        std::ofstream outFile(fileName);
-        for (auto vert : vertexes)
+        if (!append || !nativeVertexWriter || nativeVertexWriter->getFileName() != fileName)
         {
-            auto vXs1 = std::to_string(vert->getX());
-            auto vXs2 = vXs1.substr(0, vXs1.find(".") + 3);
-            auto vYs1 = std::to_string(vert->getY());
-            auto vYs2 = vYs1.substr(0, vYs1.find(".") + 3);
-            auto vZs1 = std::to_string(vert->getZ());
-            auto vZs2 = vZs1.substr(0, vZs1.find(".") + 3);
-
-            outFile << "1ry_vtx "
-                    << "0 "
-                    << "0 "
-                    << "0 "
-                    << "0 "
-                    << std::to_string(vert->getIndex()) + " "
-                    << vXs2 + " "
-                    << vYs2 + " "
-                    << vZs2 + " "
-                    << "0 "
-                    << "0 "
-                    << std::to_string(vert->getDaughterTracksCount()) + " "
-                    << "0 "
-                    << "0 "
-                    << "0 "
-                    << "0 "
-                    << std::endl;
-            for (size_t t = 0; t < vert->getDaughterTracksCount(); t++)
-            {
-                auto tr = vert->getDaughterTrack(t);
-
-                auto tXs1 = std::to_string(tr->getX());
-                auto tXs2 = tXs1.substr(0, tXs1.find(".") + 3);
-                auto tYs1 = std::to_string(tr->getY());
-                auto tYs2 = tYs1.substr(0, tYs1.find(".") + 3);
-                auto tTXs1 = std::to_string(tr->getTanX());
-                auto tTXs2 = tTXs1.substr(0, tTXs1.find(".") + 3);
-                auto tTYs1 = std::to_string(tr->getTanY());
-                auto tTYs2 = tTYs1.substr(0, tTYs1.find(".") + 3);
-
-                outFile << "1ry_trk "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << std::to_string(vert->getIndex()) + " "
-                        << vXs2 + " "
-                        << vYs2 + " "
-                        << vZs2 + " "
-                        << "0 "
-                        << std::to_string(vert->getDaughterTracksCount()) + " "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << std::to_string(tr->getIndex()) + " "
-                        << "0 "
-                        << "0 "
-                        << tXs2 + " "
-                        << tYs2 + " "
-                        << tTXs2 + " "
-                        << tTYs2 + " "
-                        << std::to_string(tr->getSegmentsCount()) + " "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << "0 "
-                        << std::endl;
-            }
-            outFile << std::endl;
+            nativeVertexWriter.reset();
+            nativeVertexWriter = std::make_unique<NativeVertexFileWriter>(fileName);
         }
+        nativeVertexWriter->writeVertexes(vertexes);
+    }
+    if (fileName.find(".txt") != std::string::npos)
+    {
+        std::ofstream outFile(fileName, append ? std::ios::app : std::ios::out);
+        writeVertexesText(outFile, vertexes, textThreadsCount != 0 ? textThreadsCount : std::max(1u, std::thread::hardware_concurrency()));
         outFile.close();
         if (outFile.fail())
         {
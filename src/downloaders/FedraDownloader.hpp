@@ -2,20 +2,68 @@
 #include "IDownloader.hpp"
 
 #include "../data_types/Track.hpp"
+#include "../data_types/TrackColumns.hpp"
 #include "../data_types/Vertex.hpp"
 #include "../data_types/Segment.hpp"
+#include "VertexTreeWriter.hpp"
+#include "NativeVertexFile.hpp"
+
+#include <memory>
 
 class FedraDownloader : public IDownloader
 {
 private:
-    std::vector<Track> tracksVector;
     std::vector<Vertex> vertexesVector;
+    std::unique_ptr<VertexTreeWriter> vertexTreeWriter; // ROOT vertexes file being written in background
+    std::unique_ptr<NativeVertexFileWriter> nativeVertexWriter; // native vertexes file collected until finishVertexesWriting
+    u_int textThreadsCount;                                     // threads formatting text vertexes file, 0 - all cores
 
 public:
-    /** @brief Download Tracks from file.
+    /** @brief Download Tracks from file: ROOT file with Tracks tree or native track file (.trk), which is memory mapped
+     * and read in place.
+     * @param fileName file path.
+     */
+    std::vector<Track> downloadTracksFromFile(std::string fileName);
+
+    /** @brief Download Tracks in the box from file. Native track file sorted by cells
+     * is read only in the cells intersecting the box, other files are read entirely and filtered.
+     * @param fileName file path.
+     */
+    std::vector<Track> downloadTracksFromFileInRegion(std::string fileName, float minX, float maxX, float minY, float maxY, float minZ, float maxZ);
+
+    /** @brief Download Tracks parameters from file to columns, without creating Track objects. Tree clusters are read
+     * by parallel tasks if ROOT is built with implicit multithreading and the application enabled it (ROOT::EnableImplicitMT).
+     * @param fileName file path.
+     */
+    void downloadTrackColumnsFromFile(std::string fileName, TrackColumns &columns);
+
+    /** @brief Download Tracks from file in chunks in the file order, so the caller could process a chunk while the next one is created.
+     * ROOT file columns are read at once by downloadTrackColumnsFromFile, native track file columns are used in place. Chunk columns
+     * are prefiltered before Track objects with segments are created.
      * @param fileName file path.
+     * @param chunkSize tracks count in the chunk.
+     * @param chunkCallBack called for every chunk.
+     * @param partition prefilter of the chunk columns, all tracks pass if it is empty.
+     * @param createRejected create Track objects of the rejected tracks too, otherwise chunk has only the passed ones.
      */
-    std::vector<Track> &downloadTracksFromFile(std::string fileName);
+    void downloadTracksFromFileInChunks(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                        bool createRejected);
+
+    /** @brief Count Tracks in file without downloading them.
+     * @param fileName file path.
+     */
+    u_long countTracksInFile(std::string fileName);
+
+    /** @brief Download Tracks from file in chunks sorted by Z. Only Z column is read for sorting, file sorted by Z
+     * is read sequentially, otherwise entries are read in Z order, which is slower.
+     * @param fileName file path.
+     * @param chunkSize tracks count in the chunk.
+     * @param chunkCallBack called for every chunk in Z order.
+     * @param partition prefilter of the chunk columns, all tracks pass if it is empty.
+     * @param createRejected create Track objects of the rejected tracks too, otherwise chunk has only the passed ones.
+     */
+    void downloadTracksFromFileSortedByZ(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                         bool createRejected);
 
     /** @brief Download Tracks to file.
      * @param fileName file path.
@@ -28,13 +76,23 @@ public:
      */
     virtual std::vector<Vertex> &downloadVertexesFromFile(std::string fileName);
 
-    /** @brief Download Vertexes to file.
+    /** @brief Download Vertexes to file: text file, ROOT file with VertexTree, which is written by the background thread
+     * until finishVertexesWriting, or native vertex file (.vtx) with vertexes table and daughter tracks indexes, written by finishVertexesWriting.
      * @param fileName file path.
-     * @returns true if file was downloaded succesfully.
+     * @param append append vertexes to the existing file instead of recreating it.
+     * @returns true if file was downloaded succesfully, for ROOT file - if vertexes were passed to the writer.
      */
-    virtual bool downloadVertexesToFile(std::string fileName, std::vector< Vertex *> &vertexes);
+    virtual bool downloadVertexesToFile(std::string fileName, std::vector< Vertex *> &vertexes, bool append = false);
+
+    /** @brief Wait until ROOT vertexes file is written and close it, write native vertexes file.
+     * @returns true if files were written succesfully.
+     */
+    virtual bool finishVertexesWriting();
 
 public:
-    FedraDownloader(){};
-    virtual ~FedraDownloader(){};
+    /** @param textThreadsCount threads formatting text vertexes file, all cores by default. Downloaders working in parallel
+     * should share the cores.
+     */
+    FedraDownloader(u_int textThreadsCount = 0) : textThreadsCount(textThreadsCount){};
+    virtual ~FedraDownloader() { finishVertexesWriting(); };
 };
\ No newline at end of file
@@ -1,17 +1,64 @@
 #pragma once
 #include <string>
+#include <functional>
 
 #include "../data_types/Track.hpp"
+#include "../data_types/TrackColumns.hpp"
 #include "../data_types/Vertex.hpp"
 
-/** @brief Interface of downloader.*/
+/** @brief Prefilter of the chunk columns before Track objects are created from them. It reorders the columns in place, passed
+ * tracks first, and returns the passed tracks count. */
+using ColumnsPartition = std::function<size_t(TrackColumns &chunkColumns)>;
+
+/** @brief Consumer of downloaded tracks, it takes ownership of the tracks chunk, downloader keeps no copy of it.
+ * First passedCount tracks of the chunk passed the columns partition, rejected tracks follow them if they were requested. */
+using TracksSink = std::function<void(std::vector<Track> &&chunk, size_t passedCount)>;
+
+/** @brief Interface of downloader. Downloaded tracks are owned by the caller, so they could be moved to detector volume
+ * without copies left in the downloader.*/
 class IDownloader
 {
 public:
     /** @brief Download Tracks from file.
+     * @param fileName file path.
+     * @returns tracks owned by the caller.
+     */
+    virtual std::vector<Track> downloadTracksFromFile(std::string fileName) = 0;
+
+    /** @brief Download only Tracks in the box (for example a tile with the search halo around it) from file.
      * @param fileName file path.
      */
-    virtual std::vector<Track> &downloadTracksFromFile(std::string fileName) = 0;
+    virtual std::vector<Track> downloadTracksFromFileInRegion(std::string fileName, float minX, float maxX, float minY, float maxY, float minZ, float maxZ) = 0;
+
+    /** @brief Download Tracks parameters from file to columns, track index is its number in columns.
+     * @param fileName file path.
+     */
+    virtual void downloadTrackColumnsFromFile(std::string fileName, TrackColumns &columns) = 0;
+
+    /** @brief Download Tracks from file in chunks in the file order, so the caller could process a chunk while the next one is read.
+     * @param fileName file path.
+     * @param chunkSize tracks count in the chunk.
+     * @param chunkCallBack called for every chunk.
+     * @param partition prefilter of the chunk columns, all tracks pass if it is empty.
+     * @param createRejected create Track objects of the rejected tracks too, otherwise chunk has only the passed ones.
+     */
+    virtual void downloadTracksFromFileInChunks(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                                bool createRejected) = 0;
+
+    /** @brief Count Tracks in file without downloading them.
+     * @param fileName file path.
+     */
+    virtual u_long countTracksInFile(std::string fileName) = 0;
+
+    /** @brief Download Tracks from file in chunks sorted by Z, only one chunk is kept in memory.
+     * @param fileName file path.
+     * @param chunkSize tracks count in the chunk.
+     * @param chunkCallBack called for every chunk in Z order.
+     * @param partition prefilter of the chunk columns, all tracks pass if it is empty.
+     * @param createRejected create Track objects of the rejected tracks too, otherwise chunk has only the passed ones.
+     */
+    virtual void downloadTracksFromFileSortedByZ(std::string fileName, u_long chunkSize, TracksSink chunkCallBack, ColumnsPartition partition,
+                                                 bool createRejected) = 0;
 
     /** @brief Download Tracks to file.
      * @param fileName file path.
@@ -26,9 +73,15 @@ public:
 
     /** @brief Download Vertexes to file.
      * @param fileName file path.
+     * @param append append vertexes to the existing file instead of recreating it.
      * @returns true if file was downloaded succesfully.
      */
-    virtual bool downloadVertexesToFile(std::string fileName, std::vector< Vertex *> &vertexes) = 0;
+    virtual bool downloadVertexesToFile(std::string fileName, std::vector< Vertex *> &vertexes, bool append = false) = 0;
+
+    /** @brief Wait until vertexes files written in background are complete and close them.
+     * @returns true if files were written succesfully.
+     */
+    virtual bool finishVertexesWriting() = 0;
 
 public:
     IDownloader(){};
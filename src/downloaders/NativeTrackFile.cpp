@@ -0,0 +1,314 @@
+#include "NativeTrackFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Native track file columns are used in place, host must be little-endian.");
+
+namespace
+{
+    const uint64_t COLUMN_ALIGNMENT = 64; // bytes, cache line and AVX-512 register
+
+    uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+    }
+
+    /* Cell number along one axis, coordinates outside of the volume belong to its border cells. */
+    u_int calculateCellCoordinate(float coordinate, u_int cellDimension, u_int cellsInDimension)
+    {
+        return std::min<u_int>((u_int)std::max<float>(std::floor(coordinate / cellDimension), 0), cellsInDimension - 1);
+    }
+
+    /* Same cell as DetectorVolume::getLinearCellIndex for the whole volume. */
+    uint32_t calculateLinearCellIndex(float x, float y, float z, u_int cellDimension, u_int volumeDimension)
+    {
+        u_int cellsInDimension = volumeDimension / cellDimension;
+        u_int coordinateCorrection = volumeDimension / 2;
+        return (calculateCellCoordinate(z, cellDimension, cellsInDimension) * cellsInDimension +
+                calculateCellCoordinate(y + coordinateCorrection, cellDimension, cellsInDimension)) *
+                   cellsInDimension +
+               calculateCellCoordinate(x + coordinateCorrection, cellDimension, cellsInDimension);
+    }
+
+    template <class T>
+    void writeColumn(std::ofstream &file, uint64_t offset, const std::vector<T> &column, const std::vector<u_long> &order)
+    {
+        std::vector<T> ordered(order.size());
+        for (size_t t = 0; t < order.size(); t++)
+        {
+            ordered[t] = column[order[t]];
+        }
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char *>(ordered.data()), ordered.size() * sizeof(T));
+    }
+}
+
+bool isNativeTrackFile(const std::string &fileName)
+{
+    const std::string extension = ".trk";
+    return fileName.size() >= extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void writeNativeTrackFile(const std::string &fileName, const TrackColumns &columns, TrackFileOrder order, u_int cellDimension, u_int volumeDimension)
+{
+    const size_t count = columns.size();
+
+    TrackFileHeader header = {};
+    std::memcpy(header.magic, TRACK_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACK_FILE_VERSION;
+    header.order = (uint32_t)order;
+    header.tracksCount = count;
+
+    if (count != 0)
+    {
+        auto X = std::minmax_element(columns.X.begin(), columns.X.end());
+        auto Y = std::minmax_element(columns.Y.begin(), columns.Y.end());
+        auto Z = std::minmax_element(columns.Z.begin(), columns.Z.end());
+        header.minX = *X.first, header.maxX = *X.second;
+        header.minY = *Y.first, header.maxY = *Y.second;
+        header.minZ = *Z.first, header.maxZ = *Z.second;
+    }
+
+    std::vector<u_long> tracksOrder(count);
+    std::iota(tracksOrder.begin(), tracksOrder.end(), 0);
+    std::vector<uint32_t> cells;
+    std::vector<uint64_t> cellRows;
+    if (order == TrackFileOrder::ByZ)
+    {
+        std::stable_sort(tracksOrder.begin(), tracksOrder.end(), [&columns](u_long a, u_long b)
+                         { return columns.Z[a] < columns.Z[b]; });
+    }
+    if (order == TrackFileOrder::ByCell)
+    {
+        if (cellDimension == 0 || volumeDimension % cellDimension != 0)
+        {
+            throw std::invalid_argument("ERROR in native track file writing: volume dimension must be dividable by cell dimension.");
+        }
+        header.cellDimension = cellDimension;
+        header.volumeDimension = volumeDimension;
+
+        cells.resize(count);
+        for (size_t t = 0; t < count; t++)
+        {
+            cells[t] = calculateLinearCellIndex(columns.X[t], columns.Y[t], columns.Z[t], cellDimension, volumeDimension);
+        }
+        std::stable_sort(tracksOrder.begin(), tracksOrder.end(), [&cells](u_long a, u_long b)
+                         { return cells[a] < cells[b]; });
+
+        u_int cellsInDimension = volumeDimension / cellDimension;
+        cellRows.assign((size_t)cellsInDimension * cellsInDimension + 1, count);
+        for (size_t t = count; t-- > 0;)
+        {
+            cellRows[cells[tracksOrder[t]] / cellsInDimension] = t;
+        }
+        for (size_t row = cellRows.size() - 1; row-- > 0;) // empty rows start where the next row starts
+        {
+            cellRows[row] = std::min(cellRows[row], cellRows[row + 1]);
+        }
+    }
+
+    std::vector<uint64_t> indexes(count);
+    for (size_t t = 0; t < count; t++)
+    {
+        indexes[t] = columns.getIndex(t);
+    }
+
+    uint64_t offset = sizeof(TrackFileHeader);
+    for (int c = 0; c < 5; c++)
+    {
+        offset = alignOffset(offset);
+        header.columnOffsets[c] = offset;
+        offset += count * sizeof(float);
+    }
+    header.columnOffsets[5] = offset = alignOffset(offset);
+    offset += count * sizeof(uint64_t);
+    if (order == TrackFileOrder::ByCell)
+    {
+        header.columnOffsets[6] = offset = alignOffset(offset);
+        offset += count * sizeof(uint32_t);
+        header.cellRowsOffset = offset = alignOffset(offset);
+        offset += cellRows.size() * sizeof(uint64_t);
+    }
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("ERROR - could not create native track file " + fileName);
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeColumn(file, header.columnOffsets[0], columns.X, tracksOrder);
+    writeColumn(file, header.columnOffsets[1], columns.Y, tracksOrder);
+    writeColumn(file, header.columnOffsets[2], columns.Z, tracksOrder);
+    writeColumn(file, header.columnOffsets[3], columns.tanX, tracksOrder);
+    writeColumn(file, header.columnOffsets[4], columns.tanY, tracksOrder);
+    writeColumn(file, header.columnOffsets[5], indexes, tracksOrder);
+    if (order == TrackFileOrder::ByCell)
+    {
+        writeColumn(file, header.columnOffsets[6], cells, tracksOrder);
+        file.seekp(header.cellRowsOffset);
+        file.write(reinterpret_cast<const char *>(cellRows.data()), cellRows.size() * sizeof(uint64_t));
+    }
+    if (!file.good())
+    {
+        throw std::runtime_error("ERROR in native track file writing " + fileName);
+    }
+}
+
+std::vector<std::pair<size_t, size_t>> MappedTrackFile::findRegionRanges(float minX, float maxX, float minY, float maxY, float minZ, float maxZ) const
+{
+    if (getOrder() != TrackFileOrder::ByCell)
+    {
+        throw std::logic_error("ERROR - region of tracks could be found only in the file sorted by cells.");
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (size() == 0 || minX > maxX || minY > maxY || minZ > maxZ)
+        return ranges;
+
+    const u_int cellDimension = header->cellDimension;
+    const u_int cellsInDimension = header->volumeDimension / cellDimension;
+    const float coordinateCorrection = header->volumeDimension / 2;
+    auto cellCoordinate = [cellDimension, cellsInDimension](float coordinate)
+    {
+        return calculateCellCoordinate(coordinate, cellDimension, cellsInDimension);
+    };
+    const u_int beginX = cellCoordinate(minX + coordinateCorrection), endX = cellCoordinate(maxX + coordinateCorrection);
+    const u_int beginY = cellCoordinate(minY + coordinateCorrection), endY = cellCoordinate(maxY + coordinateCorrection);
+    const u_int beginZ = cellCoordinate(minZ), endZ = cellCoordinate(maxZ);
+
+    const uint32_t *cell = getCell();
+    const uint64_t *cellRows = getCellRows();
+    for (u_int z = beginZ; z <= endZ; z++)
+    {
+        for (u_int y = beginY; y <= endY; y++)
+        {
+            uint32_t row = z * cellsInDimension + y;
+            uint32_t firstCell = row * cellsInDimension + beginX, lastCell = row * cellsInDimension + endX;
+
+            // the row is a small part of the cell column, files written without rows index are searched in the whole column
+            const uint32_t *rowBegin = cellRows ? cell + cellRows[row] : cell;
+            const uint32_t *rowEnd = cellRows ? cell + cellRows[row + 1] : cell + size();
+            size_t first = std::lower_bound(rowBegin, rowEnd, firstCell) - cell;
+            size_t last = std::upper_bound(cell + first, rowEnd, lastCell) - cell;
+            if (first == last)
+                continue;
+
+            if (!ranges.empty() && ranges.back().second == first) // neighbour rows of the full volume width are contiguous
+                ranges.back().second = last;
+            else
+                ranges.emplace_back(first, last);
+        }
+    }
+    return ranges;
+}
+
+void MappedTrackFile::prefetchTracks(size_t first, size_t last, bool sequential) const
+{
+    last = std::min(last, size());
+    if (first >= last)
+        return;
+
+    static const uintptr_t PAGE_SIZE = sysconf(_SC_PAGESIZE);
+    for (int c = 0; c < 6; c++) // cell column is only searched, not read
+    {
+        size_t valueSize = c < 5 ? sizeof(float) : sizeof(uint64_t);
+        auto begin = reinterpret_cast<uintptr_t>(data + header->columnOffsets[c] + first * valueSize) / PAGE_SIZE * PAGE_SIZE;
+        auto end = reinterpret_cast<uintptr_t>(data + header->columnOffsets[c] + last * valueSize);
+        if (sequential)
+            madvise(reinterpret_cast<void *>(begin), end - begin, MADV_SEQUENTIAL);
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+    }
+}
+
+void MappedTrackFile::copyColumns(TrackColumns &columns) const
+{
+    auto count = size();
+    columns.X.assign(getX(), getX() + count);
+    columns.Y.assign(getY(), getY() + count);
+    columns.Z.assign(getZ(), getZ() + count);
+    columns.tanX.assign(getTanX(), getTanX() + count);
+    columns.tanY.assign(getTanY(), getTanY() + count);
+    columns.index.clear();
+    if (getOrder() != TrackFileOrder::Unsorted)
+    {
+        columns.index.assign(getIndex(), getIndex() + count);
+    }
+}
+
+MappedTrackFile::MappedTrackFile(const std::string &fileName)
+{
+    int descriptor = open(fileName.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("ERROR - could not open native track file " + fileName);
+    }
+    struct stat fileStat;
+    if (fstat(descriptor, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(TrackFileHeader))
+    {
+        close(descriptor);
+        throw std::invalid_argument("ERROR - file is too small for native track file " + fileName);
+    }
+    dataSize = fileStat.st_size;
+    void *mapped = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor); // mapping keeps the file
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("ERROR - could not map native track file " + fileName);
+    }
+    data = static_cast<const char *>(mapped);
+    header = reinterpret_cast<const TrackFileHeader *>(data);
+
+    std::string error;
+    if (std::memcmp(header->magic, TRACK_FILE_MAGIC, sizeof(header->magic)) != 0)
+        error = "is not a native track file";
+    else if (header->version != TRACK_FILE_VERSION)
+        error = "has unsupported version " + std::to_string(header->version);
+    else if (header->order > (uint32_t)TrackFileOrder::ByCell)
+        error = "has unknown tracks order";
+    for (int c = 0; c < 7 && error.empty(); c++)
+    {
+        size_t columnSize = header->tracksCount * (c < 5 ? sizeof(float) : c == 5 ? sizeof(uint64_t) : sizeof(uint32_t));
+        bool required = c < 6 || header->order == (uint32_t)TrackFileOrder::ByCell;
+        auto offset = header->columnOffsets[c];
+        if ((required && offset == 0) || offset % COLUMN_ALIGNMENT != 0 || (offset != 0 && offset + columnSize > dataSize))
+            error = "is truncated or has wrong columns offsets";
+    }
+    if (error.empty() && header->order == (uint32_t)TrackFileOrder::ByCell &&
+        (header->cellDimension == 0 || header->volumeDimension % header->cellDimension != 0))
+        error = "has wrong cell dimensions";
+    if (error.empty() && header->cellRowsOffset != 0)
+    {
+        error = "has wrong cell rows index";
+        if (header->order == (uint32_t)TrackFileOrder::ByCell && header->cellRowsOffset % COLUMN_ALIGNMENT == 0)
+        {
+            uint64_t cellsInDimension = header->volumeDimension / header->cellDimension;
+            uint64_t rowsCount = cellsInDimension * cellsInDimension + 1;
+            if (header->cellRowsOffset + rowsCount * sizeof(uint64_t) <= dataSize)
+            {
+                auto cellRows = reinterpret_cast<const uint64_t *>(data + header->cellRowsOffset);
+                if (std::is_sorted(cellRows, cellRows + rowsCount) && cellRows[rowsCount - 1] == header->tracksCount)
+                    error.clear();
+            }
+        }
+    }
+    if (!error.empty())
+    {
+        munmap(mapped, dataSize);
+        throw std::invalid_argument("ERROR - file " + fileName + " " + error + ".");
+    }
+}
+
+MappedTrackFile::~MappedTrackFile()
+{
+    munmap(const_cast<char *>(data), dataSize);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../data_types/TrackColumns.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** @brief Order of tracks in the native track file. */
+enum class TrackFileOrder : uint32_t
+{
+    Unsorted = 0,
+    ByZ = 1,
+    ByCell = 2 // by detector volume cell linear index: Z layer, then Y row, then X, see TrackFileHeader cell dimensions
+};
+
+/**
+ * @brief Header of the native track file (.trk). File is little-endian: header, then columns X, Y, Z, tanX, tanY (float),
+ * index (uint64, track index in the source file) and, for the cell order only, cell (uint32, linear cell index) and cell rows index.
+ * Cell rows index has (volumeDimension / cellDimension)^2 + 1 uint64 entries: the first track of every Z layer and Y row of cells,
+ * so tracks of a region are found without reading the other rows.
+ * Each column starts at the 64 bytes aligned offset, so it could be used in place from the memory mapped file.
+ */
+struct TrackFileHeader
+{
+    char magic[8];             // TRACK_FILE_MAGIC
+    uint32_t version;          // TRACK_FILE_VERSION
+    uint32_t order;            // TrackFileOrder
+    uint64_t tracksCount;
+    uint32_t cellDimension;    // microns, cells of the ByCell order
+    uint32_t volumeDimension;  // microns, volume of the ByCell order, X and Y are shifted by its half as in DetectorVolume
+    float minX, maxX, minY, maxY, minZ, maxZ; // tracks bounds
+    uint64_t columnOffsets[7]; // X, Y, Z, tanX, tanY, index, cell; 0 if the column is absent
+    uint64_t cellRowsOffset;   // cell rows index of the ByCell order, 0 if it is absent
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(TrackFileHeader) == 128, "Track file header layout must not change within the version.");
+
+inline constexpr char TRACK_FILE_MAGIC[8] = {'D', 'S', 'T', 'A', 'U', 'T', 'R', 'K'};
+inline constexpr uint32_t TRACK_FILE_VERSION = 1;
+
+/** @brief True if the file name has the native track file extension .trk. */
+bool isNativeTrackFile(const std::string &fileName);
+
+/**
+ * @brief Write tracks columns to the native track file. Tracks are reordered by the order, their indexes are kept in the index column.
+ * @param cellDimension cell size for the ByCell order, volume dimension must be dividable by it.
+ * @throws std::invalid_argument for wrong cell order dimensions, std::runtime_error if file could not be written.
+ */
+void writeNativeTrackFile(const std::string &fileName, const TrackColumns &columns, TrackFileOrder order = TrackFileOrder::Unsorted,
+                          u_int cellDimension = 0, u_int volumeDimension = 0);
+
+/**
+ * @brief Native track file mapped to memory read only. Columns point directly to the mapped pages, nothing is deserialized:
+ * pages are read by the first access or read ahead by prefetchTracks. File stays mapped while the object exists.
+ */
+class MappedTrackFile
+{
+private:
+    const TrackFileHeader *header = nullptr;
+    const char *data = nullptr;
+    size_t dataSize = 0;
+
+    template <class T>
+    const T *getColumn(int column) const
+    {
+        return header->columnOffsets[column] == 0 ? nullptr : reinterpret_cast<const T *>(data + header->columnOffsets[column]);
+    }
+
+public:
+    const TrackFileHeader &getHeader() const { return *header; }
+
+    size_t size() const { return header->tracksCount; }
+
+    TrackFileOrder getOrder() const { return (TrackFileOrder)header->order; }
+
+    const float *getX() const { return getColumn<float>(0); }
+    const float *getY() const { return getColumn<float>(1); }
+    const float *getZ() const { return getColumn<float>(2); }
+    const float *getTanX() const { return getColumn<float>(3); }
+    const float *getTanY() const { return getColumn<float>(4); }
+    const uint64_t *getIndex() const { return getColumn<uint64_t>(5); }
+
+    /** @brief Linear cell indexes, only for the ByCell order, otherwise nullptr. */
+    const uint32_t *getCell() const { return getColumn<uint32_t>(6); }
+
+    /** @brief First track of every cell row and the end of the last one, only for the ByCell order, otherwise nullptr. */
+    const uint64_t *getCellRows() const { return header->cellRowsOffset == 0 ? nullptr : reinterpret_cast<const uint64_t *>(data + header->cellRowsOffset); }
+
+    /**
+     * @brief Ranges [first, second) of tracks in the cells intersecting the box, only the ByCell order file could be searched.
+     * Tracks near the box borders are in the ranges too, because whole cells are taken.
+     * @throws std::logic_error if tracks are not sorted by cells.
+     */
+    std::vector<std::pair<size_t, size_t>> findRegionRanges(float minX, float maxX, float minY, float maxY, float minZ, float maxZ) const;
+
+    /**
+     * @brief Start read ahead of the tracks [first, last) parameters and index columns pages, mapping reads pages only by the first access.
+     * @param sequential the range is read in order, so the kernel reads ahead more and drops the read pages earlier.
+     */
+    void prefetchTracks(size_t first, size_t last, bool sequential) const;
+
+    /** @brief Copy columns, index column is copied too if tracks are reordered. */
+    void copyColumns(TrackColumns &columns) const;
+
+public:
+    /** @throws std::runtime_error if file could not be mapped, std::invalid_argument if it is not a native track file of this version. */
+    MappedTrackFile(const std::string &fileName);
+
+    virtual ~MappedTrackFile();
+
+    MappedTrackFile(const MappedTrackFile &) = delete;
+    MappedTrackFile &operator=(const MappedTrackFile &) = delete;
+};
@@ -0,0 +1,161 @@
+#include "NativeVertexFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Native vertex file columns are used in place, host must be little-endian.");
+
+namespace
+{
+    const uint64_t COLUMN_ALIGNMENT = 64; // bytes, the same as in the native track file
+
+    uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+    }
+
+    template <class T>
+    void writeColumn(std::ofstream &file, uint64_t offset, const std::vector<T> &column)
+    {
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(T));
+    }
+}
+
+bool isNativeVertexFile(const std::string &fileName)
+{
+    const std::string extension = ".vtx";
+    return fileName.size() >= extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void NativeVertexFileWriter::writeVertexes(std::vector<Vertex *> &vertexes)
+{
+    for (auto vertex : vertexes)
+    {
+        index.push_back(vertex->getIndex());
+        X.push_back(vertex->getX());
+        Y.push_back(vertex->getY());
+        Z.push_back(vertex->getZ());
+        for (u_int t = 0; t < vertex->getDaughterTracksCount(); t++)
+        {
+            daughters.push_back(vertex->getDaughterTrack(t)->getIndex());
+        }
+        daughtersBegin.push_back(daughters.size());
+        for (u_int t = 0; t < vertex->getParentTracksCount(); t++)
+        {
+            parents.push_back(vertex->getParentTrack(t)->getIndex());
+        }
+        parentsBegin.push_back(parents.size());
+    }
+}
+
+bool NativeVertexFileWriter::close()
+{
+    if (closed)
+        return true;
+    closed = true;
+
+    VertexFileHeader header = {};
+    std::memcpy(header.magic, VERTEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = VERTEX_FILE_VERSION;
+    header.vertexesCount = index.size();
+    header.daughtersCount = daughters.size();
+    header.parentsCount = parents.size();
+
+    const size_t columnsSizes[8] = {index.size() * sizeof(uint64_t), X.size() * sizeof(float), Y.size() * sizeof(float), Z.size() * sizeof(float),
+                                    daughtersBegin.size() * sizeof(uint64_t), daughters.size() * sizeof(uint64_t),
+                                    parentsBegin.size() * sizeof(uint64_t), parents.size() * sizeof(uint64_t)};
+    uint64_t offset = sizeof(VertexFileHeader);
+    for (int c = 0; c < 8; c++)
+    {
+        header.columnOffsets[c] = offset = alignOffset(offset);
+        offset += columnsSizes[c];
+    }
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeColumn(file, header.columnOffsets[0], index);
+    writeColumn(file, header.columnOffsets[1], X);
+    writeColumn(file, header.columnOffsets[2], Y);
+    writeColumn(file, header.columnOffsets[3], Z);
+    writeColumn(file, header.columnOffsets[4], daughtersBegin);
+    writeColumn(file, header.columnOffsets[5], daughters);
+    writeColumn(file, header.columnOffsets[6], parentsBegin);
+    writeColumn(file, header.columnOffsets[7], parents);
+    file.seekp(0, std::ios::end);
+    if (offset > (uint64_t)file.tellp()) // empty last columns must still fit into the file
+    {
+        file.seekp(offset - 1);
+        file.put(0);
+    }
+    file.close();
+    if (file.fail())
+    {
+        printf("ERROR - could not write native vertex file %s \n", fileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+MappedVertexFile::MappedVertexFile(const std::string &fileName)
+{
+    int descriptor = open(fileName.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("ERROR - could not open native vertex file " + fileName);
+    }
+    struct stat fileStat;
+    if (fstat(descriptor, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(VertexFileHeader))
+    {
+        close(descriptor);
+        throw std::invalid_argument("ERROR - file is too small for native vertex file " + fileName);
+    }
+    dataSize = fileStat.st_size;
+    void *mapped = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor); // mapping keeps the file
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("ERROR - could not map native vertex file " + fileName);
+    }
+    data = static_cast<const char *>(mapped);
+    header = reinterpret_cast<const VertexFileHeader *>(data);
+
+    std::string error;
+    if (std::memcmp(header->magic, VERTEX_FILE_MAGIC, sizeof(header->magic)) != 0)
+        error = "is not a native vertex file";
+    else if (header->version != VERTEX_FILE_VERSION)
+        error = "has unsupported version " + std::to_string(header->version);
+    for (int c = 0; c < 8 && error.empty(); c++)
+    {
+        uint64_t count = c < 4 ? header->vertexesCount : c == 5 ? header->daughtersCount : c == 7 ? header->parentsCount : header->vertexesCount + 1;
+        size_t columnSize = count * (c == 1 || c == 2 || c == 3 ? sizeof(float) : sizeof(uint64_t));
+        auto offset = header->columnOffsets[c];
+        if (offset < sizeof(VertexFileHeader) || offset % COLUMN_ALIGNMENT != 0 || offset + columnSize > dataSize)
+            error = "is truncated or has wrong columns offsets";
+    }
+    for (int c = 4; c <= 6 && error.empty(); c += 2) // tracks lists must lie inside the daughters and parents columns
+    {
+        auto begin = getColumn<uint64_t>(c);
+        auto count = c == 4 ? header->daughtersCount : header->parentsCount;
+        if (begin[0] != 0 || !std::is_sorted(begin, begin + header->vertexesCount + 1) || begin[header->vertexesCount] != count)
+            error = "has wrong tracks lists";
+    }
+    if (!error.empty())
+    {
+        munmap(mapped, dataSize);
+        throw std::invalid_argument("ERROR - file " + fileName + " " + error + ".");
+    }
+}
+
+MappedVertexFile::~MappedVertexFile()
+{
+    munmap(const_cast<char *>(data), dataSize);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../data_types/Vertex.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header of the native vertex file (.vtx). File is little-endian: header, then vertexes table columns index (uint64),
+ * X, Y, Z (float), daughtersBegin (uint64, vertexesCount + 1 entries), daughters (uint64, input track indexes of all vertexes one after
+ * another), parentsBegin and parents in the same way. Tracks of the vertex v are [daughtersBegin[v], daughtersBegin[v + 1]).
+ * Each column starts at the 64 bytes aligned offset, so it could be used in place from the memory mapped file.
+ */
+struct VertexFileHeader
+{
+    char magic[8];             // VERTEX_FILE_MAGIC
+    uint32_t version;          // VERTEX_FILE_VERSION
+    uint32_t reserved0;
+    uint64_t vertexesCount;
+    uint64_t daughtersCount;
+    uint64_t parentsCount;
+    uint64_t columnOffsets[8]; // index, X, Y, Z, daughtersBegin, daughters, parentsBegin, parents
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(VertexFileHeader) == 128, "Vertex file header layout must not change within the version.");
+
+inline constexpr char VERTEX_FILE_MAGIC[8] = {'D', 'S', 'T', 'A', 'U', 'V', 'T', 'X'};
+inline constexpr uint32_t VERTEX_FILE_VERSION = 1;
+
+/** @brief True if the file name has the native vertex file extension .vtx. */
+bool isNativeVertexFile(const std::string &fileName);
+
+/**
+ * @brief Collects vertexes table and daughter indexes, possibly in several calls (streaming search), and writes the native vertex file
+ * at close. Only indexes are copied, so vertexes could be released right after writeVertexes.
+ */
+class NativeVertexFileWriter
+{
+private:
+    std::string fileName;
+    std::vector<uint64_t> index;
+    std::vector<float> X, Y, Z;
+    std::vector<uint64_t> daughtersBegin{0}, daughters;
+    std::vector<uint64_t> parentsBegin{0}, parents;
+    bool closed = false;
+
+public:
+    void writeVertexes(std::vector<Vertex *> &vertexes);
+
+    /** @brief Write the file.
+     * @returns true if file was written succesfully.
+     */
+    bool close();
+
+    const std::string &getFileName() const { return fileName; }
+
+public:
+    NativeVertexFileWriter(const std::string &fileName) : fileName(fileName) {}
+
+    virtual ~NativeVertexFileWriter() { close(); }
+
+    NativeVertexFileWriter(const NativeVertexFileWriter &) = delete;
+    NativeVertexFileWriter &operator=(const NativeVertexFileWriter &) = delete;
+};
+
+/**
+ * @brief Native vertex file mapped to memory read only, the reader for analysis joining vertexes back to input tracks.
+ * Columns point directly to the mapped pages.
+ */
+class MappedVertexFile
+{
+private:
+    const VertexFileHeader *header = nullptr;
+    const char *data = nullptr;
+    size_t dataSize = 0;
+
+    template <class T>
+    const T *getColumn(int column) const { return reinterpret_cast<const T *>(data + header->columnOffsets[column]); }
+
+public:
+    size_t size() const { return header->vertexesCount; }
+
+    const uint64_t *getIndex() const { return getColumn<uint64_t>(0); }
+    const float *getX() const { return getColumn<float>(1); }
+    const float *getY() const { return getColumn<float>(2); }
+    const float *getZ() const { return getColumn<float>(3); }
+
+    u_int getDaughtersCount(size_t vertex) const { return getColumn<uint64_t>(4)[vertex + 1] - getColumn<uint64_t>(4)[vertex]; }
+
+    /** @brief Input track indexes of the vertex daughters, getDaughtersCount of them. */
+    const uint64_t *getDaughters(size_t vertex) const { return getColumn<uint64_t>(5) + getColumn<uint64_t>(4)[vertex]; }
+
+    u_int getParentsCount(size_t vertex) const { return getColumn<uint64_t>(6)[vertex + 1] - getColumn<uint64_t>(6)[vertex]; }
+
+    /** @brief Input track indexes of the vertex parents (secondary vertexes only), getParentsCount of them. */
+    const uint64_t *getParents(size_t vertex) const { return getColumn<uint64_t>(7) + getColumn<uint64_t>(6)[vertex]; }
+
+public:
+    /** @throws std::runtime_error if file could not be mapped, std::invalid_argument if it is not a native vertex file of this version. */
+    MappedVertexFile(const std::string &fileName);
+
+    virtual ~MappedVertexFile();
+
+    MappedVertexFile(const MappedVertexFile &) = delete;
+    MappedVertexFile &operator=(const MappedVertexFile &) = delete;
+};
@@ -0,0 +1,120 @@
+#include "VertexTreeWriter.hpp"
+
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace
+{
+    const size_t WRITER_BATCH_VERTEXES = 8192;   // vertexes copied before passing them to the writer thread
+    const size_t WRITER_QUEUE_BATCHES = 8;       // full batches waiting for writing, search waits if writer is behind
+    const Int_t VERTEX_TREE_BASKET_SIZE = 256000; // bytes, large baskets for sequential reading of whole columns
+    const Int_t VERTEX_TREE_COMPRESSION = 404;   // LZ4 level 4, fast to write and to read back
+}
+
+void VertexTreeWriter::writeVertexes(std::vector<Vertex *> &vertexes)
+{
+    if (closed)
+    {
+        succeeded = false;
+        return;
+    }
+
+    for (auto vertex : vertexes)
+    {
+        currentBatch.index.push_back(vertex->getIndex());
+        currentBatch.X.push_back(vertex->getX());
+        currentBatch.Y.push_back(vertex->getY());
+        currentBatch.Z.push_back(vertex->getZ());
+        currentBatch.daughtersCount.push_back(vertex->getDaughterTracksCount());
+        for (u_int t = 0; t < vertex->getDaughterTracksCount(); t++)
+        {
+            currentBatch.daughterIndexes.push_back(vertex->getDaughterTrack(t)->getIndex());
+        }
+
+        if (currentBatch.size() == WRITER_BATCH_VERTEXES)
+        {
+            batches.push(std::move(currentBatch));
+            currentBatch = VertexesBatch();
+        }
+    }
+}
+
+void VertexTreeWriter::writeBatches()
+{
+    std::unique_ptr<TFile> file(TFile::Open(fileName.data(), "recreate"));
+    if (!file || file->IsZombie())
+    {
+        printf("ERROR - could not create vertexes file %s \n", fileName.c_str());
+        succeeded = false;
+        while (batches.pop().has_value()) // release the search waiting for the queue
+            ;
+        return;
+    }
+    file->SetCompressionSettings(VERTEX_TREE_COMPRESSION);
+
+    auto tree = new TTree("VertexTree", "VertexTree"); // owned by file
+    ULong64_t index;
+    Float_t position[3];
+    Int_t daughtersCount;
+    std::vector<Long64_t> daughterIndexes(1);
+    tree->Branch("vID", &index, "vID/l", VERTEX_TREE_BASKET_SIZE);
+    tree->Branch("position", position, "position[3]/F", VERTEX_TREE_BASKET_SIZE);
+    tree->Branch("ndau", &daughtersCount, "ndau/I", VERTEX_TREE_BASKET_SIZE);
+    tree->Branch("dau_id", daughterIndexes.data(), "dau_id[ndau]/L", VERTEX_TREE_BASKET_SIZE);
+
+    while (auto batch = batches.pop())
+    {
+        size_t daughtersBegin = 0;
+        for (size_t v = 0; v < batch->size(); v++)
+        {
+            index = batch->index[v];
+            position[0] = batch->X[v];
+            position[1] = batch->Y[v];
+            position[2] = batch->Z[v];
+            daughtersCount = batch->daughtersCount[v];
+            if ((size_t)daughtersCount > daughterIndexes.size())
+            {
+                daughterIndexes.resize(daughtersCount);
+                tree->SetBranchAddress("dau_id", daughterIndexes.data());
+            }
+            std::copy(batch->daughterIndexes.begin() + daughtersBegin, batch->daughterIndexes.begin() + daughtersBegin + daughtersCount, daughterIndexes.begin());
+            daughtersBegin += daughtersCount;
+
+            if (tree->Fill() < 0)
+                succeeded = false;
+        }
+    }
+
+    if (tree->Write() <= 0)
+        succeeded = false;
+    file->Close();
+}
+
+bool VertexTreeWriter::close()
+{
+    if (!closed)
+    {
+        closed = true;
+        if (currentBatch.size() != 0)
+            batches.push(std::move(currentBatch));
+        batches.close();
+        writerThread.join();
+    }
+    return succeeded;
+}
+
+VertexTreeWriter::VertexTreeWriter(const std::string &fileName) : fileName(fileName), batches(WRITER_QUEUE_BATCHES)
+{
+    ROOT::EnableThreadSafety(); // the search thread keeps using ROOT while the tree is written
+    writerThread = std::thread(&VertexTreeWriter::writeBatches, this);
+}
+
+VertexTreeWriter::~VertexTreeWriter()
+{
+    close();
+}
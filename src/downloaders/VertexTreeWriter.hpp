@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../data_types/Vertex.hpp"
+#include "../utility/BoundedQueue.hpp"
+
+#include <Rtypes.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Writes vertexes to ROOT file as VertexTree with branches vID, position[3], ndau and dau_id[ndau] (daughter tracks indexes).
+ * Vertexes are copied by the caller thread into batches, and a background thread fills and writes the tree, so writing overlaps
+ * with the search. Vertexes pointers may become invalid right after writeVertexes returns.
+ */
+class VertexTreeWriter
+{
+private:
+    /* Vertexes columns, daughter indexes of all vertexes are stored one after another. */
+    struct VertexesBatch
+    {
+        std::vector<ULong64_t> index;
+        std::vector<Float_t> X, Y, Z;
+        std::vector<Int_t> daughtersCount;
+        std::vector<Long64_t> daughterIndexes;
+
+        size_t size() const { return index.size(); }
+    };
+
+    std::string fileName;
+    VertexesBatch currentBatch;
+    BoundedQueue<VertexesBatch> batches;
+    std::thread writerThread;
+    std::atomic<bool> succeeded{true};
+    bool closed = false;
+
+    void writeBatches();
+
+public:
+    /** @brief Copy vertexes to the current batch, full batch is passed to the writer thread. */
+    void writeVertexes(std::vector<Vertex *> &vertexes);
+
+    /** @brief Pass the last batch, wait until the tree is written and close the file.
+     * @returns true if file was written succesfully.
+     */
+    bool close();
+
+    const std::string &getFileName() const { return fileName; }
+
+public:
+    /** @brief Recreate the file, it is opened by the writer thread. */
+    VertexTreeWriter(const std::string &fileName);
+
+    virtual ~VertexTreeWriter();
+
+    VertexTreeWriter(const VertexTreeWriter &) = delete;
+    VertexTreeWriter &operator=(const VertexTreeWriter &) = delete;
+};
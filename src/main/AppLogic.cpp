@@ -1,31 +1,45 @@
 #include "AppLogic.hpp"
+#include "BrickPipeline.hpp"
 
 #include <string>
 #include <memory>
-#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <exception>
+#include <thread>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <utility>
 
 #include "../detector/DetectorVolume.hpp"
 #include "../downloaders/FedraDownloader.hpp"
 #include "../utility/CalculationAndAlgorithms.hpp"
 #include "../utility/Histograming.hpp"
+#include "../utility/BoundedQueue.hpp"
+#include "../utility/Metrics.hpp"
 #include "../vertex_search/VertexSearcher.hpp"
+#include "../vertex_search/ZWindowVertexSearcher.hpp"
+#include "../vertex_search/TrackPrefilter.hpp"
 #include "../vertex_processing/VertexProcessor.hpp"
 #include "../data_types/DataObject.hpp"
 #include "../data_types/Track.hpp"
 
 #include "TApplication.h"
+#include "TROOT.h"
 
 namespace
 {
     // ================= PARAMETERS ======================================================================
 
-    const std::string TRACKS_FILE_NAME = "~/Vertexing/resources/downloaded_tracks.root";
+    const std::string TRACKS_FILE_NAME = "~/Vertexing/resources/downloaded_tracks.root"; // or native .trk file, see TrackFileConverter
     const std::string VERTEXES_ROOT_FILE_NAME = "~/Vertexing/vertexes.root";
     const std::string VERTEXES_TEXT_FILE_NAME = "processed_vertexes.txt"; // file will be created in project build directory
-    const int VOLUME_DIMENSION = 20000;                                   // microns
-    const float STRAIGHT_TRACK_ANGLE_CUT = 0.02;                          // radian
+    const std::string VERTEXES_NATIVE_FILE_NAME = "processed_vertexes.vtx"; // vertexes table with daughter tracks indexes, see NativeVertexFile
     const bool HISTOGRAMING = true;
-    const bool CUT_DIRECT_TRACKS = true;
+    const u_long STREAM_CHUNK_TRACKS = 100000;                            // tracks read from file at once in streaming mode
+    const size_t LOAD_QUEUE_CHUNKS = 4;                                   // chunks read ahead of the detector volume filling
+    // Straight tracks cut and search cuts are in SearchConfig, volume dimension and load chunk are in BrickPipeline.hpp
 
     // ===================================================================================================
 
@@ -40,83 +54,154 @@ namespace
 
     // ===================================================================================================
 
-    std::chrono::time_point<std::chrono::_V2::system_clock, std::chrono::_V2::system_clock::duration> start_time;
-    std::chrono::time_point<std::chrono::_V2::system_clock, std::chrono::_V2::system_clock::duration> end_time;
-
-    void startTimer(std::string message)
+    /* Stop the stage timer, its time is added to the metrics registry and printed with the message. */
+    void printStageTime(ScopedTimer &timer, const std::string &message)
     {
-        start_time = std::chrono::high_resolution_clock::now();
-        printf("%s \n", message.c_str());
+        printf("%s in %.0f ms \n", message.c_str(), timer.stop());
     }
-    void stopTimer(std::string message)
+
+    /* Vertexes files of the brick in batch mode are created next to its tracks file. */
+    std::string createBrickOutputFileName(const std::string &tracksFileName, const std::string &extension)
     {
-        end_time = std::chrono::high_resolution_clock::now();
-        auto measured_time = end_time - start_time;
-        printf("%s in %lu ms \n", message.c_str(), measured_time / std::chrono::milliseconds(1));
+        auto dot = tracksFileName.find_last_of('.');
+        auto slash = tracksFileName.find_last_of('/');
+        bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+        return (hasExtension ? tracksFileName.substr(0, dot) : tracksFileName) + "_vertexes" + extension;
     }
 
-    bool checkTrackAngleLessThanCut(Track *track, float angleCut)
+    /* Move the rejected tracks from the end of prefiltered vector. */
+    std::vector<Track> takeRejectedTracks(std::vector<Track> &tracks, size_t passedCount)
     {
-        return atan(sqrt(track->getTanX() * track->getTanX() + track->getTanY() * track->getTanY())) < angleCut;
+        std::vector<Track> rejectedTracks(std::make_move_iterator(tracks.begin() + passedCount), std::make_move_iterator(tracks.end()));
+        tracks.erase(tracks.begin() + passedCount, tracks.end());
+        return rejectedTracks;
     }
 }
 
-void AppLogic::findVertexes()
+void AppLogic::loadDetectorVolume(std::vector<Track> &tracksStraightLeft)
 {
-    startTimer("Start downloading from file...");
-    auto &tracks = downloader->downloadTracksFromFile(TRACKS_FILE_NAME); // download tracks from linked_tracks file
-
-    std::string trackVectorSize = std::to_string(tracks.size());
-    std::string downloadRes = "Downloaded " + trackVectorSize + " tracks from linked_tracks.root";
-    stopTimer(downloadRes);
-
-    auto tracksCount = tracks.size();
+    auto tracksCount = downloader->countTracksInFile(tracksFileName);
     auto cellSize = calculationAlgorithms.calculateCellSizeFromTracksCount(VOLUME_DIMENSION, tracksCount);
 
     if (!detectorVolume)
         detectorVolume = std::make_unique<DetectorVolume>(VOLUME_DIMENSION, cellSize);
     printf("Created detector volume with cell of size %i microns. \n", cellSize);
 
-    std::vector<Track> withStraightTracksExcluded;
-    std::vector<Track> tracksStraightLeft;
-    if (CUT_DIRECT_TRACKS)
-    {
-        for (auto track : tracks)
+    // Loader thread reads and prefilters chunks while this one bins the previous chunks into detector cells.
+    printf("Start downloading from file to detector object... \n");
+    ScopedTimer loadTimer("load");
+    ROOT::EnableThreadSafety();
+    BoundedQueue<std::pair<std::vector<Track>, size_t>> chunks(LOAD_QUEUE_CHUNKS); // tracks and passed tracks count
+    std::exception_ptr loadError;
+    auto prefilter = createPrefilter(config);
+    std::thread loader([&]()
+                       {
+        try
         {
-            if (!checkTrackAngleLessThanCut(&track, STRAIGHT_TRACK_ANGLE_CUT))
+            if (regionOfInterest)
             {
-                withStraightTracksExcluded.emplace_back(track);
+                auto &region = *regionOfInterest;
+                auto haloXY = config.getSearchHaloXY(), haloZ = config.getSearchHaloZ();
+                auto tracks = downloader->downloadTracksFromFileInRegion(tracksFileName, region.minX - haloXY, region.maxX + haloXY, region.minY - haloXY,
+                                                                         region.maxY + haloXY, region.minZ - haloZ, region.maxZ + haloZ);
+                auto passedCount = prefilter.partition(tracks);
+                chunks.push({std::move(tracks), passedCount});
             }
             else
             {
-                tracksStraightLeft.emplace_back(track);
+                downloader->downloadTracksFromFileInChunks(
+                    tracksFileName, LOAD_CHUNK_TRACKS, [&chunks](std::vector<Track> &&chunk, size_t passedCount)
+                    { chunks.push({std::move(chunk), passedCount}); },
+                    createColumnsPartition(prefilter), true);
             }
         }
-        printf("Straight tracks with angle < %g were excluded from search. %li tracks left. \n", STRAIGHT_TRACK_ANGLE_CUT, withStraightTracksExcluded.size());
+        catch (...)
+        {
+            loadError = std::current_exception();
+        }
+        chunks.close(); });
+
+    u_long searchedTracksCount = 0;
+    try
+    {
+        while (auto chunk = chunks.pop())
+        {
+            auto rejectedTracks = takeRejectedTracks(chunk->first, chunk->second);
+            tracksStraightLeft.insert(tracksStraightLeft.end(), std::make_move_iterator(rejectedTracks.begin()), std::make_move_iterator(rejectedTracks.end()));
+            searchedTracksCount += chunk->first.size();
+            detectorVolume->addTracks(std::move(chunk->first)); // move to detector volume object
+        }
+    }
+    catch (...)
+    {
+        chunks.close(); // loader stops at the next chunk
+        loader.join();
+        throw;
+    }
+    loader.join();
+    if (loadError)
+    {
+        std::rethrow_exception(loadError);
+    }
+    prefilter.addCutFlowToMetrics();
+    auto downloadedTracksCount = searchedTracksCount + tracksStraightLeft.size();
+    printStageTime(loadTimer, "Downloaded " + std::to_string(downloadedTracksCount) + " tracks from " + tracksFileName + " to in memory detector volume object");
 
-        startTimer("Start downloading to detector object...");
-        detectorVolume->addTracks(std::move(withStraightTracksExcluded)); // move to detector volume object
-        stopTimer("Tracks were downloaded to in memory detector volume object");
+    if (config.cutDirectTracks)
+    {
+        printf("Straight tracks with angle < %g were excluded from search. %lu tracks left. \n", config.straightTrackAngleCut, searchedTracksCount);
+    }
+}
+
+void AppLogic::findVertexes()
+{
+    MetricsScope brickScope(tracksFileName);
+    vertexSearcher.setConfig(config);
+
+    std::vector<Track> tracksStraightLeft;
+    if (!volumeSnapshotFileName.empty() && std::ifstream(volumeSnapshotFileName).good())
+    {
+        printf("Start restoring detector volume from snapshot... \n");
+        ScopedTimer restoreTimer("restoreSnapshot");
+        detectorVolume = DetectorVolume::restoreSnapshot(volumeSnapshotFileName);
+        printStageTime(restoreTimer, "Restored " + std::to_string(detectorVolume->getTracksCount()) + " tracks from " + volumeSnapshotFileName);
     }
     else
     {
-        startTimer("Start downloading to detector object...");
-        detectorVolume->addTracks(std::move(tracks)); // move to detector volume object
-        stopTimer("Tracks were downloaded to in memory detector volume object");
+        loadDetectorVolume(tracksStraightLeft);
+        if (!volumeSnapshotFileName.empty())
+        {
+            printf("Start writing detector volume snapshot... \n");
+            ScopedTimer snapshotTimer("writeSnapshot");
+            detectorVolume->writeSnapshot(volumeSnapshotFileName);
+            printStageTime(snapshotTimer, "Detector volume snapshot written to " + volumeSnapshotFileName);
+        }
     }
 
     printf("\n");
 
-    startTimer("Start searching vertexes...");
+    detectorVolume->setIndexStatisticsEnabled(indexStatisticsEnabled);
+    printf("Start searching vertexes... \n");
+    ScopedTimer searchTimer("search");
     vertexSearcher.searchVertexes(*detectorVolume.get()); // <<<====================== search vertexes
 
     std::string searchRes = "Searching vertexes succesfully finished. ";
     auto vertexesVecBefore = detectorVolume->getAllVertexes();
     std::string vertexesSizeStr = std::to_string(vertexesVecBefore.size());
     std::string resBefore = searchRes + ", vertexes count " + vertexesSizeStr + " pieces";
-    stopTimer(resBefore);
+    printStageTime(searchTimer, resBefore);
+    detectorVolume->reportIndexStatistics();
 
     auto vertexPtrs = detectorVolume->getAllVertexes();
+    if (regionOfInterest)
+    {
+        auto &region = *regionOfInterest;
+        vertexPtrs.erase(std::remove_if(vertexPtrs.begin(), vertexPtrs.end(), [&region](Vertex *vertex)
+                                        { return vertex->getX() < region.minX || vertex->getX() > region.maxX || vertex->getY() < region.minY ||
+                                                 vertex->getY() > region.maxY || vertex->getZ() < region.minZ || vertex->getZ() > region.maxZ; }),
+                         vertexPtrs.end());
+        printf("%lu vertexes are in the region of interest. \n", vertexPtrs.size());
+    }
 
     if (HISTOGRAMING)
     {
@@ -127,25 +212,155 @@ void AppLogic::findVertexes()
     printf("Processing is over. \n");
     printf("\n");
 
-    startTimer("Start downloading to file... ");
-    auto succesfullyDownloaded = downloader->downloadVertexesToFile(VERTEXES_TEXT_FILE_NAME, vertexPtrs);
+    printf("Start downloading to file... \n");
+    ScopedTimer writeTimer("write");
+    auto succesfullyDownloaded = downloader->downloadVertexesToFile(VERTEXES_ROOT_FILE_NAME, vertexPtrs); // tree is written in background
+    succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_TEXT_FILE_NAME, vertexPtrs);
+    succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_NATIVE_FILE_NAME, vertexPtrs);
+    succesfullyDownloaded &= downloader->finishVertexesWriting();
     if (succesfullyDownloaded)
     {
-        stopTimer("Vertexes file has been created in the project build directory ");
+        printStageTime(writeTimer, "Vertexes file has been created in the project build directory ");
     }
     else
     {
-        stopTimer("ERROR in vertexes file writing!!!");
+        printStageTime(writeTimer, "ERROR in vertexes file writing!!!");
     }
 
-    if (CUT_DIRECT_TRACKS)
+    if (config.cutDirectTracks)
     {
-        detectorVolume->addTracks(tracksStraightLeft);
+        detectorVolume->addTracks(std::move(tracksStraightLeft));
+        detectorVolume->clearDirtyCells(); // straight tracks are not searched by the next incremental search
         printf("Straight tracks was added back to the detector volume. \n");
     }
 }
 
-AppLogic::AppLogic(std::unique_ptr<IDownloader> downloader)
+void AppLogic::updateVertexes(std::vector<Track> &&newTracks)
+{
+    if (!detectorVolume)
+    {
+        throw std::logic_error("ERROR - vertexes could be updated only after the detector volume was created by findVertexes.");
+    }
+
+    MetricsScope brickScope(tracksFileName);
+    auto prefilter = createPrefilter(config);
+    auto tracksStraightLeft = takeRejectedTracks(newTracks, prefilter.partition(newTracks));
+    prefilter.addCutFlowToMetrics();
+
+    printf("Start updating vertexes with %lu new tracks... \n", newTracks.size());
+    ScopedTimer updateTimer("update");
+    detectorVolume->addTracks(std::move(newTracks));
+    vertexSearcher.searchVertexesIncremental(*detectorVolume.get());
+    printStageTime(updateTimer, "Vertexes updated, vertexes count " + std::to_string(detectorVolume->getAllVertexes().size()) + " pieces");
+
+    if (config.cutDirectTracks)
+    {
+        detectorVolume->addTracks(std::move(tracksStraightLeft));
+        detectorVolume->clearDirtyCells();
+    }
+}
+
+void AppLogic::findVertexesStreaming()
+{
+    MetricsScope brickScope(tracksFileName);
+    vertexSearcher.setConfig(config);
+
+    auto tracksCount = downloader->countTracksInFile(tracksFileName);
+    auto cellSize = calculationAlgorithms.calculateCellSizeFromTracksCount(VOLUME_DIMENSION, tracksCount);
+    auto windowDepth = ZWindowVertexSearcher::calculateWindowDepth(config, cellSize);
+
+    detectorVolume = std::make_unique<DetectorVolume>(VOLUME_DIMENSION, cellSize, windowDepth);
+    detectorVolume->setIndexStatisticsEnabled(indexStatisticsEnabled);
+    printf("Created detector volume Z window of depth %u microns with cell of size %i microns for %lu tracks. \n", windowDepth, cellSize, tracksCount);
+
+    std::vector<Vertex *> noVertexes;
+    // recreate files, vertexes are appended, ROOT file is written in background while searching
+    bool succesfullyDownloaded = downloader->downloadVertexesToFile(VERTEXES_TEXT_FILE_NAME, noVertexes);
+    succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_ROOT_FILE_NAME, noVertexes);
+    succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_NATIVE_FILE_NAME, noVertexes);
+    ZWindowVertexSearcher windowSearcher(*detectorVolume.get(), vertexSearcher, [&](std::vector<Vertex *> &vertexes)
+                                         {
+                                             succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_ROOT_FILE_NAME, vertexes, true);
+                                             succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_TEXT_FILE_NAME, vertexes, true);
+                                             succesfullyDownloaded &= downloader->downloadVertexesToFile(VERTEXES_NATIVE_FILE_NAME, vertexes, true); });
+
+    printf("Start streaming vertexes search... \n");
+    ScopedTimer streamingTimer("streamingSearch");
+    auto prefilter = createPrefilter(config);
+    downloader->downloadTracksFromFileSortedByZ(
+        tracksFileName, STREAM_CHUNK_TRACKS, [&](std::vector<Track> &&tracks, size_t)
+        { windowSearcher.addTracks(std::move(tracks)); },
+        createColumnsPartition(prefilter), false);
+    windowSearcher.finish();
+    prefilter.addCutFlowToMetrics();
+    succesfullyDownloaded &= downloader->finishVertexesWriting();
+    printStageTime(streamingTimer, "Streaming search finished, vertexes count " + std::to_string(windowSearcher.getEmittedVertexesCount()) + " pieces");
+
+    if (config.cutDirectTracks)
+    {
+        printf("Straight tracks with angle < %g were excluded from search, %lu pieces. \n", config.straightTrackAngleCut, prefilter.getRejectedCount(0));
+    }
+    if (!succesfullyDownloaded)
+    {
+        printf("ERROR in vertexes file writing!!! \n");
+    }
+
+    detectorVolume->reportIndexStatistics(); // occupancy of the last window
+    detectorVolume.reset(); // window has passed the whole volume
+}
+
+AppLogic::AppLogic(std::unique_ptr<IDownloader> downloader, const SearchConfig &config)
 {
     this->downloader = std::move(downloader);
+    this->config = config;
+    tracksFileName = TRACKS_FILE_NAME;
+}
+
+u_int AppLogic::findVertexesBatch(const std::vector<std::string> &tracksFileNames, u_int workersCount,
+                                  const std::function<std::unique_ptr<IDownloader>(u_int threadsCount)> &createDownloader)
+{
+    ROOT::EnableThreadSafety();
+    workersCount = std::max<u_int>(1, std::min<size_t>(workersCount, tracksFileNames.size()));
+    u_int workerThreadsCount = std::max(1u, std::thread::hardware_concurrency() / workersCount);
+    printf("Start batch processing of %lu bricks by %u workers... \n", tracksFileNames.size(), workersCount);
+    ScopedTimer batchTimer("batch");
+
+    std::atomic<size_t> nextBrick{0};
+    std::atomic<u_int> failedCount{0};
+    std::mutex printMutex;
+    auto worker = [&]()
+    {
+        auto workerDownloader = createDownloader(workerThreadsCount);
+        for (size_t b = nextBrick++; b < tracksFileNames.size(); b = nextBrick++)
+        {
+            try
+            {
+                MetricsScope brickScope(tracksFileNames[b]);
+                auto result = processBrick(*workerDownloader, config, tracksFileNames[b],
+                                           {createBrickOutputFileName(tracksFileNames[b], ".txt"),
+                                            createBrickOutputFileName(tracksFileNames[b], ".vtx")},
+                                           indexStatisticsEnabled);
+                std::lock_guard<std::mutex> lock(printMutex);
+                printf("Brick %s processed, vertexes count %lu pieces. \n", tracksFileNames[b].c_str(), result.vertexesCount);
+            }
+            catch (const std::exception &exception)
+            {
+                failedCount++;
+                std::lock_guard<std::mutex> lock(printMutex);
+                printf("ERROR in brick %s processing: %s \n", tracksFileNames[b].c_str(), exception.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (u_int w = 0; w < workersCount; w++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (auto &workerThread : workers)
+    {
+        workerThread.join();
+    }
+    printStageTime(batchTimer, "Batch processing finished, " + std::to_string(failedCount) + " of " + std::to_string(tracksFileNames.size()) + " bricks failed");
+    return failedCount;
 }
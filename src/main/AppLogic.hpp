@@ -1,18 +1,78 @@
 #pragma once
 #include "../downloaders/IDownloader.hpp"
+#include "../vertex_search/SearchConfig.hpp"
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 class AppLogic
 {
 private:
     std::unique_ptr<IDownloader> downloader;
+    SearchConfig config;
+    std::string tracksFileName;
+
+    struct RegionOfInterest
+    {
+        float minX, maxX, minY, maxY, minZ, maxZ;
+    };
+    std::optional<RegionOfInterest> regionOfInterest;
+    std::string volumeSnapshotFileName;
+    bool indexStatisticsEnabled = false;
+
+    /** @brief Create detector volume and fill it with tracks from file, tracks rejected by prefilter are moved to tracksStraightLeft. */
+    void loadDetectorVolume(std::vector<Track> &tracksStraightLeft);
 
 public:
     void findVertexes();
 
+    /** @brief Search vertexes in a brick larger than memory. Tracks are read sorted by Z and only a sliding Z window of the detector
+     * volume is kept, finalized vertexes are appended to the vertexes file as the window advances. Straight tracks are dropped and
+     * vertexes are not histogramed, because they are not kept in memory.
+     */
+    void findVertexesStreaming();
+
+    /** @brief Quick-look update after findVertexes: add the next batch of tracks (for example the next scanned plates) to the detector
+     * volume and search vertexes incrementally, only around the new tracks.
+     */
+    void updateVertexes(std::vector<Track> &&newTracks);
+
+    /** @brief Process many bricks in one process. Worker threads take tracks files from the shared queue, every brick is searched
+     * on its own detector volume and its vertexes are written next to its tracks file as <name>_vertexes.txt and <name>_vertexes.vtx.
+     * Histograms are not shown.
+     * @param createDownloader creates the downloader of one worker, downloaders keep state and are not shared between threads.
+     * Its argument is the worker share of the cores for writing vertexes files, so workers do not oversubscribe the machine.
+     * @returns count of bricks which failed to process.
+     */
+    u_int findVertexesBatch(const std::vector<std::string> &tracksFileNames, u_int workersCount,
+                            const std::function<std::unique_ptr<IDownloader>(u_int threadsCount)> &createDownloader);
+
+    /** @brief Read tracks from another file instead of the default one, ROOT or native track file (.trk). */
+    void setTracksFileName(const std::string &fileName) { tracksFileName = fileName; }
+
+    /** @brief findVertexes restores the filled detector volume from the snapshot file if it exists, otherwise writes the snapshot after
+     * tracks are loaded, so next runs with other search cuts skip reading and binning tracks. Straight tracks are not in the snapshot.
+     */
+    void setVolumeSnapshotFileName(const std::string &fileName) { volumeSnapshotFileName = fileName; }
+
+    /** @brief Collect detector volume index statistics (cells occupancy, cells visited and candidates per query) during the search,
+     * they are printed and added to the metrics after the search of every brick.
+     */
+    void setIndexStatisticsEnabled(bool enabled) { indexStatisticsEnabled = enabled; }
+
+    /** @brief findVertexes reads only tracks in the box and in the search halo around it, vertexes outside of the box are not written,
+     * so neighbour tiles do not repeat them. Native track file sorted by cells is read only around the box.
+     */
+    void setRegionOfInterest(float minX, float maxX, float minY, float maxY, float minZ, float maxZ)
+    {
+        regionOfInterest = RegionOfInterest{minX, maxX, minY, maxY, minZ, maxZ};
+    }
+
 public:
-    AppLogic(std::unique_ptr<IDownloader> downloader);
+    AppLogic(std::unique_ptr<IDownloader> downloader, const SearchConfig &config = SearchConfig());
 
     virtual ~AppLogic() {}
 
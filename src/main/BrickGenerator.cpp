@@ -0,0 +1,76 @@
+#include "../downloaders/NativeTrackFile.hpp"
+#include "../utility/CalculationAndAlgorithms.hpp"
+#include "../utility/SyntheticBrick.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+/* Generates the synthetic brick for load testing: native track file and native vertex file with the true vertexes.
+ * Usage: BrickGenerator <tracks.trk> <truth.vtx> [z|cell] [name=value ...]
+ * Parameters are the SyntheticBrickConfig fields, e.g. seed=7 tracksCount=1000000 backgroundFraction=0.9.
+ * The same parameters give the same files on any machine.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <tracks.trk> <truth.vtx> [z|cell] [name=value ...] \n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        SyntheticBrickConfig config;
+        std::string order;
+        for (int a = 3; a < argc; a++)
+        {
+            std::string argument = argv[a];
+            auto separator = argument.find('=');
+            if (separator != std::string::npos)
+            {
+                config.setParameter(argument.substr(0, separator), argument.substr(separator + 1));
+            }
+            else if (a == 3 && (argument == "z" || argument == "cell"))
+            {
+                order = argument;
+            }
+            else
+            {
+                printf("ERROR - unknown argument %s, expected z, cell or name=value. \n", argument.c_str());
+                return 1;
+            }
+        }
+
+        auto brick = generateSyntheticBrick(config);
+        printf("Generated %lu tracks and %lu vertexes with seed %u \n", brick.tracks.size(), brick.truthVertexes.size(), config.seed);
+
+        if (order == "z")
+        {
+            writeNativeTrackFile(argv[1], brick.tracks, TrackFileOrder::ByZ);
+        }
+        else if (order == "cell")
+        {
+            auto cellSize = CalculationAndAlgorithms::calculateCellSizeFromTracksCount(config.volumeDimension, brick.tracks.size());
+            writeNativeTrackFile(argv[1], brick.tracks, TrackFileOrder::ByCell, cellSize, config.volumeDimension);
+            printf("Tracks sorted by cells of size %u microns. \n", cellSize);
+        }
+        else
+        {
+            writeNativeTrackFile(argv[1], brick.tracks);
+        }
+
+        if (!brick.writeTruthVertexes(argv[2]))
+        {
+            printf("ERROR - could not write truth vertexes file %s \n", argv[2]);
+            return 1;
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        printf("%s \n", exception.what());
+        return 1;
+    }
+    printf("Native track file %s and truth vertexes file %s written. \n", argv[1], argv[2]);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "BrickPipeline.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "../detector/DetectorVolume.hpp"
+#include "../utility/CalculationAndAlgorithms.hpp"
+#include "../utility/Metrics.hpp"
+#include "../vertex_search/VertexSearcher.hpp"
+
+TrackPrefilter createPrefilter(const SearchConfig &config)
+{
+    TrackPrefilter prefilter;
+    if (config.cutDirectTracks)
+    {
+        prefilter.addSlopeCut(config.straightTrackAngleCut);
+    }
+    return prefilter;
+}
+
+ColumnsPartition createColumnsPartition(TrackPrefilter &prefilter)
+{
+    return [&prefilter](TrackColumns &chunkColumns)
+    { return prefilter.partition(chunkColumns); };
+}
+
+BrickPipelineResult processBrick(IDownloader &downloader, const SearchConfig &config, const std::string &tracksFileName,
+                                 const std::vector<std::string> &vertexesFileNames, bool indexStatisticsEnabled)
+{
+    BrickPipelineResult result;
+
+    ScopedTimer loadTimer("load");
+    auto cellSize = CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VOLUME_DIMENSION, downloader.countTracksInFile(tracksFileName));
+    DetectorVolume brickVolume(VOLUME_DIMENSION, cellSize);
+    brickVolume.setIndexStatisticsEnabled(indexStatisticsEnabled);
+
+    auto prefilter = createPrefilter(config);
+    downloader.downloadTracksFromFileInChunks(
+        tracksFileName, LOAD_CHUNK_TRACKS, [&](std::vector<Track> &&chunk, size_t)
+        { brickVolume.addTracks(std::move(chunk)); },
+        createColumnsPartition(prefilter), false);
+    prefilter.addCutFlowToMetrics();
+    result.loadMs = loadTimer.stop();
+
+    ScopedTimer searchTimer("search");
+    VertexSearcher brickSearcher(config);
+    brickSearcher.searchVertexes(brickVolume);
+    result.searchMs = searchTimer.stop();
+    result.testedPairs = brickSearcher.getTestedPairsCount();
+    brickVolume.reportIndexStatistics();
+
+    ScopedTimer writeTimer("write");
+    auto vertexes = brickVolume.getAllVertexes();
+    bool succesfullyDownloaded = true;
+    for (auto &vertexesFileName : vertexesFileNames)
+    {
+        succesfullyDownloaded &= downloader.downloadVertexesToFile(vertexesFileName, vertexes);
+    }
+    succesfullyDownloaded &= downloader.finishVertexesWriting();
+    if (!succesfullyDownloaded)
+    {
+        throw std::runtime_error("ERROR in vertexes files writing.");
+    }
+    result.writeMs = writeTimer.stop();
+    result.vertexesCount = vertexes.size();
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "../downloaders/IDownloader.hpp"
+#include "../vertex_search/SearchConfig.hpp"
+#include "../vertex_search/TrackPrefilter.hpp"
+
+#include <string>
+#include <vector>
+
+inline constexpr int VOLUME_DIMENSION = 20000;     // microns
+inline constexpr u_long LOAD_CHUNK_TRACKS = 65536; // tracks read at once while previous ones are added to detector
+
+/** @brief Cuts applied to tracks before the search, empty if there are no such cuts in the configuration. */
+TrackPrefilter createPrefilter(const SearchConfig &config);
+
+/** @brief Prefilter of the chunk columns read from file, tracks are partitioned before Track objects are created.
+ * The prefilter must outlive the partition.
+ */
+ColumnsPartition createColumnsPartition(TrackPrefilter &prefilter);
+
+/** @brief Stage times and results of one brick. */
+struct BrickPipelineResult
+{
+    double loadMs = 0, searchMs = 0, writeMs = 0;
+    u_long vertexesCount = 0, testedPairs = 0;
+};
+
+/**
+ * @brief Whole pipeline of one brick on its own detector volume and searcher: tracks are read in prefiltered chunks and binned,
+ * vertexes are searched and written to every vertexes file. Only one chunk exists besides the volume and rejected tracks are never
+ * created. Stage times are added to the metrics as load, search and write timers. Batch mode of AppLogic and the pipeline benchmark
+ * run it for every brick, so they measure the same work.
+ * @param downloader downloader of the calling thread, vertexes writing is finished before return.
+ * @throws std::runtime_error if vertexes files could not be written, exceptions of the downloader if tracks could not be read.
+ */
+BrickPipelineResult processBrick(IDownloader &downloader, const SearchConfig &config, const std::string &tracksFileName,
+                                 const std::vector<std::string> &vertexesFileNames, bool indexStatisticsEnabled = false);
@@ -4,8 +4,17 @@
 #include "../downloaders/IDownloader.hpp"
 #include "../vertex_search/VertexSearcher.hpp"
 #include "../downloaders/FedraDownloader.hpp"
+#include "../vertex_search/SearchConfig.hpp"
+#include "../utility/Metrics.hpp"
 
+#include <RConfigure.h>
+#include <TROOT.h>
+
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -15,8 +24,121 @@ int main(int argc, char **argv)
 
     unique_ptr<IDownloader> downloader(std::make_unique<FedraDownloader>());
 
-    unique_ptr<AppLogic> myApp(std::make_unique<AppLogic>(std::move(downloader)));
-    myApp->findVertexes();
+    // Optional arguments: the search config file, otherwise standard production cuts are used,
+    // --stream for bricks larger than memory, --tracks <file> to read another tracks file and
+    // --region <minX> <maxX> <minY> <maxY> <minZ> <maxZ> to search only in the box (microns),
+    // --snapshot <file> to restore filled detector volume from the file or to write it there,
+    // --batch <list file> to process all tracks files listed in the file (one per line) by --workers <count> threads,
+    // --metrics <file> to write stage timers and search counters at the end, as CSV if the file name ends with .csv, otherwise JSON,
+    // --index-stats to collect detector volume cells occupancy and queries cost
+    SearchConfig config;
+    bool streaming = false;
+    string tracksFileName;
+    vector<float> region;
+    string snapshotFileName;
+    string batchListFileName;
+    string metricsFileName;
+    bool indexStatistics = false;
+    unsigned workersCount = thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--stream")
+        {
+            streaming = true;
+            continue;
+        }
+        if (string(argv[i]) == "--tracks" && i + 1 < argc)
+        {
+            tracksFileName = argv[++i];
+            continue;
+        }
+        if (string(argv[i]) == "--region" && i + 6 < argc)
+        {
+            for (int c = 0; c < 6; c++)
+                region.push_back(stof(argv[++i]));
+            continue;
+        }
+        if (string(argv[i]) == "--snapshot" && i + 1 < argc)
+        {
+            snapshotFileName = argv[++i];
+            continue;
+        }
+        if (string(argv[i]) == "--batch" && i + 1 < argc)
+        {
+            batchListFileName = argv[++i];
+            continue;
+        }
+        if (string(argv[i]) == "--workers" && i + 1 < argc)
+        {
+            string count = argv[++i];
+            size_t parsedLength = 0;
+            try
+            {
+                workersCount = count[0] == '-' ? 0 : stoul(count, &parsedLength);
+            }
+            catch (const std::logic_error &)
+            {
+                workersCount = 0;
+            }
+            if (workersCount == 0 || parsedLength != count.size())
+            {
+                cout << "ERROR - wrong workers count " << count << ", usage: --batch <list file> --workers <count>, count > 0\n";
+                exit(1);
+            }
+            continue;
+        }
+        if (string(argv[i]) == "--index-stats")
+        {
+            indexStatistics = true;
+            continue;
+        }
+        if (string(argv[i]) == "--metrics" && i + 1 < argc)
+        {
+            metricsFileName = argv[++i];
+            continue;
+        }
+        config = SearchConfig::loadFromFile(argv[i]);
+        cout << "Search config loaded from " << argv[i] << "\n";
+    }
+
+#ifdef R__USE_IMT
+    // once for the process: tracks trees are read by tasks of the ROOT thread pool
+    ROOT::EnableImplicitMT();
+#endif
+
+    unique_ptr<AppLogic> myApp(std::make_unique<AppLogic>(std::move(downloader), config));
+    if (!tracksFileName.empty())
+        myApp->setTracksFileName(tracksFileName);
+    if (!region.empty())
+        myApp->setRegionOfInterest(region[0], region[1], region[2], region[3], region[4], region[5]);
+    if (!snapshotFileName.empty())
+        myApp->setVolumeSnapshotFileName(snapshotFileName);
+    myApp->setIndexStatisticsEnabled(indexStatistics);
+    int exitCode = 0;
+    if (!batchListFileName.empty())
+    {
+        ifstream listFile(batchListFileName);
+        if (!listFile.is_open())
+        {
+            cout << "ERROR - could not open bricks list " << batchListFileName << "\n";
+            exit(1);
+        }
+        vector<string> tracksFileNames;
+        for (string line; getline(listFile, line);)
+        {
+            if (!line.empty() && line[0] != '#')
+                tracksFileNames.push_back(line);
+        }
+        auto failedCount = myApp->findVertexesBatch(tracksFileNames, workersCount, [](u_int threadsCount)
+                                                    { return std::make_unique<FedraDownloader>(threadsCount); });
+        exitCode = failedCount == 0 ? 0 : 1;
+    }
+    else if (streaming)
+        myApp->findVertexesStreaming();
+    else
+        myApp->findVertexes();
 
-    exit(0);
+    if (!metricsFileName.empty() && !getMetrics().write(metricsFileName))
+        exitCode = 1;
+    exit(exitCode);
 }
@@ -0,0 +1,68 @@
+#include "../downloaders/FedraDownloader.hpp"
+#include "../downloaders/NativeTrackFile.hpp"
+#include "../utility/CalculationAndAlgorithms.hpp"
+
+#include <RConfigure.h>
+#include <TROOT.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    const u_int VOLUME_DIMENSION = 20000; // microns, the same as the search uses
+}
+
+/* Converts ROOT tracks file to the native track file, which the search maps to memory instead of deserializing.
+ * Usage: TrackFileConverter <tracks.root> <tracks.trk> [z|cell]
+ * z sorts tracks by Z for the streaming search, cell sorts them by detector cells of the size the search would choose.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3 || argc > 4)
+    {
+        printf("Usage: %s <tracks.root> <tracks.trk> [z|cell] \n", argv[0]);
+        return 1;
+    }
+    std::string order = argc == 4 ? argv[3] : "";
+    if (!order.empty() && order != "z" && order != "cell")
+    {
+        printf("ERROR - unknown tracks order %s, expected z or cell. \n", order.c_str());
+        return 1;
+    }
+
+#ifdef R__USE_IMT
+    ROOT::EnableImplicitMT(); // tracks tree clusters are read in parallel
+#endif
+
+    try
+    {
+        FedraDownloader downloader;
+        TrackColumns columns;
+        downloader.downloadTrackColumnsFromFile(argv[1], columns);
+        printf("Read %lu tracks from %s \n", columns.size(), argv[1]);
+
+        if (order == "z")
+        {
+            writeNativeTrackFile(argv[2], columns, TrackFileOrder::ByZ);
+        }
+        else if (order == "cell")
+        {
+            auto cellSize = CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VOLUME_DIMENSION, columns.size());
+            writeNativeTrackFile(argv[2], columns, TrackFileOrder::ByCell, cellSize, VOLUME_DIMENSION);
+            printf("Tracks sorted by cells of size %u microns. \n", cellSize);
+        }
+        else
+        {
+            writeNativeTrackFile(argv[2], columns);
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        printf("%s \n", exception.what());
+        return 1;
+    }
+    printf("Native track file %s written. \n", argv[2]);
+    return 0;
+}
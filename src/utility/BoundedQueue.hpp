@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief Queue between producer and consumer threads. Producer blocks when capacity is reached, so a slow consumer limits memory
+ * instead of letting items pile up. After close consumer gets the rest of items, then empty optional.
+ */
+template <class T>
+class BoundedQueue
+{
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull, notEmpty;
+
+public:
+    /** @brief Add item, wait while queue is full. Returns false if queue was closed and item was not added. */
+    bool push(T &&item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity || closed; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /** @brief Take item, wait while queue is empty. Returns empty optional if queue is closed and drained. */
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+            return std::nullopt;
+        std::optional<T> item(std::move(items.front()));
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    /** @brief No more items will be pushed, waiting threads wake up. */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+};
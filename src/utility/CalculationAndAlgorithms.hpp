@@ -1,13 +1,17 @@
 #pragma once
 
 #include "../data_types/Vertex.hpp"
+#include "../data_types/TrackBatch.hpp"
+#include "GeometryKernels.hpp"
 
 #include <Rtypes.h>
 #include <TVector3.h>
 #include <TMath.h>
 
 #include <cmath>
-#include <immintrin.h>
+#ifdef __AVX__
+#include "GeometryKernelsAVX.hpp"
+#endif
 
 class CalculationAndAlgorithms
 {
@@ -56,111 +60,77 @@ public:
         return cellDim;
     }
 
-    static __m256 crossProduct(__m256 vec1, __m256 vec2)
+    static void crossProduct(const float *vector1, const float *vector2, float *result)
     {
-        __m256 shuffle1 = _mm256_permute_ps(vec2, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 shuffle2 = _mm256_permute_ps(vec1, _MM_SHUFFLE(3, 1, 0, 2));
-        __m256 mul1 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        shuffle1 = _mm256_permute_ps(vec2, _MM_SHUFFLE(3, 1, 0, 2));
-        shuffle2 = _mm256_permute_ps(vec1, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 mul2 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        __m256 result = _mm256_sub_ps(mul2, mul1);
-
-        return result;
+        getGeometryKernels().crossProduct(vector1, vector2, result);
     }
 
-    static __m256 crossProduct(const float *vector1, const float *vector2)
+    static float vectorMagnitude(const float *vector)
     {
-        __m256 v1 = _mm256_set_ps(0, 0, 0, 0, 0, vector1[2], vector1[1], vector1[0]);
-        __m256 v2 = _mm256_set_ps(0, 0, 0, 0, 0, vector2[2], vector2[1], vector2[0]);
-
-        __m256 shuffle1 = _mm256_permute_ps(v2, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 shuffle2 = _mm256_permute_ps(v1, _MM_SHUFFLE(3, 1, 0, 2));
-        __m256 mul1 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        shuffle1 = _mm256_permute_ps(v2, _MM_SHUFFLE(3, 1, 0, 2));
-        shuffle2 = _mm256_permute_ps(v1, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 mul2 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        __m256 result = _mm256_sub_ps(mul2, mul1);
-
-        return result;
+        return getGeometryKernels().vectorMagnitude(vector);
     }
 
-    static float vectorMagnitude(__m256 vec)
+    /** @brief vector1 * (vector2 x vector3) */
+    static float mixedProduct(const float *vector1, const float *vector2, const float *vector3)
     {
-        auto dot = _mm256_dp_ps(vec, vec, 0xFF);
-        auto sqrt = _mm256_sqrt_ps(dot);
-        return sqrt[0];
+        return getGeometryKernels().mixedProduct(vector1, vector2, vector3);
     }
 
-    static float vectorMagnitude(const float *vector)
+    /** @brief Calculate track impact parameter corresponding to vertex. */
+    static Double_t calculateImpactParameter(Vertex &vertex, Track *track)
     {
-        __m256 vec = _mm256_set_ps(0, 0, 0, 0, 0, vector[2], vector[1], vector[0]);
-        auto dot = _mm256_dp_ps(vec, vec, 0xFF);
-        auto sqrt = _mm256_sqrt_ps(dot);
-        return sqrt[0];
+        float vertexPosition[3] = {vertex.getX(), vertex.getY(), vertex.getZ()};
+        float trackPosition[3] = {track->getX(), track->getY(), track->getZ()};
+        float trackDirection[3] = {track->getTanX(), track->getTanY(), track->getTanZ()};
+
+        return getGeometryKernels().impactParameter(vertexPosition, trackPosition, trackDirection);
     }
 
-    static float mixedProduct(__m256 vector1, __m256 vector2, __m256 vector3)
+    /** @brief Calculate impact parameters of all the batch tracks corresponding to vertex, 8 or 16 tracks at a time.
+     * Results are the same as calculateImpactParameter gives for each track.
+     * @param impactParameters array of at least batch size.
+     */
+    static void calculateImpactParameters(const Vertex &vertex, const TrackBatch &batch, float *impactParameters)
     {
+        float vertexPosition[3] = {vertex.getX(), vertex.getY(), vertex.getZ()};
+        getGeometryKernels().impactParameters(vertexPosition, getBatchColumns(batch), impactParameters);
+    }
 
-        __m256 shuffle1 = _mm256_permute_ps(vector3, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 shuffle2 = _mm256_permute_ps(vector2, _MM_SHUFFLE(3, 1, 0, 2));
-        __m256 mul1 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        shuffle1 = _mm256_permute_ps(vector3, _MM_SHUFFLE(3, 1, 0, 2));
-        shuffle2 = _mm256_permute_ps(vector2, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 mul2 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        __m256 subres = _mm256_sub_ps(mul2, mul1);
+    /** @brief Columns of the batch for the geometry kernels. */
+    static TrackBatchColumns getBatchColumns(const TrackBatch &batch)
+    {
+        return {batch.getX(), batch.getY(), batch.getZ(), batch.getTanX(), batch.getTanY(), batch.getTanZ(), batch.size()};
+    }
 
-        auto dotprod = _mm256_dp_ps(vector1, subres, 0xFF);
+#ifdef __AVX__
+    // AVX register variants, available only in code compiled for AVX (tests), the other code uses dispatched kernels.
 
-        return dotprod[0];
+    static __m256 crossProduct(__m256 vec1, __m256 vec2)
+    {
+        return AVXVectors::crossProduct(vec1, vec2);
     }
 
-    static float mixedProduct(const float *vector1, const float *vector2, const float *vector3)
+    static __m256 crossProduct(const float *vector1, const float *vector2)
     {
         __m256 v1 = _mm256_set_ps(0, 0, 0, 0, 0, vector1[2], vector1[1], vector1[0]);
         __m256 v2 = _mm256_set_ps(0, 0, 0, 0, 0, vector2[2], vector2[1], vector2[0]);
-        __m256 v3 = _mm256_set_ps(0, 0, 0, 0, 0, vector3[2], vector3[1], vector3[0]);
-
-        __m256 shuffle1 = _mm256_permute_ps(v3, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 shuffle2 = _mm256_permute_ps(v2, _MM_SHUFFLE(3, 1, 0, 2));
-        __m256 mul1 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        shuffle1 = _mm256_permute_ps(v3, _MM_SHUFFLE(3, 1, 0, 2));
-        shuffle2 = _mm256_permute_ps(v2, _MM_SHUFFLE(3, 0, 2, 1));
-        __m256 mul2 = _mm256_mul_ps(shuffle1, shuffle2);
-
-        __m256 subres = _mm256_sub_ps(mul2, mul1);
-
-        auto dotprod = _mm256_dp_ps(v1, subres, 0xFF);
-
-        return dotprod[0];
+        return AVXVectors::crossProduct(v1, v2);
     }
 
-    /** @brief Calculate track impact parameter corresponding to vertex. */
-    static Double_t calculateImpactParameter(Vertex &vertex, Track *track)
+    static float vectorMagnitude(__m256 vec)
     {
-        __m256 trackPos = _mm256_set_ps(0, 0, 0, 0, 0, track->getZ(), track->getY(), track->getX());
-        __m256 vertPos = _mm256_set_ps(0, 0, 0, 0, 0, vertex.getZ(), vertex.getY(), vertex.getX());
-        __m256 trackDir = _mm256_set_ps(0, 0, 0, 0, 0, track->getTanZ(), track->getTanY(), track->getTanX());
-
-        auto vertTrackDist = _mm256_sub_ps(trackPos, vertPos);
-        auto distCrossDir = crossProduct(vertTrackDist, trackDir);
-
-        auto distDirDot = _mm256_dp_ps(distCrossDir, distCrossDir, 0xFF);
-        auto distDirMagn = _mm256_sqrt_ps(distDirDot);
-
-        auto trackDirDot = _mm256_dp_ps(trackDir, trackDir, 0xFF);
-        auto trackDirMagn = _mm256_sqrt_ps(trackDirDot);
+        return AVXVectors::vectorMagnitude(vec);
+    }
 
-        auto result = distDirMagn[0] / trackDirMagn[0];
+    static float mixedProduct(__m256 vector1, __m256 vector2, __m256 vector3)
+    {
+        return AVXVectors::mixedProduct(vector1, vector2, vector3);
+    }
 
-        return result;
+    static float calculateImpactParameter(__m256 vertPos, __m256 trackPos, __m256 trackDir)
+    {
+        return AVXVectors::calculateImpactParameter(vertPos, trackPos, trackDir);
     }
-};
\ No newline at end of file
+
+#endif
+};
@@ -0,0 +1,63 @@
+#include "GeometryKernels.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    bool cpuSupports(const GeometryKernels *kernels)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (kernels == &getAVX512GeometryKernels())
+            return __builtin_cpu_supports("avx512f");
+        if (kernels == &getAVX2GeometryKernels())
+            return __builtin_cpu_supports("avx2");
+#endif
+        return kernels == &getScalarGeometryKernels();
+    }
+
+    const GeometryKernels &selectGeometryKernels()
+    {
+        auto supported = getSupportedGeometryKernels();
+        const GeometryKernels *selected = supported.back();
+
+        const char *requested = std::getenv("VERTEXING_KERNELS");
+        if (requested != nullptr)
+        {
+            bool found = false;
+            for (auto kernels : supported)
+            {
+                if (std::strcmp(kernels->name, requested) == 0)
+                {
+                    selected = kernels;
+                    found = true;
+                }
+            }
+            if (!found)
+                printf("Geometry kernels %s requested by VERTEXING_KERNELS are not supported by CPU. \n", requested);
+        }
+        printf("Geometry kernels: %s \n", selected->name);
+        return *selected;
+    }
+}
+
+std::vector<const GeometryKernels *> getSupportedGeometryKernels()
+{
+    std::vector<const GeometryKernels *> supported;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+#endif
+    for (auto kernels : {&getScalarGeometryKernels(), &getAVX2GeometryKernels(), &getAVX512GeometryKernels()})
+    {
+        if (cpuSupports(kernels))
+            supported.push_back(kernels);
+    }
+    return supported;
+}
+
+const GeometryKernels &getGeometryKernels()
+{
+    static const GeometryKernels &kernels = selectGeometryKernels();
+    return kernels;
+}
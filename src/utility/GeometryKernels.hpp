@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/** @brief Common perpendicular of two tracks lines P1 + T * D1 and P2 + S * D2. */
+struct LinesApproach
+{
+    float angleSin2;     // squared sine of the angle between lines
+    float perpendicular; // length of the common perpendicular
+    float variableS;     // parameters of the perpendicular ends, NaN if not calculated
+    float variableT;
+};
+
+/** @brief Columns of the tracks batch, count floats each. Kernels get plain columns, so instruction set specific code does not
+ * include the inline functions of the other headers.
+ */
+struct TrackBatchColumns
+{
+    const float *X, *Y, *Z;
+    const float *tanX, *tanY, *tanZ;
+    size_t count;
+};
+
+/**
+ * @brief Table of the geometry kernels compiled for one instruction set. All variants give the same results as the scalar one,
+ * operations are done in the same order. Vectors are 3 floats X, Y, Z.
+ */
+struct GeometryKernels
+{
+    const char *name;
+
+    void (*crossProduct)(const float *vector1, const float *vector2, float *result);
+
+    /** vector1 * (vector2 x vector3) */
+    float (*mixedProduct)(const float *vector1, const float *vector2, const float *vector3);
+
+    float (*vectorMagnitude)(const float *vector);
+
+    float (*impactParameter)(const float *vertex, const float *trackPosition, const float *trackDirection);
+
+    /** Impact parameters of all the batch tracks, impactParameters array must have at least batch size. */
+    void (*impactParameters)(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters);
+
+    /** S and T are calculated only for lines with angleSin2 >= minAngleSin2 and perpendicular <= maxPerpendicular. */
+    void (*linesApproach)(const float *point1, const float *direction1, const float *point2, const float *direction2,
+                          float minAngleSin2, float maxPerpendicular, LinesApproach &approach);
+};
+
+/** @brief Portable reference kernels, run on any CPU. */
+const GeometryKernels &getScalarGeometryKernels();
+
+/** @brief Scalar impact parameters of the tracks from firstTrack to the end, vector kernels calculate their tail by it. */
+void calculateScalarImpactParameters(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters, size_t firstTrack);
+
+/** @brief Kernels for CPUs with AVX2. */
+const GeometryKernels &getAVX2GeometryKernels();
+
+/** @brief Kernels for CPUs with AVX-512F, batch calculations are done 16 tracks at a time. */
+const GeometryKernels &getAVX512GeometryKernels();
+
+/** @brief Kernels variants the CPU supports, from scalar to the widest. */
+std::vector<const GeometryKernels *> getSupportedGeometryKernels();
+
+/**
+ * @brief Kernels selected at the first call by CPUID: the widest supported instruction set.
+ * Environment variable VERTEXING_KERNELS=scalar|avx2|avx512 could select a narrower supported variant.
+ */
+const GeometryKernels &getGeometryKernels();
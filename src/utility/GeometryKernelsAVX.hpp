@@ -0,0 +1,57 @@
+#pragma once
+
+#include <immintrin.h>
+
+/* AVX register functions for the code compiled with -mavx2 or wider. They have internal linkage: inline functions with external
+linkage compiled for different instruction sets could be merged by the linker into one copy, which the other CPUs can not run.
+Vectors are X, Y, Z in the lowest floats of the register, the others are zero.
+ */
+namespace AVXVectors
+{
+    static inline __m256 crossProduct(__m256 vec1, __m256 vec2)
+    {
+        __m256 shuffle1 = _mm256_permute_ps(vec2, _MM_SHUFFLE(3, 0, 2, 1));
+        __m256 shuffle2 = _mm256_permute_ps(vec1, _MM_SHUFFLE(3, 1, 0, 2));
+        __m256 mul1 = _mm256_mul_ps(shuffle1, shuffle2);
+
+        shuffle1 = _mm256_permute_ps(vec2, _MM_SHUFFLE(3, 1, 0, 2));
+        shuffle2 = _mm256_permute_ps(vec1, _MM_SHUFFLE(3, 0, 2, 1));
+        __m256 mul2 = _mm256_mul_ps(shuffle1, shuffle2);
+
+        __m256 result = _mm256_sub_ps(mul2, mul1);
+
+        return result;
+    }
+
+    static inline float vectorMagnitude(__m256 vec)
+    {
+        auto dot = _mm256_dp_ps(vec, vec, 0xFF);
+        auto sqrt = _mm256_sqrt_ps(dot);
+        return sqrt[0];
+    }
+
+    static inline float mixedProduct(__m256 vector1, __m256 vector2, __m256 vector3)
+    {
+        auto subres = crossProduct(vector2, vector3);
+
+        auto dotprod = _mm256_dp_ps(vector1, subres, 0xFF);
+
+        return dotprod[0];
+    }
+
+    static inline float calculateImpactParameter(__m256 vertPos, __m256 trackPos, __m256 trackDir)
+    {
+        auto vertTrackDist = _mm256_sub_ps(trackPos, vertPos);
+        auto distCrossDir = crossProduct(vertTrackDist, trackDir);
+
+        auto distDirDot = _mm256_dp_ps(distCrossDir, distCrossDir, 0xFF);
+        auto distDirMagn = _mm256_sqrt_ps(distDirDot);
+
+        auto trackDirDot = _mm256_dp_ps(trackDir, trackDir, 0xFF);
+        auto trackDirMagn = _mm256_sqrt_ps(trackDirDot);
+
+        auto result = distDirMagn[0] / trackDirMagn[0];
+
+        return result;
+    }
+}
@@ -0,0 +1,123 @@
+// Compiled with -mavx2, called only when CPU supports it.
+#include "GeometryKernels.hpp"
+#include "GeometryKernelsAVX.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    __m256 loadVector(const float *vector)
+    {
+        return _mm256_set_ps(0, 0, 0, 0, 0, vector[2], vector[1], vector[0]);
+    }
+
+    void crossProduct(const float *vector1, const float *vector2, float *result)
+    {
+        auto cross = AVXVectors::crossProduct(loadVector(vector1), loadVector(vector2));
+        result[0] = cross[0];
+        result[1] = cross[1];
+        result[2] = cross[2];
+    }
+
+    float mixedProduct(const float *vector1, const float *vector2, const float *vector3)
+    {
+        return AVXVectors::mixedProduct(loadVector(vector1), loadVector(vector2), loadVector(vector3));
+    }
+
+    float vectorMagnitude(const float *vector)
+    {
+        return AVXVectors::vectorMagnitude(loadVector(vector));
+    }
+
+    float impactParameter(const float *vertex, const float *trackPosition, const float *trackDirection)
+    {
+        return AVXVectors::calculateImpactParameter(loadVector(vertex), loadVector(trackPosition), loadVector(trackDirection));
+    }
+
+    void impactParameters(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters)
+    {
+        const float *X = tracks.X, *Y = tracks.Y, *Z = tracks.Z;
+        const float *tanX = tracks.tanX, *tanY = tracks.tanY, *tanZ = tracks.tanZ;
+        const size_t count = tracks.count;
+
+        __m256 vertX = _mm256_set1_ps(vertex[0]);
+        __m256 vertY = _mm256_set1_ps(vertex[1]);
+        __m256 vertZ = _mm256_set1_ps(vertex[2]);
+
+        size_t t = 0;
+        for (; t + 8 <= count; t += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(X + t), vertX);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(Y + t), vertY);
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(Z + t), vertZ);
+            __m256 tx = _mm256_loadu_ps(tanX + t);
+            __m256 ty = _mm256_loadu_ps(tanY + t);
+            __m256 tz = _mm256_loadu_ps(tanZ + t);
+
+            // (track - vertex) x direction
+            __m256 crossX = _mm256_sub_ps(_mm256_mul_ps(dy, tz), _mm256_mul_ps(dz, ty));
+            __m256 crossY = _mm256_sub_ps(_mm256_mul_ps(dz, tx), _mm256_mul_ps(dx, tz));
+            __m256 crossZ = _mm256_sub_ps(_mm256_mul_ps(dx, ty), _mm256_mul_ps(dy, tx));
+
+            __m256 crossDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(crossX, crossX), _mm256_mul_ps(crossY, crossY)), _mm256_mul_ps(crossZ, crossZ));
+            __m256 dirDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), _mm256_mul_ps(tz, tz));
+
+            _mm256_storeu_ps(impactParameters + t, _mm256_div_ps(_mm256_sqrt_ps(crossDot), _mm256_sqrt_ps(dirDot)));
+        }
+        calculateScalarImpactParameters(vertex, tracks, impactParameters, t);
+    }
+
+    /* Cramer's rule for the system of the common perpendicular ends. */
+    void linesApproach(const float *point1, const float *direction1, const float *point2, const float *direction2,
+                       float minAngleSin2, float maxPerpendicular, LinesApproach &approach)
+    {
+        approach.variableS = approach.variableT = std::numeric_limits<float>::quiet_NaN();
+
+        __m256 coord1 = loadVector(point1);
+        __m256 coord2 = loadVector(point2);
+        __m256 dir1 = loadVector(direction1);
+        __m256 dir2 = loadVector(direction2);
+
+        auto dirDot = AVXVectors::crossProduct(dir1, dir2);
+        auto dirDotMagn = AVXVectors::vectorMagnitude(dirDot);
+
+        float dir1Magn2 = direction1[0] * direction1[0] + direction1[1] * direction1[1] + direction1[2] * direction1[2];
+        float dir2Magn2 = direction2[0] * direction2[0] + direction2[1] * direction2[1] + direction2[2] * direction2[2];
+        approach.angleSin2 = dirDotMagn * dirDotMagn / (dir1Magn2 * dir2Magn2);
+
+        auto pointDist = _mm256_sub_ps(coord2, coord1);
+        auto mixed = std::abs(AVXVectors::mixedProduct(pointDist, dir1, dir2));
+        approach.perpendicular = mixed / dirDotMagn;
+
+        if (!(approach.angleSin2 >= minAngleSin2) || approach.perpendicular > maxPerpendicular)
+            return;
+
+        float deltaX = point1[0] - point2[0], deltaY = point1[1] - point2[1], deltaZ = point1[2] - point2[2];
+
+        __m256 vec1general = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[0], -direction1[0], direction2[0]);
+        __m256 vec2general = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[1], -direction1[1], direction2[1]);
+        __m256 vec3general = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[2], -direction1[2], direction2[2]);
+        auto detGeneral = AVXVectors::mixedProduct(vec1general, vec2general, vec3general);
+
+        __m256 vec1first = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[0], -direction1[0], deltaX);
+        __m256 vec2first = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[1], -direction1[1], deltaY);
+        __m256 vec3first = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[2], -direction1[2], deltaZ);
+        auto detFirst = AVXVectors::mixedProduct(vec1first, vec2first, vec3first);
+
+        __m256 vec1second = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[0], deltaX, direction2[0]);
+        __m256 vec2second = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[1], deltaY, direction2[1]);
+        __m256 vec3second = _mm256_set_ps(0, 0, 0, 0, 0, -dirDot[2], deltaZ, direction2[2]);
+        auto detSecond = AVXVectors::mixedProduct(vec1second, vec2second, vec3second);
+
+        approach.variableS = detFirst / detGeneral;
+        approach.variableT = detSecond / detGeneral;
+    }
+
+    const GeometryKernels AVX2_KERNELS = {"avx2", crossProduct, mixedProduct, vectorMagnitude, impactParameter, impactParameters, linesApproach};
+}
+
+const GeometryKernels &getAVX2GeometryKernels()
+{
+    return AVX2_KERNELS;
+}
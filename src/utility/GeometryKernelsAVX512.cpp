@@ -0,0 +1,52 @@
+// Compiled with -mavx512f, called only when CPU supports it.
+#include "GeometryKernels.hpp"
+
+#include <immintrin.h>
+
+namespace
+{
+    void impactParameters(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters)
+    {
+        const float *X = tracks.X, *Y = tracks.Y, *Z = tracks.Z;
+        const float *tanX = tracks.tanX, *tanY = tracks.tanY, *tanZ = tracks.tanZ;
+        const size_t count = tracks.count;
+
+        __m512 vertX = _mm512_set1_ps(vertex[0]);
+        __m512 vertY = _mm512_set1_ps(vertex[1]);
+        __m512 vertZ = _mm512_set1_ps(vertex[2]);
+
+        size_t t = 0;
+        for (; t + 16 <= count; t += 16)
+        {
+            __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(X + t), vertX);
+            __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(Y + t), vertY);
+            __m512 dz = _mm512_sub_ps(_mm512_loadu_ps(Z + t), vertZ);
+            __m512 tx = _mm512_loadu_ps(tanX + t);
+            __m512 ty = _mm512_loadu_ps(tanY + t);
+            __m512 tz = _mm512_loadu_ps(tanZ + t);
+
+            // (track - vertex) x direction
+            __m512 crossX = _mm512_sub_ps(_mm512_mul_ps(dy, tz), _mm512_mul_ps(dz, ty));
+            __m512 crossY = _mm512_sub_ps(_mm512_mul_ps(dz, tx), _mm512_mul_ps(dx, tz));
+            __m512 crossZ = _mm512_sub_ps(_mm512_mul_ps(dx, ty), _mm512_mul_ps(dy, tx));
+
+            __m512 crossDot = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(crossX, crossX), _mm512_mul_ps(crossY, crossY)), _mm512_mul_ps(crossZ, crossZ));
+            __m512 dirDot = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(tx, tx), _mm512_mul_ps(ty, ty)), _mm512_mul_ps(tz, tz));
+
+            _mm512_storeu_ps(impactParameters + t, _mm512_div_ps(_mm512_sqrt_ps(crossDot), _mm512_sqrt_ps(dirDot)));
+        }
+        calculateScalarImpactParameters(vertex, tracks, impactParameters, t);
+    }
+}
+
+const GeometryKernels &getAVX512GeometryKernels()
+{
+    // Single vector calculations gain nothing from wider registers, AVX2 ones are used
+    static const GeometryKernels AVX512_KERNELS = [] {
+        GeometryKernels kernels = getAVX2GeometryKernels();
+        kernels.name = "avx512";
+        kernels.impactParameters = impactParameters;
+        return kernels;
+    }();
+    return AVX512_KERNELS;
+}
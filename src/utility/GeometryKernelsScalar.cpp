@@ -0,0 +1,103 @@
+#include "GeometryKernels.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Sums are done as ((x + y) + z), the same as AVX dot product instruction does.
+
+    void crossProduct(const float *vector1, const float *vector2, float *result)
+    {
+        result[0] = vector1[1] * vector2[2] - vector1[2] * vector2[1];
+        result[1] = vector1[2] * vector2[0] - vector1[0] * vector2[2];
+        result[2] = vector1[0] * vector2[1] - vector1[1] * vector2[0];
+    }
+
+    float dotProduct(const float *vector1, const float *vector2)
+    {
+        return vector1[0] * vector2[0] + vector1[1] * vector2[1] + vector1[2] * vector2[2];
+    }
+
+    float mixedProduct(const float *vector1, const float *vector2, const float *vector3)
+    {
+        float cross[3];
+        crossProduct(vector2, vector3, cross);
+        return dotProduct(vector1, cross);
+    }
+
+    float vectorMagnitude(const float *vector)
+    {
+        return std::sqrt(dotProduct(vector, vector));
+    }
+
+    float impactParameter(const float *vertex, const float *trackPosition, const float *trackDirection)
+    {
+        float vertTrackDist[3] = {trackPosition[0] - vertex[0], trackPosition[1] - vertex[1], trackPosition[2] - vertex[2]};
+        float distCrossDir[3];
+        crossProduct(vertTrackDist, trackDirection, distCrossDir);
+        return vectorMagnitude(distCrossDir) / vectorMagnitude(trackDirection);
+    }
+
+    void impactParameters(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters)
+    {
+        calculateScalarImpactParameters(vertex, tracks, impactParameters, 0);
+    }
+
+    /* Cramer's rule for the system of the common perpendicular ends, the same determinants as AVX variant calculates. */
+    void linesApproach(const float *point1, const float *direction1, const float *point2, const float *direction2,
+                       float minAngleSin2, float maxPerpendicular, LinesApproach &approach)
+    {
+        approach.variableS = approach.variableT = std::numeric_limits<float>::quiet_NaN();
+
+        float dirCross[3];
+        crossProduct(direction1, direction2, dirCross);
+        float dirCrossMagn = vectorMagnitude(dirCross);
+
+        float dir1Magn2 = direction1[0] * direction1[0] + direction1[1] * direction1[1] + direction1[2] * direction1[2];
+        float dir2Magn2 = direction2[0] * direction2[0] + direction2[1] * direction2[1] + direction2[2] * direction2[2];
+        approach.angleSin2 = dirCrossMagn * dirCrossMagn / (dir1Magn2 * dir2Magn2);
+
+        float pointDist[3] = {point2[0] - point1[0], point2[1] - point1[1], point2[2] - point1[2]};
+        approach.perpendicular = std::abs(mixedProduct(pointDist, direction1, direction2)) / dirCrossMagn;
+
+        if (!(approach.angleSin2 >= minAngleSin2) || approach.perpendicular > maxPerpendicular)
+            return;
+
+        float pointDelta[3] = {point1[0] - point2[0], point1[1] - point2[1], point1[2] - point2[2]};
+        float vec1general[3] = {direction2[0], -direction1[0], -dirCross[0]};
+        float vec2general[3] = {direction2[1], -direction1[1], -dirCross[1]};
+        float vec3general[3] = {direction2[2], -direction1[2], -dirCross[2]};
+        float detGeneral = mixedProduct(vec1general, vec2general, vec3general);
+
+        float vec1first[3] = {pointDelta[0], -direction1[0], -dirCross[0]};
+        float vec2first[3] = {pointDelta[1], -direction1[1], -dirCross[1]};
+        float vec3first[3] = {pointDelta[2], -direction1[2], -dirCross[2]};
+        float detFirst = mixedProduct(vec1first, vec2first, vec3first);
+
+        float vec1second[3] = {direction2[0], pointDelta[0], -dirCross[0]};
+        float vec2second[3] = {direction2[1], pointDelta[1], -dirCross[1]};
+        float vec3second[3] = {direction2[2], pointDelta[2], -dirCross[2]};
+        float detSecond = mixedProduct(vec1second, vec2second, vec3second);
+
+        approach.variableS = detFirst / detGeneral;
+        approach.variableT = detSecond / detGeneral;
+    }
+
+    const GeometryKernels SCALAR_KERNELS = {"scalar", crossProduct, mixedProduct, vectorMagnitude, impactParameter, impactParameters, linesApproach};
+}
+
+void calculateScalarImpactParameters(const float *vertex, const TrackBatchColumns &tracks, float *impactParameters, size_t firstTrack)
+{
+    for (size_t t = firstTrack; t < tracks.count; t++)
+    {
+        float trackPosition[3] = {tracks.X[t], tracks.Y[t], tracks.Z[t]};
+        float trackDirection[3] = {tracks.tanX[t], tracks.tanY[t], tracks.tanZ[t]};
+        impactParameters[t] = impactParameter(vertex, trackPosition, trackDirection);
+    }
+}
+
+const GeometryKernels &getScalarGeometryKernels()
+{
+    return SCALAR_KERNELS;
+}
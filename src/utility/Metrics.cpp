@@ -0,0 +1,233 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    std::string createMetricKey(const std::string &scope, MetricKind kind, const std::string &name)
+    {
+        return scope + '\0' + (kind == MetricKind::Timer ? 'T' : kind == MetricKind::Counter ? 'C' : 'G') + name;
+    }
+
+    std::string escapeJson(const std::string &text)
+    {
+        std::string escaped;
+        for (char symbol : text)
+        {
+            if (symbol == '"' || symbol == '\\')
+                escaped += '\\';
+            if ((unsigned char)symbol < 0x20)
+                continue; // file names and metric names have no control characters worth keeping
+            escaped += symbol;
+        }
+        return escaped;
+    }
+
+    std::string escapeCsv(const std::string &text)
+    {
+        if (text.find_first_of(",\"\n") == std::string::npos)
+            return text;
+        std::string escaped = "\"";
+        for (char symbol : text)
+        {
+            escaped += symbol;
+            if (symbol == '"')
+                escaped += '"';
+        }
+        return escaped + "\"";
+    }
+
+    void writeJsonMetrics(FILE *file, const std::vector<const Metric *> &metrics, MetricKind kind)
+    {
+        bool first = true;
+        for (auto metric : metrics)
+        {
+            if (metric->kind != kind)
+                continue;
+            fprintf(file, "%s\n      \"%s\": ", first ? "" : ",", escapeJson(metric->name).c_str());
+            if (kind == MetricKind::Timer)
+                fprintf(file, "{\"calls\": %lu, \"totalMs\": %.3f, \"minMs\": %.3f, \"maxMs\": %.3f}", metric->calls, metric->total, metric->min, metric->max);
+            else if (kind == MetricKind::Counter)
+                fprintf(file, "%.0f", metric->total);
+            else
+                fprintf(file, "%g", metric->total);
+            first = false;
+        }
+        fprintf(file, "%s", first ? "" : "\n    ");
+    }
+}
+
+struct MetricsRegistry::ThreadTableHolder
+{
+    ThreadTable table;
+    MetricsRegistry *registry = nullptr;
+
+    ~ThreadTableHolder()
+    {
+        if (registry != nullptr)
+            registry->unregisterThreadTable(&table);
+    }
+};
+
+MetricsRegistry &getMetrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::ThreadTable &MetricsRegistry::getThreadTable()
+{
+    // the registry is created before the first holder, so it is destroyed after the holders of all the threads
+    thread_local ThreadTableHolder holder;
+    if (holder.registry == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(tablesMutex);
+        tables.push_back(&holder.table);
+        holder.registry = this;
+    }
+    return holder.table;
+}
+
+void MetricsRegistry::unregisterThreadTable(ThreadTable *table)
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    std::lock_guard<std::mutex> tableLock(table->mutex);
+    for (auto &metric : table->metrics)
+    {
+        merge(retired, metric);
+    }
+    tables.erase(std::remove(tables.begin(), tables.end(), table), tables.end());
+}
+
+void MetricsRegistry::merge(ThreadTable &table, const Metric &metric)
+{
+    auto position = table.positions.emplace(createMetricKey(metric.scope, metric.kind, metric.name), table.metrics.size());
+    if (position.second)
+    {
+        table.metrics.push_back(metric);
+        return;
+    }
+    auto &merged = table.metrics[position.first->second];
+    merged.calls += metric.calls;
+    merged.total = metric.kind == MetricKind::Gauge ? metric.total : merged.total + metric.total;
+    merged.min = std::min(merged.min, metric.min);
+    merged.max = std::max(merged.max, metric.max);
+}
+
+void MetricsRegistry::add(MetricKind kind, const std::string &name, double value)
+{
+    auto &table = getThreadTable();
+    std::lock_guard<std::mutex> lock(table.mutex); // contended only by collect
+    merge(table, Metric{table.scope, name, kind, 1, value, value, value});
+}
+
+void MetricsRegistry::setThreadScope(const std::string &scope)
+{
+    auto &table = getThreadTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.scope = scope;
+}
+
+std::string MetricsRegistry::getThreadScope()
+{
+    auto &table = getThreadTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.scope;
+}
+
+std::vector<Metric> MetricsRegistry::collect()
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    ThreadTable merged;
+    for (auto &metric : retired.metrics)
+    {
+        merge(merged, metric);
+    }
+    for (auto table : tables)
+    {
+        std::lock_guard<std::mutex> tableLock(table->mutex);
+        for (auto &metric : table->metrics)
+        {
+            merge(merged, metric);
+        }
+    }
+    return merged.metrics;
+}
+
+void MetricsRegistry::reset()
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    retired.metrics.clear();
+    retired.positions.clear();
+    for (auto table : tables)
+    {
+        std::lock_guard<std::mutex> tableLock(table->mutex);
+        table->metrics.clear();
+        table->positions.clear();
+    }
+}
+
+bool MetricsRegistry::writeJson(const std::string &fileName)
+{
+    auto metrics = collect();
+    std::vector<std::string> scopes; // in order of the first metric
+    for (auto &metric : metrics)
+    {
+        if (std::find(scopes.begin(), scopes.end(), metric.scope) == scopes.end())
+            scopes.push_back(metric.scope);
+    }
+
+    FILE *file = fopen(fileName.c_str(), "w");
+    if (file == nullptr)
+    {
+        printf("ERROR - could not create metrics file %s \n", fileName.c_str());
+        return false;
+    }
+    fprintf(file, "{\n  \"scopes\": [");
+    for (size_t s = 0; s < scopes.size(); s++)
+    {
+        std::vector<const Metric *> scopeMetrics;
+        for (auto &metric : metrics)
+        {
+            if (metric.scope == scopes[s])
+                scopeMetrics.push_back(&metric);
+        }
+        fprintf(file, "%s\n    {\"scope\": \"%s\",\n    \"timers\": {", s == 0 ? "" : ",", escapeJson(scopes[s]).c_str());
+        writeJsonMetrics(file, scopeMetrics, MetricKind::Timer);
+        fprintf(file, "},\n    \"counters\": {");
+        writeJsonMetrics(file, scopeMetrics, MetricKind::Counter);
+        fprintf(file, "},\n    \"gauges\": {");
+        writeJsonMetrics(file, scopeMetrics, MetricKind::Gauge);
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    bool succeeded = !ferror(file);
+    return fclose(file) == 0 && succeeded;
+}
+
+bool MetricsRegistry::writeCsv(const std::string &fileName)
+{
+    auto metrics = collect();
+    FILE *file = fopen(fileName.c_str(), "w");
+    if (file == nullptr)
+    {
+        printf("ERROR - could not create metrics file %s \n", fileName.c_str());
+        return false;
+    }
+    fprintf(file, "scope,kind,name,calls,total,min,max\n");
+    for (auto &metric : metrics)
+    {
+        fprintf(file, "%s,%s,%s,%lu,%.3f,%.3f,%.3f\n", escapeCsv(metric.scope).c_str(), metric.kind == MetricKind::Timer ? "timer" : metric.kind == MetricKind::Counter ? "counter" : "gauge",
+                escapeCsv(metric.name).c_str(), metric.calls, metric.total, metric.min, metric.max);
+    }
+    bool succeeded = !ferror(file);
+    return fclose(file) == 0 && succeeded;
+}
+
+bool MetricsRegistry::write(const std::string &fileName)
+{
+    const std::string csvExtension = ".csv";
+    bool isCsv = fileName.size() >= csvExtension.size() && fileName.compare(fileName.size() - csvExtension.size(), csvExtension.size(), csvExtension) == 0;
+    return isCsv ? writeCsv(fileName) : writeJson(fileName);
+}
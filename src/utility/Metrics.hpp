@@ -0,0 +1,143 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class MetricKind
+{
+    Timer,   // milliseconds summed over calls
+    Counter, // counts summed over calls
+    Gauge    // value of the state (cell size, cells count), not summed: total is the last value
+};
+
+/** @brief Metric accumulated over all the threads: calls count, total, the smallest and the largest added value. */
+struct Metric
+{
+    std::string scope;
+    std::string name;
+    MetricKind kind;
+    unsigned long calls;
+    double total, min, max;
+};
+
+/**
+ * @brief Process wide registry of named timers and counters for machine-readable run reports. Every thread adds to its own table,
+ * so threads do not contend; tables are merged when metrics are collected and when a thread exits. Metrics are grouped by scope,
+ * the brick name in batch mode, set for the current thread by MetricsScope. Hot loops should count into local variables and add
+ * the totals once, an addition costs a hash lookup.
+ */
+class MetricsRegistry
+{
+private:
+    /* Metrics of one thread in order of the first addition, guarded by its own mutex which only collect contends for. */
+    struct ThreadTable
+    {
+        std::mutex mutex;
+        std::vector<Metric> metrics;
+        std::unordered_map<std::string, size_t> positions; // scope and name
+        std::string scope;
+    };
+
+    /* Thread local owner of the thread table, unregisters it at thread exit. */
+    struct ThreadTableHolder;
+
+    std::mutex tablesMutex;
+    std::vector<ThreadTable *> tables;
+    ThreadTable retired; // metrics of the exited threads
+
+    ThreadTable &getThreadTable();
+    void unregisterThreadTable(ThreadTable *table);
+    void add(MetricKind kind, const std::string &name, double value);
+    static void merge(ThreadTable &table, const Metric &metric);
+
+    MetricsRegistry() = default;
+
+    friend MetricsRegistry &getMetrics();
+
+public:
+    void addTime(const std::string &name, double milliseconds) { add(MetricKind::Timer, name, milliseconds); }
+
+    void addCount(const std::string &name, unsigned long count) { add(MetricKind::Counter, name, count); }
+
+    /** @brief Set the gauge of the current scope, calls replace its value and keep the smallest and the largest one. */
+    void setGauge(const std::string &name, double value) { add(MetricKind::Gauge, name, value); }
+
+    /** @brief Scope of the metrics added by the current thread, empty by default. */
+    void setThreadScope(const std::string &scope);
+
+    std::string getThreadScope();
+
+    /** @brief Metrics of all the threads merged by scope and name. */
+    std::vector<Metric> collect();
+
+    /** @brief Forget all the metrics, for example between runs in one process. */
+    void reset();
+
+    /** @brief Write metrics grouped by scope as JSON: {"scopes": [{"scope", "timers": {name: {calls, totalMs, minMs, maxMs}},
+     * "counters": {name: value}, "gauges": {name: value}}]}.
+     * @returns true if file was written succesfully.
+     */
+    bool writeJson(const std::string &fileName);
+
+    /** @brief Write metrics as CSV with columns scope, kind, name, calls, total, min, max.
+     * @returns true if file was written succesfully.
+     */
+    bool writeCsv(const std::string &fileName);
+
+    /** @brief Write CSV if file name ends with .csv, otherwise JSON. */
+    bool write(const std::string &fileName);
+
+public:
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+};
+
+/** @brief The only registry of the process. */
+MetricsRegistry &getMetrics();
+
+/** @brief Adds the time from construction to destruction (or to stop) to the timer of the given name. */
+class ScopedTimer
+{
+private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+    bool stopped = false;
+
+public:
+    /** @brief Add elapsed time now instead of at destruction, returns milliseconds. */
+    double stop()
+    {
+        auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!stopped)
+        {
+            stopped = true;
+            getMetrics().addTime(name, milliseconds);
+        }
+        return milliseconds;
+    }
+
+    ScopedTimer(const std::string &name) : name(name), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() { stop(); }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+/** @brief Sets the metrics scope of the current thread, the previous scope is restored at destruction. */
+class MetricsScope
+{
+private:
+    std::string previousScope;
+
+public:
+    MetricsScope(const std::string &scope) : previousScope(getMetrics().getThreadScope()) { getMetrics().setThreadScope(scope); }
+
+    ~MetricsScope() { getMetrics().setThreadScope(previousScope); }
+
+    MetricsScope(const MetricsScope &) = delete;
+    MetricsScope &operator=(const MetricsScope &) = delete;
+};
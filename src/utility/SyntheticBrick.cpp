@@ -0,0 +1,197 @@
+#include "SyntheticBrick.hpp"
+#include "../downloaders/NativeVertexFile.hpp"
+
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace
+{
+    /* Distributions are implemented here over the standard engine, because standard distributions differ between standard libraries
+    and the brick must be the same on any machine. */
+    class BrickRandom
+    {
+    private:
+        std::mt19937 engine;
+
+    public:
+        /* Uniform in [min, max). */
+        float uniform(float min, float max) { return min + (max - min) * ((engine() >> 8) * (1.0f / 16777216.0f)); }
+
+        /* Uniform in [min, max]. */
+        u_long uniformInteger(u_long min, u_long max) { return min + engine() % (max - min + 1); }
+
+        /* Gaussian with zero mean, Box-Muller transform. */
+        float normal(float sigma)
+        {
+            double u1 = ((engine() >> 8) + 1) * (1.0 / 16777217.0); // never 0
+            double u2 = (engine() >> 8) * (1.0 / 16777216.0);
+            return sigma * std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+        }
+
+        explicit BrickRandom(uint32_t seed) : engine(seed) {}
+    };
+
+    void addTrack(TrackColumns &columns, float X, float Y, float Z, float tanX, float tanY)
+    {
+        columns.X.push_back(X);
+        columns.Y.push_back(Y);
+        columns.Z.push_back(Z);
+        columns.tanX.push_back(tanX);
+        columns.tanY.push_back(tanY);
+    }
+
+    template <class T>
+    void reorderColumn(std::vector<T> &column, const std::vector<u_long> &order)
+    {
+        std::vector<T> ordered(order.size());
+        for (size_t t = 0; t < order.size(); t++)
+        {
+            ordered[t] = column[order[t]];
+        }
+        column = std::move(ordered);
+    }
+
+    void removeLastTracks(TrackColumns &columns, size_t count)
+    {
+        size_t size = columns.size() - count;
+        columns.X.resize(size);
+        columns.Y.resize(size);
+        columns.Z.resize(size);
+        columns.tanX.resize(size);
+        columns.tanY.resize(size);
+    }
+}
+
+SyntheticBrick generateSyntheticBrick(const SyntheticBrickConfig &config)
+{
+    if (config.volumeDimension == 0 || config.plateSpacingZ <= 0 || config.plateSpacingZ >= config.volumeDimension ||
+        config.backgroundFraction < 0 || config.backgroundFraction > 1 || config.minDaughters < 2 || config.minDaughters > config.maxDaughters)
+    {
+        throw std::invalid_argument("ERROR in synthetic brick config: inconsistent volume, plates, background or multiplicity parameters.");
+    }
+    if (config.vertexesCount > config.tracksCount / config.maxDaughters)
+    {
+        throw std::invalid_argument("ERROR in synthetic brick config: daughters of " + std::to_string(config.vertexesCount) +
+                                    " vertexes may not fit into " + std::to_string(config.tracksCount) + " tracks.");
+    }
+
+    BrickRandom random(config.seed);
+    const float halfDimension = config.volumeDimension / 2.0f;
+    const u_long platesCount = (u_long)std::ceil(config.volumeDimension / config.plateSpacingZ);
+    const float lastPlateZ = (platesCount - 1) * config.plateSpacingZ;
+
+    SyntheticBrick brick;
+    auto &tracks = brick.tracks;
+    tracks.X.reserve(config.tracksCount);
+    tracks.Y.reserve(config.tracksCount);
+    tracks.Z.reserve(config.tracksCount);
+    tracks.tanX.reserve(config.tracksCount);
+    tracks.tanY.reserve(config.tracksCount);
+
+    // vertexes, the exact count is reached by replacing the lost ones, which always fit into tracks
+    const bool exactVertexesCount = config.vertexesCount != 0;
+    const double meanDaughters = (config.minDaughters + config.maxDaughters) / 2.0;
+    const u_long vertexesCount = exactVertexesCount ? config.vertexesCount
+                                                    : std::llround(config.tracksCount * (1 - config.backgroundFraction) / meanDaughters);
+    for (u_long v = 0; (exactVertexesCount ? brick.truthVertexes.size() : v) < vertexesCount && tracks.size() < config.tracksCount; v++)
+    {
+        TruthVertex vertex{random.uniform(-halfDimension, halfDimension), random.uniform(-halfDimension, halfDimension),
+                           random.uniform(0, lastPlateZ), {}};
+        float plateZ = std::ceil(vertex.Z / config.plateSpacingZ) * config.plateSpacingZ; // daughters are seen from the next plate
+        auto daughtersCount = random.uniformInteger(config.minDaughters, config.maxDaughters);
+
+        for (u_long d = 0; d < daughtersCount && tracks.size() < config.tracksCount; d++)
+        {
+            float tanX = random.normal(config.daughterSlopeSigma);
+            float tanY = random.normal(config.daughterSlopeSigma);
+            float X = vertex.X + tanX * (plateZ - vertex.Z) + random.normal(config.positionResolution);
+            float Y = vertex.Y + tanY * (plateZ - vertex.Z) + random.normal(config.positionResolution);
+            if (std::abs(X) >= halfDimension || std::abs(Y) >= halfDimension)
+                continue; // daughter left the brick
+
+            vertex.daughters.push_back(tracks.size());
+            addTrack(tracks, X, Y, plateZ, tanX + random.normal(config.slopeResolution), tanY + random.normal(config.slopeResolution));
+        }
+        if (vertex.daughters.size() >= 2) // vertex of one track could not be found, its track stays as background
+        {
+            brick.truthVertexes.push_back(std::move(vertex));
+        }
+        else if (exactVertexesCount)
+        {
+            removeLastTracks(tracks, vertex.daughters.size());
+        }
+    }
+
+    // background
+    while (tracks.size() < config.tracksCount)
+    {
+        float Z = random.uniformInteger(0, platesCount - 1) * config.plateSpacingZ;
+        addTrack(tracks, random.uniform(-halfDimension, halfDimension), random.uniform(-halfDimension, halfDimension), Z,
+                 random.normal(config.backgroundSlopeSigma), random.normal(config.backgroundSlopeSigma));
+    }
+
+    // tracks order of the file is not correlated with vertexes, Fisher-Yates shuffle with the same engine
+    std::vector<u_long> order(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t t = order.size(); t > 1; t--)
+    {
+        std::swap(order[t - 1], order[random.uniformInteger(0, t - 1)]);
+    }
+    reorderColumn(tracks.X, order);
+    reorderColumn(tracks.Y, order);
+    reorderColumn(tracks.Z, order);
+    reorderColumn(tracks.tanX, order);
+    reorderColumn(tracks.tanY, order);
+
+    std::vector<u_long> newPosition(order.size());
+    for (size_t t = 0; t < order.size(); t++)
+    {
+        newPosition[order[t]] = t;
+    }
+    for (auto &vertex : brick.truthVertexes)
+    {
+        for (auto &daughter : vertex.daughters)
+        {
+            daughter = newPosition[daughter];
+        }
+    }
+    return brick;
+}
+
+std::vector<Track> SyntheticBrick::createTracks() const
+{
+    std::vector<Track> created;
+    created.reserve(tracks.size());
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        created.emplace_back(tracks.getIndex(t), tracks.X[t], tracks.Y[t], tracks.Z[t], tracks.tanX[t], tracks.tanY[t]);
+    }
+    return created;
+}
+
+bool SyntheticBrick::writeTruthVertexes(const std::string &fileName) const
+{
+    auto createdTracks = createTracks(); // vertexes reference daughters by pointers
+    std::vector<Vertex> vertexes;
+    vertexes.reserve(truthVertexes.size());
+    for (size_t v = 0; v < truthVertexes.size(); v++)
+    {
+        auto &truthVertex = truthVertexes[v];
+        vertexes.emplace_back(truthVertex.X, truthVertex.Y, truthVertex.Z);
+        vertexes.back().setIndex(v);
+        for (auto daughter : truthVertex.daughters)
+        {
+            vertexes.back().addDaughterTrack(&createdTracks[daughter]);
+        }
+    }
+
+    std::vector<Vertex *> vertexPtrs;
+    for (auto &vertex : vertexes)
+    {
+        vertexPtrs.push_back(&vertex);
+    }
+    NativeVertexFileWriter writer(fileName);
+    writer.writeVertexes(vertexPtrs);
+    return writer.close();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../data_types/Track.hpp"
+#include "../data_types/TrackColumns.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Parameters of the synthetic brick. Vertexes emit daughter tracks, which start at the first emulsion plate downstream
+ * of the vertex, background tracks start at random plates. Parameters could be set by name, as "name=value" generator arguments.
+ */
+struct SyntheticBrickConfig
+{
+    uint32_t seed = 1;
+    u_int volumeDimension = 20000;     // microns, X and Y are centered, Z starts at 0, the same as detector volume
+    u_long tracksCount = 100000;       // all tracks of the brick, track density is tracksCount / volumeDimension^3
+    float backgroundFraction = 0.8;    // part of tracks not coming from vertexes
+    u_long vertexesCount = 0;          // exactly this count of vertexes instead of backgroundFraction, if not 0
+    u_int minDaughters = 3;            // vertex multiplicity is uniform in [minDaughters, maxDaughters]
+    u_int maxDaughters = 10;
+    float daughterSlopeSigma = 0.3;    // tangents of daughter tracks are normal
+    float backgroundSlopeSigma = 0.05; // background is mostly beam tracks, almost straight
+    float plateSpacingZ = 500;         // microns between emulsion plates, tracks start at plates
+    float positionResolution = 0.5;    // microns, gaussian smearing of tracks start positions
+    float slopeResolution = 0.002;     // gaussian smearing of tracks tangents
+
+    /** @brief Set one parameter by its name. Throws std::invalid_argument if name is unknown or value is not a number. */
+    void setParameter(const std::string &name, const std::string &value)
+    {
+        const std::pair<const char *, float SyntheticBrickConfig::*> floatParameters[] = {
+            {"backgroundFraction", &SyntheticBrickConfig::backgroundFraction},
+            {"daughterSlopeSigma", &SyntheticBrickConfig::daughterSlopeSigma},
+            {"backgroundSlopeSigma", &SyntheticBrickConfig::backgroundSlopeSigma},
+            {"plateSpacingZ", &SyntheticBrickConfig::plateSpacingZ},
+            {"positionResolution", &SyntheticBrickConfig::positionResolution},
+            {"slopeResolution", &SyntheticBrickConfig::slopeResolution}};
+        const std::pair<const char *, u_int SyntheticBrickConfig::*> intParameters[] = {
+            {"volumeDimension", &SyntheticBrickConfig::volumeDimension},
+            {"minDaughters", &SyntheticBrickConfig::minDaughters},
+            {"maxDaughters", &SyntheticBrickConfig::maxDaughters}};
+
+        try
+        {
+            for (auto &parameter : floatParameters)
+            {
+                if (name == parameter.first)
+                {
+                    this->*parameter.second = std::stof(value);
+                    return;
+                }
+            }
+            for (auto &parameter : intParameters)
+            {
+                if (name == parameter.first)
+                {
+                    this->*parameter.second = std::stoul(value);
+                    return;
+                }
+            }
+            if (name == "tracksCount")
+            {
+                tracksCount = std::stoul(value);
+                return;
+            }
+            if (name == "vertexesCount")
+            {
+                vertexesCount = std::stoul(value);
+                return;
+            }
+            if (name == "seed")
+            {
+                seed = std::stoul(value);
+                return;
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            throw std::invalid_argument("ERROR in synthetic brick config: wrong value \"" + value + "\" of parameter " + name);
+        }
+        throw std::invalid_argument("ERROR in synthetic brick config: unknown parameter " + name);
+    }
+};
+
+/** @brief Generated vertex with indexes of its daughter tracks. */
+struct TruthVertex
+{
+    float X, Y, Z;
+    std::vector<u_long> daughters;
+};
+
+/** @brief Synthetic brick: tracks in random order, track index is its number in columns, and the true vertexes. */
+struct SyntheticBrick
+{
+    TrackColumns tracks;
+    std::vector<TruthVertex> truthVertexes;
+
+    /** @brief Create tracks for the detector volume directly, without file. */
+    std::vector<Track> createTracks() const;
+
+    /** @brief Write true vertexes as native vertex file (.vtx), daughters are referenced by track indexes.
+     * @returns true if file was written succesfully.
+     */
+    bool writeTruthVertexes(const std::string &fileName) const;
+};
+
+/**
+ * @brief Generate brick reproducibly: the same config and seed give the same brick on any machine.
+ * Daughter tracks leaving the volume are dropped, so vertexes near borders may have less daughters than minDaughters.
+ * Brick has exactly tracksCount tracks and, if vertexesCount is set, exactly vertexesCount vertexes.
+ * @throws std::invalid_argument if config is inconsistent or vertexesCount vertexes could have more daughters than tracksCount.
+ */
+SyntheticBrick generateSyntheticBrick(const SyntheticBrickConfig &config);
@@ -0,0 +1,114 @@
+#include "VertexMatching.hpp"
+#include "CalculationAndAlgorithms.hpp"
+#include "../detector/DetectorVolume.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+namespace
+{
+    struct MatchCandidate
+    {
+        double distance; // normalized, 1 is the border of the matching cylinder
+        size_t reconstructed, truth;
+
+        bool operator<(const MatchCandidate &other) const
+        {
+            return std::tie(distance, reconstructed, truth) < std::tie(other.distance, other.reconstructed, other.truth);
+        }
+    };
+
+    void calculateResiduals(const std::vector<double> &residuals, double &bias, double &resolution)
+    {
+        if (residuals.empty())
+            return;
+        double sum = 0, squaresSum = 0;
+        for (auto residual : residuals)
+        {
+            sum += residual;
+            squaresSum += residual * residual;
+        }
+        bias = sum / residuals.size();
+        resolution = std::sqrt(std::max(0.0, squaresSum / residuals.size() - bias * bias));
+    }
+}
+
+std::vector<VertexPoint> readVertexPoints(const MappedVertexFile &file)
+{
+    std::vector<VertexPoint> points(file.size());
+    for (size_t v = 0; v < file.size(); v++)
+    {
+        points[v] = VertexPoint{file.getX()[v], file.getY()[v], file.getZ()[v], file.getDaughtersCount(v)};
+    }
+    return points;
+}
+
+VertexMatchingResult matchVertexes(const std::vector<VertexPoint> &reconstructed, const std::vector<VertexPoint> &truth,
+                                   const VertexMatchingConfig &config)
+{
+    if (config.maxXYDistance == 0 || config.maxZDistance == 0)
+    {
+        throw std::invalid_argument("ERROR in vertex matching config: matching distances must be positive.");
+    }
+
+    VertexMatchingResult result;
+    result.reconstructedCount = reconstructed.size();
+    for (auto &vertex : truth)
+    {
+        result.truthCount += vertex.daughtersCount >= config.minTruthDaughters;
+    }
+    if (truth.empty() || reconstructed.empty())
+        return result;
+
+    auto cellSize = CalculationAndAlgorithms::calculateCellSizeFromTracksCount(config.volumeDimension, truth.size());
+    DetectorVolume truthVolume(config.volumeDimension, cellSize);
+    std::vector<size_t> truthByVertexIndex; // volume assigns indexes in order of addition
+    for (size_t t = 0; t < truth.size(); t++)
+    {
+        Vertex vertex(truth[t].X, truth[t].Y, truth[t].Z);
+        if (!truthVolume.checkDataObjectInDetectorBounds(vertex))
+            continue;
+        truthVolume.addNewUnindexedVertex(vertex);
+        truthByVertexIndex.push_back(t);
+    }
+
+    std::vector<MatchCandidate> candidates;
+    for (size_t r = 0; r < reconstructed.size(); r++)
+    {
+        auto &point = reconstructed[r];
+        Vertex vertex(point.X, point.Y, point.Z);
+        if (!truthVolume.checkDataObjectInDetectorBounds(vertex))
+            continue;
+        for (auto truthVertex : truthVolume.getVertexesAround(point.X, point.Y, point.Z, config.maxXYDistance, config.maxZDistance, true, false))
+        {
+            double XYdelta = std::hypot(truthVertex->getX() - point.X, truthVertex->getY() - point.Y) / config.maxXYDistance;
+            double Zdelta = std::abs(truthVertex->getZ() - point.Z) / config.maxZDistance;
+            if (XYdelta <= 1 && Zdelta <= 1)
+                candidates.push_back(MatchCandidate{std::hypot(XYdelta, Zdelta), r, truthByVertexIndex[truthVertex->getIndex()]});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<bool> reconstructedMatched(reconstructed.size()), truthMatched(truth.size());
+    std::vector<double> residualsX, residualsY, residualsZ;
+    for (auto &candidate : candidates)
+    {
+        if (reconstructedMatched[candidate.reconstructed] || truthMatched[candidate.truth])
+            continue;
+        reconstructedMatched[candidate.reconstructed] = truthMatched[candidate.truth] = true;
+
+        auto &point = reconstructed[candidate.reconstructed];
+        auto &truthPoint = truth[candidate.truth];
+        result.matchedReconstructedCount++;
+        result.matchedTruthCount += truthPoint.daughtersCount >= config.minTruthDaughters;
+        residualsX.push_back(point.X - truthPoint.X);
+        residualsY.push_back(point.Y - truthPoint.Y);
+        residualsZ.push_back(point.Z - truthPoint.Z);
+    }
+    calculateResiduals(residualsX, result.biasX, result.resolutionX);
+    calculateResiduals(residualsY, result.biasY, result.resolutionY);
+    calculateResiduals(residualsZ, result.biasZ, result.resolutionZ);
+    return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../downloaders/NativeVertexFile.hpp"
+
+#include <sys/types.h>
+#include <vector>
+
+/** @brief Vertex position with its daughters count, the part of vertex used for matching. */
+struct VertexPoint
+{
+    float X, Y, Z;
+    u_int daughtersCount;
+};
+
+/** @brief Distances within which reconstructed vertex is matched to the truth one. */
+struct VertexMatchingConfig
+{
+    u_int volumeDimension = 20000; // microns, the same as detector volume, vertexes outside are not matched
+    u_int maxXYDistance = 50;      // microns
+    u_int maxZDistance = 300;      // microns
+    u_int minTruthDaughters = 4;   // truth vertexes with less daughters are not counted in efficiency, the search could not find them
+};
+
+/**
+ * @brief Comparison of reconstructed vertexes with truth ones. Efficiency is part of the counted truth vertexes having matched
+ * reconstructed vertex, purity is part of reconstructed vertexes matched to any truth vertex. Resolution is the standard deviation
+ * of the matched position residuals (reconstructed minus truth) and bias is their mean, both in microns.
+ */
+struct VertexMatchingResult
+{
+    u_long truthCount = 0;         // truth vertexes with at least minTruthDaughters daughters
+    u_long reconstructedCount = 0;
+    u_long matchedTruthCount = 0;  // counted truth vertexes having match
+    u_long matchedReconstructedCount = 0;
+    double biasX = 0, biasY = 0, biasZ = 0;
+    double resolutionX = 0, resolutionY = 0, resolutionZ = 0;
+
+    double getEfficiency() const { return truthCount == 0 ? 0 : (double)matchedTruthCount / truthCount; }
+
+    double getPurity() const { return reconstructedCount == 0 ? 0 : (double)matchedReconstructedCount / reconstructedCount; }
+};
+
+/** @brief Positions and daughters counts of all the vertexes of native vertex file. */
+std::vector<VertexPoint> readVertexPoints(const MappedVertexFile &file);
+
+/**
+ * @brief Match reconstructed vertexes to truth ones one to one. Truth vertexes are indexed by DetectorVolume, every reconstructed
+ * vertex takes the truth vertexes within the distances as candidates, and pairs are matched from the closest one (distance is
+ * normalized by maxXYDistance and maxZDistance), so close by vertexes do not steal each other's matches.
+ * @throws std::invalid_argument if distances are zero.
+ */
+VertexMatchingResult matchVertexes(const std::vector<VertexPoint> &reconstructed, const std::vector<VertexPoint> &truth,
+                                   const VertexMatchingConfig &config = VertexMatchingConfig());
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../data_types/Track.hpp"
+#include "../data_types/Vertex.hpp"
+
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Per-run cache of the tracks found around vertexes and their impact parameters.
+ * First association pass stores for each new vertex the tracks got within a search radius enlarged by a margin,
+ * and impact parameters it has calculated. Later passes reuse the list while the vertex moved less than the margin,
+ * so they do not search the detector volume again.
+ * Memory is bounded by the total count of stored tracks, vertexes above the limit are simply not cached.
+ */
+class PairResultCache
+{
+public:
+    /** @brief Marks impact parameter that was not calculated in the first pass. */
+    static constexpr float NOT_CALCULATED = std::numeric_limits<float>::quiet_NaN();
+
+    struct Entry
+    {
+        float X, Y, Z;                       // vertex coordinates when tracks were searched
+        std::vector<Track *> tracks;         // tracks around vertex within enlarged radius
+        std::vector<float> impactParameters; // impact parameters of tracks to vertex at X, Y, Z
+
+        float distanceTo(const Vertex &vertex) const
+        {
+            float dx = vertex.getX() - X;
+            float dy = vertex.getY() - Y;
+            float dz = vertex.getZ() - Z;
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    };
+
+private:
+    std::unordered_map<u_long, Entry> entries; // by vertex index
+    size_t storedTracksCount = 0;
+    size_t maxStoredTracksCount;
+
+public:
+    /** @brief Same selection as DetectorVolume::getTracksAround makes, used to cut the enlarged list to exact radius. */
+    static bool isInSearchRadius(Track *track, const Vertex &vertex, u_int XYdistance, u_int Zdistance)
+    {
+        auto XYdelta = std::sqrt(std::pow(track->getX() - vertex.getX(), 2) + std::pow(track->getY() - vertex.getY(), 2));
+        auto Zdelta = track->getZ() - vertex.getZ();
+        return XYdelta <= XYdistance && Zdelta <= Zdistance;
+    }
+
+    /** @brief Store tracks around indexed vertex. Returns false if memory limit does not allow to store them. */
+    bool store(const Vertex &vertex, u_long vertexIndex, std::vector<Track *> &&tracks, std::vector<float> &&impactParameters)
+    {
+        if (storedTracksCount + tracks.size() > maxStoredTracksCount)
+            return false;
+
+        storedTracksCount += tracks.size();
+        entries[vertexIndex] = Entry{vertex.getX(), vertex.getY(), vertex.getZ(), std::move(tracks), std::move(impactParameters)};
+        return true;
+    }
+
+    /** @return cached entry of the vertex or nullptr. */
+    Entry *find(u_long vertexIndex)
+    {
+        auto it = entries.find(vertexIndex);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    size_t getStoredTracksCount() const { return storedTracksCount; }
+
+    void clear()
+    {
+        entries.clear();
+        storedTracksCount = 0;
+    }
+
+public:
+    PairResultCache(size_t maxStoredTracksCount) : maxStoredTracksCount(maxStoredTracksCount) {}
+
+    virtual ~PairResultCache() {}
+};
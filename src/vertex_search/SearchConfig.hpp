@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Cuts and parameters of the vertex search. Default values are the standard production configuration.
+ * Configuration could be loaded at runtime from the text file with "name = value" lines, '#' starts a comment.
+ */
+struct SearchConfig
+{
+    float neighborTrackXYDistance = 1000; // microns
+    float neighborTrackZDistance = 100;   // microns
+    float vertexToTrackXYDist = 1000;     // microns
+    float vertexToTrackZDist = 1000;      // microns
+    float impactParameter = 15;           // microns
+    float tracksPerpendicular = 10;       // microns
+    int daughtersCountCut = 4;
+    int minuitIterations = 10;            // TMinuit minimization iterations
+    float vertexCloseByXY = 100;          // microns
+    float vertexCloseByZ = 600;           // microns
+    float straightTrackAngleCut = 0.02;   // radian
+    bool cutDirectTracks = true;
+    bool searchSecondaryVertexes = false; // search decay vertexes downstream of the found ones
+    float decayLengthZ = 5000;            // microns, max Z distance from primary to secondary vertex
+    int secondaryDaughtersCountCut = 2;
+
+    bool operator==(const SearchConfig &other) const
+    {
+        return neighborTrackXYDistance == other.neighborTrackXYDistance && neighborTrackZDistance == other.neighborTrackZDistance &&
+               vertexToTrackXYDist == other.vertexToTrackXYDist && vertexToTrackZDist == other.vertexToTrackZDist &&
+               impactParameter == other.impactParameter && tracksPerpendicular == other.tracksPerpendicular &&
+               daughtersCountCut == other.daughtersCountCut && minuitIterations == other.minuitIterations &&
+               vertexCloseByXY == other.vertexCloseByXY && vertexCloseByZ == other.vertexCloseByZ &&
+               straightTrackAngleCut == other.straightTrackAngleCut && cutDirectTracks == other.cutDirectTracks &&
+               searchSecondaryVertexes == other.searchSecondaryVertexes && decayLengthZ == other.decayLengthZ &&
+               secondaryDaughtersCountCut == other.secondaryDaughtersCountCut;
+    }
+
+    bool operator!=(const SearchConfig &other) const { return !(*this == other); }
+
+    /** @brief XY distance around the searched region, where tracks could still belong to vertexes of the region. */
+    float getSearchHaloXY() const { return std::max(neighborTrackXYDistance, vertexToTrackXYDist); }
+
+    /** @brief Z distance around the searched region, where tracks could still belong to vertexes of the region or be parent tracks
+     * of its secondary vertexes.
+     */
+    float getSearchHaloZ() const
+    {
+        return std::max(neighborTrackZDistance, vertexToTrackZDist) + (searchSecondaryVertexes ? decayLengthZ : 0);
+    }
+
+    /** @brief Set one parameter by its name. Throws std::invalid_argument if name is unknown, value is not a number or, for
+     * boolean parameters, not one of true, false, 1 and 0.
+     */
+    void setParameter(const std::string &name, const std::string &value)
+    {
+        const std::pair<const char *, float SearchConfig::*> floatParameters[] = {
+            {"neighborTrackXYDistance", &SearchConfig::neighborTrackXYDistance},
+            {"neighborTrackZDistance", &SearchConfig::neighborTrackZDistance},
+            {"vertexToTrackXYDist", &SearchConfig::vertexToTrackXYDist},
+            {"vertexToTrackZDist", &SearchConfig::vertexToTrackZDist},
+            {"impactParameter", &SearchConfig::impactParameter},
+            {"tracksPerpendicular", &SearchConfig::tracksPerpendicular},
+            {"vertexCloseByXY", &SearchConfig::vertexCloseByXY},
+            {"vertexCloseByZ", &SearchConfig::vertexCloseByZ},
+            {"straightTrackAngleCut", &SearchConfig::straightTrackAngleCut},
+            {"decayLengthZ", &SearchConfig::decayLengthZ}};
+        const std::pair<const char *, int SearchConfig::*> intParameters[] = {
+            {"daughtersCountCut", &SearchConfig::daughtersCountCut},
+            {"minuitIterations", &SearchConfig::minuitIterations},
+            {"secondaryDaughtersCountCut", &SearchConfig::secondaryDaughtersCountCut}};
+        const std::pair<const char *, bool SearchConfig::*> boolParameters[] = {
+            {"cutDirectTracks", &SearchConfig::cutDirectTracks},
+            {"searchSecondaryVertexes", &SearchConfig::searchSecondaryVertexes}};
+
+        try
+        {
+            for (auto &parameter : floatParameters)
+            {
+                if (name == parameter.first)
+                {
+                    this->*parameter.second = std::stof(value);
+                    return;
+                }
+            }
+            for (auto &parameter : intParameters)
+            {
+                if (name == parameter.first)
+                {
+                    this->*parameter.second = std::stoi(value);
+                    return;
+                }
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            throw std::invalid_argument("ERROR in search config: wrong value \"" + value + "\" of parameter " + name);
+        }
+        for (auto &parameter : boolParameters)
+        {
+            if (name == parameter.first)
+            {
+                if (value != "true" && value != "false" && value != "1" && value != "0")
+                {
+                    throw std::invalid_argument("ERROR in search config: wrong value \"" + value + "\" of parameter " + name);
+                }
+                this->*parameter.second = value == "true" || value == "1";
+                return;
+            }
+        }
+        throw std::invalid_argument("ERROR in search config: unknown parameter " + name);
+    }
+
+    /** @brief Load configuration from text file. Parameters absent in file keep their default values. */
+    static SearchConfig loadFromFile(const std::string &fileName)
+    {
+        std::ifstream file(fileName);
+        if (!file.is_open())
+        {
+            throw std::invalid_argument("ERROR - could not open search config file " + fileName);
+        }
+
+        auto trim = [](const std::string &str)
+        {
+            auto begin = str.find_first_not_of(" \t\r");
+            auto end = str.find_last_not_of(" \t\r");
+            return begin == std::string::npos ? std::string() : str.substr(begin, end - begin + 1);
+        };
+
+        SearchConfig config;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+                continue;
+
+            auto separator = line.find('=');
+            if (separator == std::string::npos)
+            {
+                throw std::invalid_argument("ERROR in search config: line without '=' : " + line);
+            }
+            config.setParameter(trim(line.substr(0, separator)), trim(line.substr(separator + 1)));
+        }
+        return config;
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SearchConfig.hpp"
+
+/** @brief Standard production configuration. Search kernels for it are built with all the cuts folded as constants. */
+inline constexpr SearchConfig STANDARD_SEARCH_CONFIG{};
+
+/** @brief Standard production configuration with the decay vertexes search, also built with compile-time cuts. */
+inline constexpr SearchConfig SECONDARY_SEARCH_CONFIG = []
+{
+    SearchConfig config{};
+    config.searchSecondaryVertexes = true;
+    return config;
+}();
+
+inline constexpr char STANDARD_CUTS_NAME[] = "compile-time standard";
+inline constexpr char SECONDARY_CUTS_NAME[] = "compile-time secondary";
+
+/**
+ * @brief Cuts policy of the search kernel with configuration known at compile time.
+ * Every cut read from it is a constant, so the compiler folds it into the hot loops.
+ */
+template <const SearchConfig &CONFIG, const char *NAME>
+struct FixedCuts
+{
+    static constexpr const SearchConfig &config() { return CONFIG; }
+
+    static constexpr const char *name() { return NAME; }
+};
+
+/** @brief Cuts policy of the generic search kernel, reads cuts from configuration loaded at runtime. */
+class RuntimeCuts
+{
+private:
+    const SearchConfig &searchConfig;
+
+public:
+    const SearchConfig &config() const { return searchConfig; }
+
+    static constexpr const char *name() { return "runtime"; }
+
+    RuntimeCuts(const SearchConfig &config) : searchConfig(config) {}
+};
+
+using StandardCuts = FixedCuts<STANDARD_SEARCH_CONFIG, STANDARD_CUTS_NAME>;
+using SecondaryCuts = FixedCuts<SECONDARY_SEARCH_CONFIG, SECONDARY_CUTS_NAME>;
@@ -0,0 +1,192 @@
+#include "TrackPrefilter.hpp"
+#include "../utility/Metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace
+{
+    const size_t PREFILTER_CHUNK_TRACKS = 4096; // tracks columns evaluated at once, fit in L1/L2 cache
+
+    /* Reorder column values by the order of their numbers, scratch keeps the memory between columns. */
+    template <class T>
+    void reorderColumn(std::vector<T> &column, const std::vector<size_t> &order, std::vector<T> &scratch)
+    {
+        scratch.resize(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            scratch[i] = column[order[i]];
+        }
+        column.swap(scratch);
+    }
+}
+
+TrackPrefilter &TrackPrefilter::addCut(const std::string &name, ColumnsPredicate predicate)
+{
+    cuts.push_back({name, std::move(predicate), 0});
+    return *this;
+}
+
+TrackPrefilter &TrackPrefilter::addSlopeCut(float minAngle)
+{
+    // atan(sqrt(tanX^2 + tanY^2)) < minAngle is the same as tanX^2 + tanY^2 < tan(minAngle)^2, without atan and sqrt per track
+    double minTan = std::tan((double)minAngle);
+    float minTan2 = minTan * minTan;
+    return addCut("slope", [minTan2](const Columns &columns, unsigned char *keep)
+                  {
+        const Float_t *tanX = columns.tanX, *tanY = columns.tanY;
+        for (size_t t = 0; t < columns.count; t++)
+        {
+            keep[t] = tanX[t] * tanX[t] + tanY[t] * tanY[t] >= minTan2;
+        } });
+}
+
+TrackPrefilter &TrackPrefilter::addRegionOfInterest(float minX, float maxX, float minY, float maxY, float minZ, float maxZ)
+{
+    return addCut("region of interest", [=](const Columns &columns, unsigned char *keep)
+                  {
+        const Float_t *X = columns.X, *Y = columns.Y, *Z = columns.Z;
+        for (size_t t = 0; t < columns.count; t++)
+        {
+            keep[t] = (X[t] >= minX) & (X[t] <= maxX) & (Y[t] >= minY) & (Y[t] <= maxY) & (Z[t] >= minZ) & (Z[t] <= maxZ);
+        } });
+}
+
+void TrackPrefilter::evaluateCuts(const Columns &columns, unsigned char *passed)
+{
+    keep.resize(std::max(keep.size(), columns.count));
+    std::fill(passed, passed + columns.count, 1);
+    for (auto &cut : cuts)
+    {
+        cut.predicate(columns, keep.data());
+        u_long rejected = 0;
+        for (size_t t = 0; t < columns.count; t++)
+        {
+            rejected += passed[t] & (keep[t] ^ 1);
+            passed[t] &= keep[t];
+        }
+        cut.rejectedCount += rejected;
+    }
+}
+
+size_t TrackPrefilter::partition(TrackColumns &columns)
+{
+    const size_t count = columns.size();
+    inputCount += count;
+    if (cuts.empty())
+        return count;
+
+    passed.resize(count);
+    for (size_t begin = 0; begin < count; begin += PREFILTER_CHUNK_TRACKS)
+    {
+        size_t chunkCount = std::min(count - begin, PREFILTER_CHUNK_TRACKS);
+        evaluateCuts({columns.X.data() + begin, columns.Y.data() + begin, columns.Z.data() + begin, columns.tanX.data() + begin,
+                      columns.tanY.data() + begin, chunkCount},
+                     passed.data() + begin);
+    }
+
+    size_t passedCount = std::count(passed.begin(), passed.end(), 1);
+    if (passedCount == count)
+        return passedCount;
+
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t t = 0; t < count; t++)
+    {
+        if (passed[t])
+            order.push_back(t);
+    }
+    for (size_t t = 0; t < count; t++)
+    {
+        if (!passed[t])
+            order.push_back(t);
+    }
+
+    if (columns.index.empty())
+    {
+        columns.index.resize(count);
+        std::iota(columns.index.begin(), columns.index.end(), 0);
+    }
+    std::vector<Float_t> floatScratch;
+    for (auto column : {&columns.X, &columns.Y, &columns.Z, &columns.tanX, &columns.tanY})
+    {
+        reorderColumn(*column, order, floatScratch);
+    }
+    std::vector<ULong_t> indexScratch;
+    reorderColumn(columns.index, order, indexScratch);
+
+    return passedCount;
+}
+
+size_t TrackPrefilter::partition(std::vector<Track> &tracks)
+{
+    inputCount += tracks.size();
+    if (cuts.empty())
+        return tracks.size();
+
+    passed.resize(tracks.size());
+    for (size_t begin = 0; begin < tracks.size(); begin += PREFILTER_CHUNK_TRACKS)
+    {
+        size_t count = std::min(tracks.size() - begin, PREFILTER_CHUNK_TRACKS);
+        gathered.resize(count);
+        for (size_t t = 0; t < count; t++)
+        {
+            auto &track = tracks[begin + t];
+            gathered.X[t] = track.getX();
+            gathered.Y[t] = track.getY();
+            gathered.Z[t] = track.getZ();
+            gathered.tanX[t] = track.getTanX();
+            gathered.tanY[t] = track.getTanY();
+        }
+        evaluateCuts({gathered.X.data(), gathered.Y.data(), gathered.Z.data(), gathered.tanX.data(), gathered.tanY.data(), count},
+                     passed.data() + begin);
+    }
+
+    size_t passedCount = std::count(passed.begin(), passed.end(), 1);
+    if (passedCount == tracks.size())
+        return passedCount;
+
+    // Passed tracks are compacted to the front, rejected ones are moved aside and back after them.
+    std::vector<Track> rejectedTracks;
+    rejectedTracks.reserve(tracks.size() - passedCount);
+    size_t passedEnd = 0;
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        if (passed[t])
+        {
+            if (passedEnd != t)
+                tracks[passedEnd] = std::move(tracks[t]);
+            passedEnd++;
+        }
+        else
+        {
+            rejectedTracks.push_back(std::move(tracks[t]));
+        }
+    }
+    std::move(rejectedTracks.begin(), rejectedTracks.end(), tracks.begin() + passedCount);
+
+    return passedCount;
+}
+
+void TrackPrefilter::printCutFlow() const
+{
+    for (auto &cut : cuts)
+    {
+        printf("Prefilter cut %s rejected %lu tracks. \n", cut.name.c_str(), cut.rejectedCount);
+    }
+}
+
+void TrackPrefilter::addCutFlowToMetrics() const
+{
+    auto &metrics = getMetrics();
+    metrics.addCount("prefilter.input", inputCount);
+    u_long passedCount = inputCount;
+    for (auto &cut : cuts)
+    {
+        metrics.addCount("prefilter.rejected." + cut.name, cut.rejectedCount);
+        passedCount -= cut.rejectedCount;
+    }
+    metrics.addCount("prefilter.passed", passedCount);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../data_types/Track.hpp"
+#include "../data_types/TrackColumns.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Chain of track cuts applied before the search (straight tracks, region of interest and so on).
+ * Every cut is evaluated by chunks over the tracks columns in plain loops which the compiler vectorizes. Columns read from file
+ * are partitioned before Track objects are created, already created tracks are gathered into columns and then moved in place,
+ * their segments are never copied.
+ */
+class TrackPrefilter
+{
+public:
+    /** @brief Columns of the tracks chunk, count values each. */
+    struct Columns
+    {
+        const Float_t *X, *Y, *Z;
+        const Float_t *tanX, *tanY;
+        size_t count;
+    };
+
+    /** @brief Cut over the tracks columns, sets keep[t] to 1 for the passed tracks and to 0 for the rejected ones. */
+    using ColumnsPredicate = std::function<void(const Columns &columns, unsigned char *keep)>;
+
+private:
+    struct Cut
+    {
+        std::string name;
+        ColumnsPredicate predicate;
+        u_long rejectedCount; // tracks rejected by this cut and passed by all the previous cuts
+    };
+
+    std::vector<Cut> cuts;
+    u_long inputCount = 0; // tracks of all the partitions
+    TrackColumns gathered; // columns of the chunk of already created tracks
+    std::vector<unsigned char> passed, keep;
+
+    /** Evaluate all the cuts over the chunk columns, passed[t] is set to 1 for the tracks passed all of them. */
+    void evaluateCuts(const Columns &columns, unsigned char *passed);
+
+public:
+    /** @brief Add cut to the end of the chain. */
+    TrackPrefilter &addCut(const std::string &name, ColumnsPredicate predicate);
+
+    /** @brief Reject tracks with angle to the Z axis less than minAngle (radians). */
+    TrackPrefilter &addSlopeCut(float minAngle);
+
+    /** @brief Reject tracks with starting point outside of the box, borders are included. */
+    TrackPrefilter &addRegionOfInterest(float minX, float maxX, float minY, float maxY, float minZ, float maxZ);
+
+    bool empty() const { return cuts.empty(); }
+
+    /**
+     * @brief Reorder tracks in place: tracks passed all the cuts go first, then the rejected ones, both in the original order.
+     * @return count of the passed tracks
+     */
+    size_t partition(std::vector<Track> &tracks);
+
+    /**
+     * @brief Reorder tracks columns in place like the tracks partition, before Track objects are created from them.
+     * Index column is filled if it was empty, so tracks keep their numbers in the original columns.
+     * @return count of the passed tracks
+     */
+    size_t partition(TrackColumns &columns);
+
+    /** @brief Print tracks count rejected by each cut, summed over all the partitions. */
+    void printCutFlow() const;
+
+    /** @brief Add the cut flow to the metrics registry: counters prefilter.input, prefilter.rejected.<cut name> and prefilter.passed. */
+    void addCutFlowToMetrics() const;
+
+    u_long getRejectedCount(size_t cutNumber) const { return cuts.at(cutNumber).rejectedCount; }
+};
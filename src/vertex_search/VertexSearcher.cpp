@@ -5,11 +5,15 @@
 #include "../data_types/Track.hpp"
 #include "../data_types/Vertex.hpp"
 #include "../utility/CalculationAndAlgorithms.hpp"
+#include "../utility/GeometryKernels.hpp"
+#include "../utility/Metrics.hpp"
+#include "SearchKernels.hpp"
+#include "PairResultCache.hpp"
 
 #include <unordered_set>
+#include <algorithm>
 #include <cmath>
 #include <functional>
-#include <immintrin.h>
 #include <iostream>
 
 #include <TMinuit.h>
@@ -18,32 +22,32 @@ using namespace std;
 
 namespace
 {
-    const float NEIGHBOR_TRACK_XY_DISTANCE = 1000; // microns
-    const float NEIGHBOR_TRACK_Z_DISTANCE = 100;   // microns
-    const float VERTEX_TO_TRACK_XY_DIST = 1000;    // microns
-    const float VERTEX_TO_TRACK_Z_DIST = 1000;     // microns
-    const float IMPACT_PARAMETER = 15;             // microns
-    const float TRACKS_PERPENDICULAR = 10;         // microns
-    const float DIRECT_TRACK_ANGLE = 0.02;         // radians
-    const int DAUGHTERS_COUNT_CUT = 4;
-    const int MINUIT_ITERATIONS = 10;      // TMinuit minimization iterations
-    const float VERTEX_CLOSE_BY_X_Y = 100; // microns
-    const float VERTEX_CLOSE_BY_Z = 600;   // microns
+    // Search cuts are defined by SearchConfig, see SearchKernels.hpp for compile-time configurations.
     const bool PRINT_VERT_STAT = true;
+    const u_int PAIR_CACHE_MARGIN = 20;                // microns, vertex may move so far after fit and still reuse cached tracks
+    const size_t PAIR_CACHE_MAX_TRACKS = 1 << 22;      // default memory limit of the pair result cache, in stored tracks
+    const float IMPACT_PARAMETER_TOLERANCE = 0.01;     // microns, float rounding of impact parameter calculation
+    const float PARALLEL_TRACKS_SIN2 = 1e-8;           // squared sine of tracks angle (1e-4 rad), vertex position is undetermined, pair is rejected
+    const float ILL_CONDITIONED_TRACKS_SIN2 = 1e-4;    // squared sine of tracks angle (1e-2 rad), float determinants lose precision, pair is calculated in double
 
-    Vertex *vertex_ptr = nullptr;
+    // Fit state is per thread, so independent searches (batch mode workers) could run in parallel.
+    thread_local Vertex *vertex_ptr = nullptr;
+    thread_local TrackBatch fitTracks;      // daughter tracks of the fitted vertex, gathered once per fit
+    thread_local std::vector<float> fitImpactParameters;
 
-    std::unique_ptr<TMinuit> minuit;
+    thread_local std::unique_ptr<TMinuit> minuit;
 
-    bool checkVertexAndDaughterTracksCuts(Vertex &vertex, Track *track1, Track *track2)
+    template <class Cuts>
+    bool checkVertexAndDaughterTracksCuts(const Cuts &cuts, Vertex &vertex, Track *track1, Track *track2)
     {
+        const float vertexToTrackZDist = cuts.config().vertexToTrackZDist;
         float tr1z = track1->getZ();
         float tr2z = track2->getZ();
-        if (vertex.getZ() < tr1z - VERTEX_TO_TRACK_Z_DIST | vertex.getZ() < tr2z - VERTEX_TO_TRACK_Z_DIST)
+        if (vertex.getZ() < tr1z - vertexToTrackZDist | vertex.getZ() < tr2z - vertexToTrackZDist)
         {
             return false;
         }
-        if (vertex.getZ() > tr1z + VERTEX_TO_TRACK_Z_DIST | vertex.getZ() > tr2z + VERTEX_TO_TRACK_Z_DIST)
+        if (vertex.getZ() > tr1z + vertexToTrackZDist | vertex.getZ() > tr2z + vertexToTrackZDist)
         {
             return false;
         }
@@ -53,13 +57,15 @@ namespace
     /* Checks if vertex positions are close enough so that vertices can be considered as one.
      * Returns true if vertices should be united, false otherwise.
      */
-    bool checkIfVerticesAreClose(Vertex &vertex_1, Vertex &vertex_2)
+    template <class Cuts>
+    bool checkIfVerticesAreClose(const Cuts &cuts, Vertex &vertex_1, Vertex &vertex_2)
     {
+        const float vertexCloseByXY = cuts.config().vertexCloseByXY;
         float dx = abs(vertex_1.getX() - vertex_2.getX());
         float dy = abs(vertex_1.getY() - vertex_2.getY());
         float dz = abs(vertex_1.getZ() - vertex_2.getZ());
 
-        return dx * dx + dy * dy < VERTEX_CLOSE_BY_X_Y * VERTEX_CLOSE_BY_X_Y && dz < VERTEX_CLOSE_BY_Z;
+        return dx * dx + dy * dy < vertexCloseByXY * vertexCloseByXY && dz < cuts.config().vertexCloseByZ;
     }
 
     bool checkTrackAngleLessThanCut(Track *track, float angleCut)
@@ -79,11 +85,10 @@ namespace
         Vertex vertex(coordinate[0], coordinate[1], coordinate[2]);
         f = 0;
 
-        for (int t = 0; t < vertex_ptr->getDaughterTracksCount(); t++)
+        CalculationAndAlgorithms::calculateImpactParameters(vertex, fitTracks, fitImpactParameters.data());
+        for (size_t t = 0; t < fitTracks.size(); t++)
         {
-            auto track = vertex_ptr->getDaughterTrack(t);
-
-            f += CalculationAndAlgorithms::calculateImpactParameter(vertex, track);
+            f += fitImpactParameters[t];
         }
     }
 
@@ -93,9 +98,21 @@ namespace
     std::optional<Vertex> recalculateVertexPosition(DetectorVolume &detectorVolume, Vertex &vertex, Double_t &error, int iterations)
     {
         vertex_ptr = &vertex;
+        fitTracks.clear();
+        for (u_int t = 0; t < vertex.getDaughterTracksCount(); t++)
+        {
+            fitTracks.add(vertex.getDaughterTrack(t));
+        }
+        fitImpactParameters.resize(fitTracks.size());
 
         Int_t ierflg;
 
+        if (!minuit)
+        {
+            minuit = std::make_unique<TMinuit>(3);
+            minuit->SetFCN(FCN);
+            minuit->SetPrintLevel(-1);
+        }
         minuit->mnparm(0, "x", vertex.getX(), 1, 0, 0, ierflg);
         minuit->mnparm(1, "y", vertex.getY(), 1, 0, 0, ierflg);
         minuit->mnparm(2, "z", vertex.getZ(), 1, 0, 0, ierflg);
@@ -137,203 +154,797 @@ namespace
         // }
         return newVertex;
     }
-}
 
-std::optional<Vertex> VertexSearcher::calculateVertexCoordinates(Track &t1, Track &t2)
-{
-    __m256 coord1 = _mm256_set_ps(0, 0, 0, 0, 0, t1.getZ(), t1.getY(), t1.getX());
-    __m256 coord2 = _mm256_set_ps(0, 0, 0, 0, 0, t2.getZ(), t2.getY(), t2.getX());
-    __m256 dir1 = _mm256_set_ps(0, 0, 0, 0, 0, t1.getTanZ(), t1.getTanY(), t1.getTanX());
-    __m256 dir2 = _mm256_set_ps(0, 0, 0, 0, 0, t2.getTanZ(), t2.getTanY(), t2.getTanX());
-
-    auto pointDist = _mm256_sub_ps(coord2, coord1);
-    auto mixed = std::abs(CalculationAndAlgorithms::mixedProduct(pointDist, dir1, dir2));
-    auto dirDot = CalculationAndAlgorithms::crossProduct(dir1, dir2);
-    auto dirDotMagn = CalculationAndAlgorithms::vectorMagnitude(dirDot);
-    auto perpendicular = mixed / dirDotMagn;
-    float perpFloored = floor(perpendicular * 100) / 100;
-
-    if (perpendicular > TRACKS_PERPENDICULAR)
-        return std::nullopt;
-
-    __m256 vec1general = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[0], -t1.getTanX(), t2.getTanX());
-    __m256 vec2general = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[1], -t1.getTanY(), t2.getTanY());
-    __m256 vec3general = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[2], -t1.getTanZ(), t2.getTanZ());
-    auto detGeneral = CalculationAndAlgorithms::mixedProduct(vec1general, vec2general, vec3general);
-
-    __m256 vec1first = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[0], -t1.getTanX(), t1.getX() - t2.getX());
-    __m256 vec2first = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[1], -t1.getTanY(), t1.getY() - t2.getY());
-    __m256 vec3first = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[2], -t1.getTanZ(), t1.getZ() - t2.getZ());
-    auto detFirst = CalculationAndAlgorithms::mixedProduct(vec1first, vec2first, vec3first);
-
-    __m256 vec1second = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[0], t1.getX() - t2.getX(), t2.getTanX());
-    __m256 vec2second = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[1], t1.getY() - t2.getY(), t2.getTanY());
-    __m256 vec3second = _mm256_set_ps(0, 0, 0, 0, 0, -CalculationAndAlgorithms::crossProduct(dir1, dir2)[2], t1.getZ() - t2.getZ(), t2.getTanZ());
-    auto detSecond = CalculationAndAlgorithms::mixedProduct(vec1second, vec2second, vec3second);
-
-    auto variableS = detFirst / detGeneral;
-    auto variableT = detSecond / detGeneral;
-
-    Vertex vertex(floor(((t2.getTanX() * variableS + t2.getX() + t1.getTanX() * variableT + t1.getX()) / 2) * 100) / 100,
-                  floor(((t2.getTanY() * variableS + t2.getY() + t1.getTanY() * variableT + t1.getY()) / 2) * 100) / 100,
-                  floor(((t2.getTanZ() * variableS + t2.getZ() + t1.getTanZ() * variableT + t1.getZ()) / 2) * 100) / 100);
-
-    return vertex;
-}
+    /* Same vertex as calculateVertexCoordinates, but calculated in double for tracks with small angle between them,
+    where float Cramer's determinants are close to zero. Vertex is the middle of the common perpendicular P1 + S * D1, P2 + T * D2.
+     */
+    template <class Cuts>
+    std::optional<Vertex> calculateVertexCoordinatesPrecise(const Cuts &cuts, Track &t1, Track &t2)
+    {
+        const double p1[3] = {t1.getX(), t1.getY(), t1.getZ()};
+        const double p2[3] = {t2.getX(), t2.getY(), t2.getZ()};
+        const double d1[3] = {t1.getTanX(), t1.getTanY(), t1.getTanZ()};
+        const double d2[3] = {t2.getTanX(), t2.getTanY(), t2.getTanZ()};
 
-void VertexSearcher::searchVertexes(DetectorVolume &detectorVolume)
-{
-    u_long vertexDuplicate = 0;
-    u_long noVertexCount = 0;
-    u_long trackEqlsNeighbor = 0;
-    u_long vertexOutOfBounds = 0;
-    u_long vertexAlongFromTracks = 0;
-    u_long excludedTrackTouched = 0;
-
-    for (auto track : detectorVolume.getAllTracks())
+        auto cross = [](const double *a, const double *b, double *result)
+        {
+            result[0] = a[1] * b[2] - a[2] * b[1];
+            result[1] = a[2] * b[0] - a[0] * b[2];
+            result[2] = a[0] * b[1] - a[1] * b[0];
+        };
+        auto dot = [](const double *a, const double *b)
+        { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+
+        double normal[3], pointDist[3] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+        cross(d1, d2, normal);
+        double normalMagn2 = dot(normal, normal);
+
+        double perpendicular = std::abs(dot(pointDist, normal)) / std::sqrt(normalMagn2);
+        if (perpendicular > cuts.config().tracksPerpendicular)
+            return std::nullopt;
+
+        double distCrossDir1[3], distCrossDir2[3];
+        cross(pointDist, d2, distCrossDir2);
+        cross(pointDist, d1, distCrossDir1);
+        double variableS = dot(distCrossDir2, normal) / normalMagn2;
+        double variableT = dot(distCrossDir1, normal) / normalMagn2;
+
+        Vertex vertex(floor(((p1[0] + d1[0] * variableS + p2[0] + d2[0] * variableT) / 2) * 100) / 100,
+                      floor(((p1[1] + d1[1] * variableS + p2[1] + d2[1] * variableT) / 2) * 100) / 100,
+                      floor(((p1[2] + d1[2] * variableS + p2[2] + d2[2] * variableT) / 2) * 100) / 100);
+        return vertex;
+    }
+
+    /* Vertex as the middle of the common perpendicular to the tracks lines, float calculation by Cramer's rule in dispatched kernels.
+    Tracks with small angle between them are checked by the squared sine of the angle before dividing by the determinant:
+    nearly parallel tracks are rejected, ill-conditioned pairs are recalculated in double.
+     */
+    template <class Cuts>
+    std::optional<Vertex> calculateVertexCoordinates(const Cuts &cuts, Track &t1, Track &t2)
     {
-        auto neighborTracks = detectorVolume.getTracksAround(track->getX(), track->getY(), track->getZ(), NEIGHBOR_TRACK_XY_DISTANCE, NEIGHBOR_TRACK_Z_DISTANCE, true, false);
+        const float point1[3] = {t1.getX(), t1.getY(), t1.getZ()};
+        const float point2[3] = {t2.getX(), t2.getY(), t2.getZ()};
+        const float direction1[3] = {t1.getTanX(), t1.getTanY(), t1.getTanZ()};
+        const float direction2[3] = {t2.getTanX(), t2.getTanY(), t2.getTanZ()};
+
+        LinesApproach approach;
+        getGeometryKernels().linesApproach(point1, direction1, point2, direction2, ILL_CONDITIONED_TRACKS_SIN2, cuts.config().tracksPerpendicular, approach);
+
+        if (!(approach.angleSin2 >= PARALLEL_TRACKS_SIN2))
+            return std::nullopt;
+        if (approach.angleSin2 < ILL_CONDITIONED_TRACKS_SIN2)
+            return calculateVertexCoordinatesPrecise(cuts, t1, t2);
+
+        if (approach.perpendicular > cuts.config().tracksPerpendicular)
+            return std::nullopt;
+
+        auto variableS = approach.variableS;
+        auto variableT = approach.variableT;
+
+        Vertex vertex(floor(((t2.getTanX() * variableS + t2.getX() + t1.getTanX() * variableT + t1.getX()) / 2) * 100) / 100,
+                      floor(((t2.getTanY() * variableS + t2.getY() + t1.getTanY() * variableT + t1.getY()) / 2) * 100) / 100,
+                      floor(((t2.getTanZ() * variableS + t2.getZ() + t1.getTanZ() * variableT + t1.getZ()) / 2) * 100) / 100);
+
+        return vertex;
+    }
+
+    /* Counters of the search steps, printed at the end of search and added to the metrics registry.
+     */
+    struct SearchStatistics
+    {
+        u_long testedPairs = 0;
+        u_long vertexDuplicate = 0;
+        u_long noVertexCount = 0;
+        u_long trackEqlsNeighbor = 0;
+        u_long vertexOutOfBounds = 0;
+        u_long vertexAlongFromTracks = 0;
+        u_long excludedTrackTouched = 0;
+        u_long vertexesCreated = 0;
+        u_long smallVertexesDeleted = 0;
+        u_long cacheMissed = 0;
+        u_long impactParameterReused = 0;
+        u_long impactParameterRecalculated = 0;
+        u_long tracksJoinedFoundVertexes = 0;
+        u_long vertexesMerged = 0;
+
+        void print(PairResultCache &pairCache)
+        {
+            printf("testedPairs=%li noVertexCount=%li vertexDuplicates=%li vertexAlongFromTracks=%li vertexOutOfBounds=%li trackEqlsNeighbor=%li excludedTrackTouched=%li\n",
+                   testedPairs, noVertexCount, vertexDuplicate, vertexAlongFromTracks, vertexOutOfBounds, trackEqlsNeighbor, excludedTrackTouched);
+            printf("Pair cache: %li tracks stored, vertexes missed=%li impactParametersReused=%li impactParametersRecalculated=%li\n",
+                   pairCache.getStoredTracksCount(), cacheMissed, impactParameterReused, impactParameterRecalculated);
+        }
 
-        for (auto neighborTrack : neighborTracks)
+        /* Counters are added in the cut flow order: neighbour pairs, pairs rejected by every cut, created vertexes, vertexes deleted
+        after the search and the remaining ones. Names are prefixed by the search kind. */
+        void addToMetrics(const std::string &search, u_long vertexesCount) const
         {
-            if (neighborTrack->isExcluded())
+            auto &metrics = getMetrics();
+            metrics.addCount(search + ".neighborPairs", excludedTrackTouched + trackEqlsNeighbor + testedPairs);
+            metrics.addCount(search + ".excludedTrackTouched", excludedTrackTouched);
+            metrics.addCount(search + ".trackEqlsNeighbor", trackEqlsNeighbor);
+            metrics.addCount(search + ".testedPairs", testedPairs);
+            metrics.addCount(search + ".noVertexCount", noVertexCount);
+            metrics.addCount(search + ".vertexOutOfBounds", vertexOutOfBounds);
+            metrics.addCount(search + ".vertexAlongFromTracks", vertexAlongFromTracks);
+            metrics.addCount(search + ".vertexDuplicates", vertexDuplicate);
+            metrics.addCount(search + ".vertexesCreated", vertexesCreated);
+            metrics.addCount(search + ".tracksJoinedFoundVertexes", tracksJoinedFoundVertexes);
+            metrics.addCount(search + ".vertexesMerged", vertexesMerged);
+            metrics.addCount(search + ".smallVertexesDeleted", smallVertexesDeleted);
+            metrics.addCount(search + ".vertexes", vertexesCount);
+            metrics.addCount(search + ".pairCacheMissed", cacheMissed);
+            metrics.addCount(search + ".impactParametersReused", impactParameterReused);
+            metrics.addCount(search + ".impactParametersRecalculated", impactParameterRecalculated);
+        }
+    };
+
+    /* Indexes of vertexes a search step works with. Null pointer instead of set means all the vertexes.
+     */
+    using VertexIndexes = std::unordered_set<u_long>;
+
+    bool isSelected(const VertexIndexes *selection, Vertex *vertex)
+    {
+        return selection == nullptr || selection->count(vertex->getIndex()) != 0;
+    }
+
+    struct VertexStruct
+    {
+        u_long index;
+        float X, Y, Z;
+    };
+
+    /* Each seed track is paired with its neighbors, found vertexes are saved in detector volume together with tracks
+    attached by impact parameter. Indexes of new vertexes are added to newVertexes.
+     */
+    template <class Cuts>
+    void searchTrackPairs(const Cuts &cuts, DetectorVolume &detectorVolume, const std::vector<Track *> &seedTracks,
+                          PairResultCache &pairCache, SearchStatistics &stats, VertexIndexes &newVertexes)
+    {
+        const SearchConfig &config = cuts.config();
+        TrackBatch candidateTracks;           // tracks around new vertex passing distance cuts
+        std::vector<size_t> candidateNumbers; // their numbers in the list of tracks around
+        std::vector<float> candidateImpactParameters;
+
+        for (auto track : seedTracks)
+        {
+            auto neighborTracks = detectorVolume.getTracksAround(track->getX(), track->getY(), track->getZ(), config.neighborTrackXYDistance, config.neighborTrackZDistance, true, false);
+
+            for (auto neighborTrack : neighborTracks)
             {
-                excludedTrackTouched++;
+                if (neighborTrack->isExcluded())
+                {
+                    stats.excludedTrackTouched++;
+                    continue;
+                }
+
+                if (neighborTrack == track)
+                {
+                    stats.trackEqlsNeighbor++;
+                    continue;
+                }
+
+                stats.testedPairs++;
+                auto vertexOpt = calculateVertexCoordinates(cuts, *track, *neighborTrack);
+
+                if (!vertexOpt.has_value())
+                {
+                    stats.noVertexCount++;
+                    continue;
+                }
+
+                auto vertex = vertexOpt.value();
+                if (!detectorVolume.checkDataObjectInDetectorBounds(vertex))
+                {
+                    stats.vertexOutOfBounds++;
+                    continue;
+                }
+
+                if (!checkVertexAndDaughterTracksCuts(cuts, vertex, track, neighborTrack))
+                {
+                    stats.vertexAlongFromTracks++;
+                    continue;
+                }
+
+                if (detectorVolume.checkVertexPresenceByCoordinates(vertex.getX(), vertex.getY(), vertex.getZ())) // vertex was allready found before
+                {
+                    stats.vertexDuplicate++;
+                    continue;
+                }
+                track->setAsExcluded();
+                neighborTrack->setAsExcluded();
+
+                // Tracks are taken within radius enlarged by cache margin, so the list stays valid for the second pass.
+                auto moreNeighborTracks = detectorVolume.getTracksAround(vertex.getX(), vertex.getY(), vertex.getZ(), config.vertexToTrackXYDist + PAIR_CACHE_MARGIN, config.vertexToTrackZDist + PAIR_CACHE_MARGIN, true, false);
+                std::vector<float> impactParameters(moreNeighborTracks.size(), PairResultCache::NOT_CALCULATED);
+
+                candidateTracks.clear();
+                candidateNumbers.clear();
+                for (size_t i = 0; i < moreNeighborTracks.size(); i++)
+                {
+                    auto moreTrack = moreNeighborTracks[i];
+                    if (moreTrack->isExcluded())
+                        continue;
+                    if (moreTrack->getZ() < vertex.getZ())
+                        continue;
+                    if (!PairResultCache::isInSearchRadius(moreTrack, vertex, config.vertexToTrackXYDist, config.vertexToTrackZDist))
+                        continue;
+
+                    candidateTracks.add(moreTrack);
+                    candidateNumbers.push_back(i);
+                }
+                candidateImpactParameters.resize(candidateTracks.size());
+                CalculationAndAlgorithms::calculateImpactParameters(vertex, candidateTracks, candidateImpactParameters.data());
+
+                for (size_t c = 0; c < candidateTracks.size(); c++)
+                {
+                    auto moreTrack = candidateTracks.getTrack(c);
+                    impactParameters[candidateNumbers[c]] = candidateImpactParameters[c];
+                    if (candidateImpactParameters[c] < config.impactParameter)
+                    {
+                        moreTrack->setAsExcluded();
+                        vertex.addDaughterTrack(moreTrack);
+                    }
+                }
+
+                vertex.addDaughterTrack(track);
+                vertex.addDaughterTrack(neighborTrack);
+
+                detectorVolume.addNewUnindexedVertex(vertex); // vertex index is initialized here
+                newVertexes.insert(vertex.getIndex());
+                stats.vertexesCreated++;
+                pairCache.store(vertex, vertex.getIndex(), std::move(moreNeighborTracks), std::move(impactParameters));
+            }
+        }
+    }
+
+    /* Recalculating positions of selected vertexes with more than two daughter tracks.
+     */
+    template <class Cuts>
+    void fitVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, const VertexIndexes *selection)
+    {
+        std::vector<VertexStruct> vertexesToDelete;
+        std::vector<Vertex> vertexesToAdd;
+
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (vertex->getDaughterTracksCount() <= 2 || !isSelected(selection, vertex))
                 continue;
+            Double_t error = 0;
+            auto optVertex = recalculateVertexPosition(detectorVolume, *vertex, error, cuts.config().minuitIterations);
+            if (optVertex.has_value())
+            {
+                auto newVertex = optVertex.value();
+                newVertex.copyTracksArrays(*vertex);
+                newVertex.setIndex(vertex->getIndex());
+
+                vertexesToDelete.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
+                vertexesToAdd.push_back(newVertex);
             }
+        }
 
-            if (neighborTrack == track)
+        for (auto vertex : vertexesToDelete)
+        {
+            detectorVolume.deleteVertex(vertex.index, vertex.X, vertex.Y, vertex.Z);
+        }
+        for (auto vertex : vertexesToAdd)
+        {
+            detectorVolume.addNewUnindexedVertex(vertex);
+        }
+    }
+
+    /* Attach to selected vertexes more tracks passing impact parameter cut, reusing tracks lists cached by pair search.
+     */
+    template <class Cuts>
+    void attachMoreTracks(const Cuts &cuts, DetectorVolume &detectorVolume, const VertexIndexes *selection, PairResultCache &pairCache, SearchStatistics &stats)
+    {
+        const SearchConfig &config = cuts.config();
+        TrackBatch candidateTracks;
+        std::vector<float> candidateImpactParameters;
+        std::vector<float> impactParameters;
+
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (!isSelected(selection, vertex))
+                continue;
+
+            auto cached = pairCache.find(vertex->getIndex());
+            if (cached == nullptr || cached->distanceTo(*vertex) > PAIR_CACHE_MARGIN)
             {
-                trackEqlsNeighbor++;
+                stats.cacheMissed++;
+                auto moreNeighborTracks = detectorVolume.getTracksAround(vertex->getX(), vertex->getY(), vertex->getZ(), config.vertexToTrackXYDist, config.vertexToTrackZDist, true, false);
+
+                candidateTracks.clear();
+                for (auto moreTrack : moreNeighborTracks)
+                {
+                    if (!moreTrack->isExcluded())
+                        candidateTracks.add(moreTrack);
+                }
+                candidateImpactParameters.resize(candidateTracks.size());
+                CalculationAndAlgorithms::calculateImpactParameters(*vertex, candidateTracks, candidateImpactParameters.data());
+
+                for (size_t c = 0; c < candidateTracks.size(); c++)
+                {
+                    auto moreTrack = candidateTracks.getTrack(c);
+                    if (candidateImpactParameters[c] < config.impactParameter)
+                    {
+                        moreTrack->setAsExcluded();
+                        vertex->addDaughterTrack(moreTrack);
+                    }
+                }
                 continue;
             }
 
-            auto vertexOpt = calculateVertexCoordinates(*track, *neighborTrack);
+            // Impact parameter changes not more than the vertex shift, so the cached one decides unless it is that close to the cut.
+            // Tracks needing recalculation are gathered to one batch, then all the tracks are attached in the cached order.
+            float vertexShift = cached->distanceTo(*vertex) + IMPACT_PARAMETER_TOLERANCE;
+            impactParameters.assign(cached->tracks.size(), PairResultCache::NOT_CALCULATED);
+            candidateTracks.clear();
+            for (size_t i = 0; i < cached->tracks.size(); i++)
+            {
+                auto moreTrack = cached->tracks[i];
+                if (moreTrack->isExcluded())
+                    continue;
+                if (!PairResultCache::isInSearchRadius(moreTrack, *vertex, config.vertexToTrackXYDist, config.vertexToTrackZDist))
+                    continue;
+
+                float impactParameter = cached->impactParameters[i];
+                if (std::isnan(impactParameter) || std::abs(impactParameter - config.impactParameter) <= vertexShift)
+                {
+                    candidateTracks.add(moreTrack);
+                    stats.impactParameterRecalculated++;
+                }
+                else
+                {
+                    impactParameters[i] = impactParameter;
+                    stats.impactParameterReused++;
+                }
+            }
+            candidateImpactParameters.resize(candidateTracks.size());
+            CalculationAndAlgorithms::calculateImpactParameters(*vertex, candidateTracks, candidateImpactParameters.data());
 
-            if (!vertexOpt.has_value())
+            for (size_t i = 0, c = 0; i < cached->tracks.size(); i++)
             {
-                noVertexCount++;
-                continue;
+                auto moreTrack = cached->tracks[i];
+                if (c < candidateTracks.size() && candidateTracks.getTrack(c) == moreTrack)
+                    impactParameters[i] = candidateImpactParameters[c++];
+                else if (std::isnan(impactParameters[i]))
+                    continue;
+
+                if (impactParameters[i] < config.impactParameter)
+                {
+                    moreTrack->setAsExcluded();
+                    vertex->addDaughterTrack(moreTrack);
+                }
             }
+        }
+    }
 
-            auto vertex = vertexOpt.value();
-            if (!detectorVolume.checkDataObjectInDetectorBounds(vertex))
+    /* Delete selected vertexes for which shouldDelete returns true. Their daughter tracks, which are not attached to any other vertex,
+    become free for the next searches. Returns count of the deleted vertexes.
+     */
+    template <class Predicate>
+    u_long deleteVertexesIf(DetectorVolume &detectorVolume, const VertexIndexes *selection, Predicate shouldDelete)
+    {
+        std::vector<VertexStruct> vertexesToDelete;
+        std::unordered_set<Track *> freedTracks;
+
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (shouldDelete(*vertex) && isSelected(selection, vertex))
             {
-                vertexOutOfBounds++;
-                continue;
+                vertexesToDelete.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
+                for (u_int t = 0; t < vertex->getDaughterTracksCount(); t++)
+                {
+                    freedTracks.insert(vertex->getDaughterTrack(t));
+                }
             }
+        }
+        for (auto vertex : vertexesToDelete)
+        {
+            detectorVolume.deleteVertex(vertex.index, vertex.X, vertex.Y, vertex.Z);
+        }
 
-            if (!checkVertexAndDaughterTracksCuts(vertex, track, neighborTrack))
+        // Seed track may be the daughter of several vertexes
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            for (u_int t = 0; t < vertex->getDaughterTracksCount() && !freedTracks.empty(); t++)
             {
-                vertexAlongFromTracks++;
+                freedTracks.erase(vertex->getDaughterTrack(t));
+            }
+        }
+        for (auto track : freedTracks)
+        {
+            track->setAsIncluded();
+        }
+        return vertexesToDelete.size();
+    }
+
+    /* Delete selected vertexes with daughter tracks count less than cut. Returns count of the deleted vertexes.
+     */
+    template <class Cuts>
+    u_long deleteSmallVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, const VertexIndexes *selection)
+    {
+        auto deletedCount = deleteVertexesIf(detectorVolume, selection, [&cuts](Vertex &vertex)
+                                             { return vertex.getDaughterTracksCount() < cuts.config().daughtersCountCut; });
+        printf("Deleted %lu vertexes with daughter tracks count < %i . \n", deletedCount, cuts.config().daughtersCountCut);
+        return deletedCount;
+    }
+
+    /* Free tracks join the closest vertexes found before, if they pass impact parameter cut. Changed vertexes indexes are added to changedVertexes.
+     */
+    template <class Cuts>
+    void attachTracksToFoundVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, const std::vector<Track *> &tracks,
+                                     SearchStatistics &stats, VertexIndexes &changedVertexes)
+    {
+        const SearchConfig &config = cuts.config();
+
+        for (auto track : tracks)
+        {
+            if (track->isExcluded())
                 continue;
+
+            Vertex *closestVertex = nullptr;
+            Double_t closestImpactParameter = config.impactParameter;
+            for (auto vertex : detectorVolume.getVertexesAround(track->getX(), track->getY(), track->getZ(), config.vertexToTrackXYDist, config.vertexToTrackZDist, true, false))
+            {
+                if (track->getZ() < vertex->getZ())
+                    continue;
+
+                auto impactParameter = CalculationAndAlgorithms::calculateImpactParameter(*vertex, track);
+                if (impactParameter < closestImpactParameter)
+                {
+                    closestImpactParameter = impactParameter;
+                    closestVertex = vertex;
+                }
             }
 
-            if (detectorVolume.checkVertexPresenceByCoordinates(vertex.getX(), vertex.getY(), vertex.getZ())) // vertex was allready found before
+            if (closestVertex != nullptr)
             {
-                vertexDuplicate++;
+                track->setAsExcluded();
+                closestVertex->addDaughterTrack(track);
+                changedVertexes.insert(closestVertex->getIndex());
+                stats.tracksJoinedFoundVertexes++;
+            }
+        }
+    }
+
+    /* New vertexes close to vertexes found before are merged into the closest of them, their daughter tracks are moved to the old
+    vertex. Old vertexes which got tracks are fitted again.
+     */
+    template <class Cuts>
+    void mergeNewVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, VertexIndexes &newVertexes, SearchStatistics &stats, VertexIndexes &changedVertexes)
+    {
+        const SearchConfig &config = cuts.config();
+
+        std::vector<VertexStruct> vertexesToMerge;
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (newVertexes.count(vertex->getIndex()) != 0)
+                vertexesToMerge.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
+        }
+
+        VertexIndexes mergedVertexes;
+        for (auto &newVertexStruct : vertexesToMerge)
+        {
+            Vertex *newVertex = nullptr;
+            Vertex *oldVertex = nullptr;
+            float oldVertexDistance2 = 0;
+            auto vertexesAround = detectorVolume.getVertexesAround(newVertexStruct.X, newVertexStruct.Y, newVertexStruct.Z, config.vertexCloseByXY, config.vertexCloseByZ, true, false);
+            for (auto vertex : vertexesAround)
+            {
+                if (vertex->getIndex() == newVertexStruct.index)
+                    newVertex = vertex;
+            }
+            if (newVertex == nullptr)
                 continue;
+            for (auto vertex : vertexesAround)
+            {
+                if (newVertexes.count(vertex->getIndex()) != 0 || !checkIfVerticesAreClose(cuts, *newVertex, *vertex))
+                    continue;
+                float dx = vertex->getX() - newVertexStruct.X, dy = vertex->getY() - newVertexStruct.Y, dz = vertex->getZ() - newVertexStruct.Z;
+                float distance2 = dx * dx + dy * dy + dz * dz;
+                if (oldVertex == nullptr || distance2 < oldVertexDistance2)
+                {
+                    oldVertex = vertex;
+                    oldVertexDistance2 = distance2;
+                }
             }
-            track->setAsExcluded();
-            neighborTrack->setAsExcluded();
+            if (oldVertex == nullptr)
+                continue;
 
-            auto moreNeighborTracks = detectorVolume.getTracksAround(vertex.getX(), vertex.getY(), vertex.getZ(), VERTEX_TO_TRACK_XY_DIST, VERTEX_TO_TRACK_Z_DIST, true, false);
+            for (u_int t = 0; t < newVertex->getDaughterTracksCount(); t++)
+            {
+                oldVertex->addDaughterTrack(newVertex->getDaughterTrack(t));
+            }
+            changedVertexes.insert(oldVertex->getIndex());
+            mergedVertexes.insert(oldVertex->getIndex());
+            newVertexes.erase(newVertexStruct.index);
+            changedVertexes.erase(newVertexStruct.index);
+            detectorVolume.deleteVertex(newVertexStruct.index, newVertexStruct.X, newVertexStruct.Y, newVertexStruct.Z);
+            stats.vertexesMerged++;
+        }
+
+        // position of the old vertex is fitted with the merged tracks too, index stays the same
+        fitVertexes(cuts, detectorVolume, &mergedVertexes);
+    }
+
+    /* Daughter tracks of the primary vertexes upstream of secondary ones, which pass impact parameter cut to the secondary vertex,
+    are linked to it as parent tracks. Primary vertex must be within decay length and not close by to the secondary one.
+     */
+    template <class Cuts>
+    void linkParentTracks(const Cuts &cuts, DetectorVolume &detectorVolume, const VertexIndexes &secondaryVertexes)
+    {
+        const SearchConfig &config = cuts.config();
+        const float halfDecayLength = config.decayLengthZ / 2;
+
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (secondaryVertexes.count(vertex->getIndex()) == 0)
+                continue;
 
-            for (auto moreTrack : moreNeighborTracks)
+            float searchZ = std::max(vertex->getZ() - halfDecayLength, (float)detectorVolume.getWindowZBegin());
+            for (auto primary : detectorVolume.getVertexesAround(vertex->getX(), vertex->getY(), searchZ, config.vertexToTrackXYDist, halfDecayLength, true, false))
             {
-                if (moreTrack->isExcluded())
+                if (secondaryVertexes.count(primary->getIndex()) != 0 || primary->getParentTracksCount() != 0)
                     continue;
-                if (moreTrack->getZ() < vertex.getZ())
+                if (primary->getZ() >= vertex->getZ() || vertex->getZ() - primary->getZ() > config.decayLengthZ)
+                    continue;
+                if (checkIfVerticesAreClose(cuts, *primary, *vertex))
                     continue;
 
-                if (CalculationAndAlgorithms::calculateImpactParameter(vertex, moreTrack) < IMPACT_PARAMETER)
+                for (u_int t = 0; t < primary->getDaughterTracksCount(); t++)
                 {
-                    moreTrack->setAsExcluded();
-                    vertex.addDaughterTrack(moreTrack);
+                    auto parentTrack = primary->getDaughterTrack(t);
+                    if (parentTrack->getZ() > vertex->getZ())
+                        continue;
+                    if (CalculationAndAlgorithms::calculateImpactParameter(*vertex, parentTrack) < config.impactParameter)
+                        vertex->addParentTrack(parentTrack);
                 }
             }
-
-            vertex.addDaughterTrack(track);
-            vertex.addDaughterTrack(neighborTrack);
-
-            detectorVolume.addNewUnindexedVertex(vertex);
         }
     }
 
-    struct VertexStruct
+    /* Free tracks within decay length downstream of the primary vertexes, of all of them or only of the selected ones, are added to
+    the secondary search seed tracks.
+     */
+    template <class Cuts>
+    void addTracksDownstreamOfPrimaryVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, const VertexIndexes *selection,
+                                              std::vector<Track *> &seedTracks, std::unordered_set<Track *> &seedTracksSet)
     {
-        u_long index;
-        float X, Y, Z;
-    };
+        const SearchConfig &config = cuts.config();
+        const float halfDecayLength = config.decayLengthZ / 2;
+        float maxSearchZ = detectorVolume.getWindowZEnd() - 1;
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            if (vertex->getParentTracksCount() != 0) // secondary vertex of the previous search
+                continue;
+            if (selection != nullptr && selection->count(vertex->getIndex()) == 0)
+                continue;
 
-    std::vector<VertexStruct> vertexesToDelete;
-    std::vector<Vertex> vertexesToAdd;
+            float searchZ = std::min(vertex->getZ() + halfDecayLength, maxSearchZ);
+            for (auto track : detectorVolume.getTracksAround(vertex->getX(), vertex->getY(), searchZ, config.vertexToTrackXYDist, halfDecayLength, true, false))
+            {
+                if (track->getZ() > vertex->getZ() && seedTracksSet.insert(track).second)
+                    seedTracks.push_back(track);
+            }
+        }
+    }
 
-    for (auto vertex : detectorVolume.getAllVertexes())
+    /* Free tracks of the given ones which lie within decay length downstream of any primary vertex are added to the secondary
+    search seed tracks.
+     */
+    template <class Cuts>
+    void addTracksDownstreamOfAnyPrimaryVertex(const Cuts &cuts, DetectorVolume &detectorVolume, const std::vector<Track *> &tracks,
+                                               std::vector<Track *> &seedTracks, std::unordered_set<Track *> &seedTracksSet)
     {
-        if (vertex->getDaughterTracksCount() <= 2)
-            continue;
-        Double_t error = 0;
-        auto optVertex = recalculateVertexPosition(detectorVolume, *vertex, error, MINUIT_ITERATIONS);
-        if (optVertex.has_value())
+        const SearchConfig &config = cuts.config();
+        const float halfDecayLength = config.decayLengthZ / 2;
+        for (auto track : tracks)
         {
-            auto newVertex = optVertex.value();
-            newVertex.copyTracksArrays(*vertex);
-            newVertex.setIndex(vertex->getIndex());
+            if (track->isExcluded() || seedTracksSet.count(track) != 0)
+                continue;
 
-            vertexesToDelete.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
-            vertexesToAdd.push_back(newVertex);
+            float searchZ = std::max(track->getZ() - halfDecayLength, (float)detectorVolume.getWindowZBegin());
+            for (auto vertex : detectorVolume.getVertexesAround(track->getX(), track->getY(), searchZ, config.vertexToTrackXYDist, halfDecayLength, true, false))
+            {
+                if (vertex->getParentTracksCount() == 0 && vertex->getZ() < track->getZ())
+                {
+                    seedTracksSet.insert(track);
+                    seedTracks.push_back(track);
+                    break;
+                }
+            }
         }
     }
 
-    for (auto vertex : vertexesToDelete)
+    /* Secondary (decay) vertexes search on the same detector volume after the primary one. Free seed tracks downstream of primary vertexes
+    within decay length are paired by the same kernels, found vertexes are fitted and get more tracks. Vertexes which got parent tracks
+    from the upstream primary ones and pass secondary daughter tracks count cut are kept. Returns count of the tested track pairs.
+     */
+    template <class Cuts>
+    u_long searchSecondaryVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, const std::vector<Track *> &seedTracks, size_t pairCacheMaxTracks)
     {
-        detectorVolume.deleteVertex(vertex.index, vertex.X, vertex.Y, vertex.Z);
+        const SearchConfig &config = cuts.config();
+        SearchStatistics stats;
+        PairResultCache pairCache(pairCacheMaxTracks);
+        VertexIndexes secondaryVertexes;
+
+        printf("Secondary vertexes search with %lu free tracks downstream of primary vertexes. \n", seedTracks.size());
+
+        searchTrackPairs(cuts, detectorVolume, seedTracks, pairCache, stats, secondaryVertexes);
+        fitVertexes(cuts, detectorVolume, &secondaryVertexes);
+        attachMoreTracks(cuts, detectorVolume, &secondaryVertexes, pairCache, stats);
+        stats.print(pairCache);
+        pairCache.clear();
+
+        linkParentTracks(cuts, detectorVolume, secondaryVertexes);
+        stats.smallVertexesDeleted = deleteVertexesIf(detectorVolume, &secondaryVertexes, [&config](Vertex &vertex)
+                         { return vertex.getParentTracksCount() == 0 || vertex.getDaughterTracksCount() < config.secondaryDaughtersCountCut; });
+
+        u_long secondaryVertexesCount = 0;
+        for (auto vertex : detectorVolume.getAllVertexes())
+        {
+            secondaryVertexesCount += secondaryVertexes.count(vertex->getIndex());
+        }
+        printf("Found %lu secondary vertexes with parent tracks and daughter tracks count >= %i . \n", secondaryVertexesCount, config.secondaryDaughtersCountCut);
+        stats.addToMetrics("secondarySearch", secondaryVertexesCount);
+        return stats.testedPairs;
     }
-    for (auto vertex : vertexesToAdd)
+
+    /* Secondary search seeded by the free tracks downstream of all the primary vertexes. */
+    template <class Cuts>
+    u_long searchSecondaryVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, size_t pairCacheMaxTracks)
     {
-        detectorVolume.addNewUnindexedVertex(vertex);
+        std::vector<Track *> seedTracks;
+        std::unordered_set<Track *> seedTracksSet;
+        addTracksDownstreamOfPrimaryVertexes(cuts, detectorVolume, nullptr, seedTracks, seedTracksSet);
+        return searchSecondaryVertexes(cuts, detectorVolume, seedTracks, pairCacheMaxTracks);
     }
-    vertexesToAdd.clear();
-    vertexesToDelete.clear();
 
-    for (auto vertex : detectorVolume.getAllVertexes())
+    /* Search kernel, instantiated for every compile-time configuration and for the runtime one. Returns count of the tested track pairs.
+     */
+    template <class Cuts>
+    u_long searchVertexes(const Cuts &cuts, DetectorVolume &detectorVolume, size_t pairCacheMaxTracks)
     {
-        auto moreNeighborTracks = detectorVolume.getTracksAround(vertex->getX(), vertex->getY(), vertex->getZ(), VERTEX_TO_TRACK_XY_DIST, VERTEX_TO_TRACK_Z_DIST, true, false);
+        SearchStatistics stats;
+        PairResultCache pairCache(pairCacheMaxTracks);
+        VertexIndexes newVertexes;
+
+        searchTrackPairs(cuts, detectorVolume, detectorVolume.getAllTracks(), pairCache, stats, newVertexes);
+        fitVertexes(cuts, detectorVolume, nullptr);
+        attachMoreTracks(cuts, detectorVolume, nullptr, pairCache, stats);
+        stats.print(pairCache);
+        pairCache.clear();
 
-        for (auto moreTrack : moreNeighborTracks)
+        stats.smallVertexesDeleted = deleteSmallVertexes(cuts, detectorVolume, nullptr);
+        stats.addToMetrics("search", detectorVolume.getAllVertexes().size());
+
+        u_long testedPairs = stats.testedPairs;
+        if (cuts.config().searchSecondaryVertexes)
         {
-            if (moreTrack->isExcluded())
-                continue;
+            testedPairs += searchSecondaryVertexes(cuts, detectorVolume, pairCacheMaxTracks);
+        }
+        detectorVolume.clearDirtyCells();
+        return testedPairs;
+    }
 
-            if (CalculationAndAlgorithms::calculateImpactParameter(*vertex, moreTrack) < IMPACT_PARAMETER)
-            {
-                moreTrack->setAsExcluded();
-                vertex->addDaughterTrack(moreTrack);
-            }
+    /* Incremental search kernel. Works only with tracks of the detector cells changed since the last search and with vertexes
+    those tracks join, other vertexes stay as they are. If secondary search is set, it is seeded by the free tracks downstream of the
+    new and changed primary vertexes and by the free changed cells tracks downstream of any primary vertex. Returns count of the
+    tested track pairs.
+     */
+    template <class Cuts>
+    u_long searchVertexesIncremental(const Cuts &cuts, DetectorVolume &detectorVolume, size_t pairCacheMaxTracks)
+    {
+        SearchStatistics stats;
+        PairResultCache pairCache(pairCacheMaxTracks);
+        VertexIndexes newVertexes;
+        VertexIndexes changedVertexes;
+
+        auto seedTracks = detectorVolume.getTracksFromDirtyCells();
+        printf("Incremental search in %u changed cells with %lu tracks. \n", detectorVolume.getDirtyCellsCount(), seedTracks.size());
+
+        attachTracksToFoundVertexes(cuts, detectorVolume, seedTracks, stats, changedVertexes);
+        searchTrackPairs(cuts, detectorVolume, seedTracks, pairCache, stats, newVertexes);
+        changedVertexes.insert(newVertexes.begin(), newVertexes.end());
+
+        fitVertexes(cuts, detectorVolume, &changedVertexes);
+        attachMoreTracks(cuts, detectorVolume, &changedVertexes, pairCache, stats);
+        mergeNewVertexes(cuts, detectorVolume, newVertexes, stats, changedVertexes);
+        stats.print(pairCache);
+        printf("Tracks joined vertexes found before=%li new vertexes merged with found before=%li\n", stats.tracksJoinedFoundVertexes, stats.vertexesMerged);
+        pairCache.clear();
+
+        stats.smallVertexesDeleted = deleteSmallVertexes(cuts, detectorVolume, &newVertexes);
+        stats.addToMetrics("incrementalSearch", detectorVolume.getAllVertexes().size());
+
+        u_long testedPairs = stats.testedPairs;
+        if (cuts.config().searchSecondaryVertexes)
+        {
+            // deleted vertexes indexes left in changedVertexes match no vertex
+            std::vector<Track *> secondarySeedTracks;
+            std::unordered_set<Track *> secondarySeedTracksSet;
+            addTracksDownstreamOfPrimaryVertexes(cuts, detectorVolume, &changedVertexes, secondarySeedTracks, secondarySeedTracksSet);
+            addTracksDownstreamOfAnyPrimaryVertex(cuts, detectorVolume, seedTracks, secondarySeedTracks, secondarySeedTracksSet);
+            testedPairs += searchSecondaryVertexes(cuts, detectorVolume, secondarySeedTracks, pairCacheMaxTracks);
         }
+        detectorVolume.clearDirtyCells();
+        return testedPairs;
     }
-    printf("noVertexCount=%li vertexDuplicates=%li vertexAlongFromTracks=%li vertexOutOfBounds=%li trackEqlsNeighbor=%li excludedTrackTouched=%li\n",
-           noVertexCount, vertexDuplicate, vertexAlongFromTracks, vertexOutOfBounds, trackEqlsNeighbor, excludedTrackTouched);
 
-    for (auto vertex : detectorVolume.getAllVertexes())
+    /* Run the function with the search kernel cuts policy chosen by configuration.
+     */
+    template <class Function>
+    void dispatchByConfig(const SearchConfig &config, Function function)
     {
-        if (vertex->getDaughterTracksCount() < DAUGHTERS_COUNT_CUT)
+        // Dispatch to the kernel with folded cuts if configuration is one of the compile-time ones.
+        if (config == StandardCuts::config())
         {
-            vertexesToDelete.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
+            function(StandardCuts());
+        }
+        else if (config == SecondaryCuts::config())
+        {
+            function(SecondaryCuts());
+        }
+        else
+        {
+            function(RuntimeCuts(config));
         }
     }
-    for (auto vertex : vertexesToDelete)
+
+    /* Run the search function with the kernel chosen by configuration and report the kernel. */
+    template <class Function>
+    void runSearchKernel(const SearchConfig &config, Function function)
     {
-        detectorVolume.deleteVertex(vertex.index, vertex.X, vertex.Y, vertex.Z);
+        dispatchByConfig(config, [&function](const auto &cuts)
+                         {
+            printf("Using %s search kernel. \n", cuts.name());
+            function(cuts); });
     }
-    vertexesToDelete.clear();
-    printf("Deleted vertexes with daughter tracks count < %i . \n", DAUGHTERS_COUNT_CUT);
 }
 
-VertexSearcher::VertexSearcher()
+std::optional<Vertex> VertexSearcher::calculateVertexCoordinates(Track &t1, Track &t2)
+{
+    return ::calculateVertexCoordinates(RuntimeCuts(config), t1, t2);
+}
+
+void VertexSearcher::searchVertexes(DetectorVolume &detectorVolume)
+{
+    runSearchKernel(config, [this, &detectorVolume](const auto &cuts)
+                    { testedPairsCount = ::searchVertexes(cuts, detectorVolume, pairCacheMaxTracks); });
+}
+
+void VertexSearcher::searchVertexesIncremental(DetectorVolume &detectorVolume)
 {
-    minuit = std::make_unique<TMinuit>(3);
-    minuit->SetFCN(FCN);
-    minuit->SetPrintLevel(-1);
-}
\ No newline at end of file
+    runSearchKernel(config, [this, &detectorVolume](const auto &cuts)
+                    { testedPairsCount = ::searchVertexesIncremental(cuts, detectorVolume, pairCacheMaxTracks); });
+}
+
+void VertexSearcher::searchSecondaryVertexes(DetectorVolume &detectorVolume)
+{
+    runSearchKernel(config, [this, &detectorVolume](const auto &cuts)
+                    { testedPairsCount = ::searchSecondaryVertexes(cuts, detectorVolume, pairCacheMaxTracks); });
+}
+
+const char *VertexSearcher::getSearchKernelName() const
+{
+    const char *kernelName = nullptr;
+    dispatchByConfig(config, [&kernelName](const auto &cuts)
+                     { kernelName = cuts.name(); });
+    return kernelName;
+}
+
+void VertexSearcher::setConfig(const SearchConfig &config)
+{
+    this->config = config;
+}
+
+void VertexSearcher::setPairCacheMaxTracks(size_t maxTracksCount)
+{
+    pairCacheMaxTracks = maxTracksCount;
+}
+
+VertexSearcher::VertexSearcher(const SearchConfig &config) : config(config), pairCacheMaxTracks(PAIR_CACHE_MAX_TRACKS)
+{
+}
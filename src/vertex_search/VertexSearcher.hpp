@@ -2,18 +2,40 @@
 
 #include "../data_types/Track.hpp"
 #include "../detector/DetectorVolume.hpp"
+#include "SearchConfig.hpp"
 
 #include <optional>
 
 class VertexSearcher
 {
+private:
+    SearchConfig config;
+    size_t pairCacheMaxTracks;
+    u_long testedPairsCount = 0;
+
 public:
     /** @brief Searching vertexes. All Tracks are compared with each other if distance between tracks is less than "NEIGHBOR_TRACK_DISTANCE"
      *  and angle less than "iteration_cuts", algorithm will calculate interaction vertexes for both tracks, add to the vertex
      *  pointers on its tracks, search for additional tracks around vertex coordinates. Save vertexes in detector volume object.
+     *  If configuration is one of the compile-time ones (SearchKernels.hpp), kernel with its cuts folded is used, otherwise the
+     *  generic runtime one.
      */
     void searchVertexes(DetectorVolume &detectorVolume);
 
+    /** @brief Update vertexes after tracks were added to detector volume which was searched before. Only tracks from the cells changed
+     *  since the last search are paired, they may also join vertexes found before. New vertexes are fitted, get more tracks and merged with
+     *  close vertexes found before. All the other vertexes stay as they are. If searchSecondaryVertexes is set in configuration, decay
+     *  vertexes are searched downstream of the new and changed vertexes and among the new free tracks.
+     */
+    void searchVertexesIncremental(DetectorVolume &detectorVolume);
+
+    /** @brief Search decay vertexes downstream of the vertexes found before, on the same detector volume and tracks exclusion state.
+     *  Free tracks within decayLengthZ downstream of a primary vertex are paired, found vertexes get more tracks, and daughter tracks of
+     *  the upstream primary vertexes passing impact parameter cut are linked to them as parent tracks. Vertexes without parent tracks
+     *  are deleted. searchVertexes and searchVertexesIncremental run this stage themselves if searchSecondaryVertexes is set in configuration.
+     */
+    void searchSecondaryVertexes(DetectorVolume &detectorVolume);
+
     /** @brief Determine vertex position as the middle of the common perpendicular to the two given tracks lines
      * @param t1 first track
      * @param t2 second track
@@ -21,7 +43,23 @@ public:
      */
     std::optional<Vertex> calculateVertexCoordinates( Track &t1,  Track &t2);
 
-    VertexSearcher();
+    /** @brief Set search cuts used by the next searches. */
+    void setConfig(const SearchConfig &config);
+
+    const SearchConfig &getConfig() const { return config; }
+
+    /** @brief Memory limit of the cache of tracks and impact parameters found around new vertexes by the first association pass,
+     *  in stored tracks. Vertexes above the limit are searched again by the later passes, 0 disables the cache.
+     */
+    void setPairCacheMaxTracks(size_t maxTracksCount);
+
+    /** @brief Name of the search kernel the current configuration runs with, compile-time or runtime one. */
+    const char *getSearchKernelName() const;
+
+    /** @brief Count of track pairs whose vertex position was calculated by the last search. */
+    u_long getTestedPairsCount() const { return testedPairsCount; }
+
+    VertexSearcher(const SearchConfig &config = SearchConfig());
 
     virtual ~VertexSearcher()
     {
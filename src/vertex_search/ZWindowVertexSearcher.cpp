@@ -0,0 +1,127 @@
+#include "ZWindowVertexSearcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    const u_int STREAM_CHUNK_Z_DEPTH = 500; // microns, tracks of this depth are searched at once
+
+    /* Chunks are aligned to cells layers, so new chunk tracks never share dirty cells with searched tracks. */
+    u_int calculateChunkDepth(u_int cellDimension)
+    {
+        u_int layers = std::max<u_int>(1, STREAM_CHUNK_Z_DEPTH / cellDimension);
+        return layers * cellDimension;
+    }
+
+    struct FinalVertex
+    {
+        u_long index;
+        float X, Y, Z;
+    };
+
+    /* Primary vertexes are kept until decay vertexes downstream of them could not be found anymore, their daughter tracks are the
+    parent tracks of the decay vertexes. */
+    float calculateSecondarySearchDelay(const SearchConfig &config)
+    {
+        return config.searchSecondaryVertexes ? config.decayLengthZ : 0;
+    }
+}
+
+u_int ZWindowVertexSearcher::calculateWindowDepth(const SearchConfig &config, u_int cellDimension)
+{
+    // Vertexes deeper than vertexToTrackZDist + vertexCloseByZ from the searched tracks are final,
+    // daughter tracks of not final vertexes could be vertexToTrackZDist deeper than the vertex.
+    // With secondary search vertexes are final decay length later. One cell for the released layers alignment and one for the
+    // exclusive window end.
+    auto tail = (u_int)std::ceil(2 * config.vertexToTrackZDist + config.vertexCloseByZ + calculateSecondarySearchDelay(config));
+    return tail + calculateChunkDepth(cellDimension) + 2 * cellDimension;
+}
+
+void ZWindowVertexSearcher::addTracks(std::vector<Track> &&zSortedTracks)
+{
+    for (auto &track : zSortedTracks)
+    {
+        if (track.getZ() < lastTrackZ || track.getZ() < chunkZEnd - chunkDepth)
+        {
+            throw std::invalid_argument("ERROR - streamed tracks must be sorted by Z.");
+        }
+        lastTrackZ = track.getZ();
+
+        while (track.getZ() >= chunkZEnd)
+        {
+            searchChunk();
+        }
+        pendingTracks.push_back(std::move(track));
+    }
+}
+
+void ZWindowVertexSearcher::finish()
+{
+    if (!pendingTracks.empty())
+    {
+        detectorVolume.addTracks(std::move(pendingTracks));
+        pendingTracks.clear();
+        vertexSearcher.searchVertexesIncremental(detectorVolume);
+    }
+    emitVertexesBelowZ(detectorVolume.getVolumeDimension() + 1);
+    detectorVolume.releaseCellsBelowZ(detectorVolume.getVolumeDimension());
+}
+
+void ZWindowVertexSearcher::searchChunk()
+{
+    if (!pendingTracks.empty())
+    {
+        detectorVolume.addTracks(std::move(pendingTracks));
+        pendingTracks.clear();
+        vertexSearcher.searchVertexesIncremental(detectorVolume);
+    }
+
+    auto &config = vertexSearcher.getConfig();
+    float finalZ = chunkZEnd - config.vertexToTrackZDist - config.vertexCloseByZ - calculateSecondarySearchDelay(config);
+    emitVertexesBelowZ(finalZ);
+    detectorVolume.releaseCellsBelowZ(finalZ - config.vertexToTrackZDist);
+
+    chunkZEnd += chunkDepth;
+}
+
+void ZWindowVertexSearcher::emitVertexesBelowZ(float z)
+{
+    std::vector<Vertex *> finalVertexes;
+    for (auto vertex : detectorVolume.getAllVertexes())
+    {
+        if (vertex->getZ() < z)
+            finalVertexes.push_back(vertex);
+    }
+    if (finalVertexes.empty())
+        return;
+
+    emitVertexes(finalVertexes);
+    emittedVertexesCount += finalVertexes.size();
+
+    // Deleting shifts vertexes in the cell, so pointers are not used after the first deletion.
+    std::vector<FinalVertex> vertexesToDelete;
+    vertexesToDelete.reserve(finalVertexes.size());
+    for (auto vertex : finalVertexes)
+    {
+        vertexesToDelete.push_back({vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ()});
+    }
+    for (auto &vertex : vertexesToDelete)
+    {
+        detectorVolume.deleteVertex(vertex.index, vertex.X, vertex.Y, vertex.Z);
+    }
+}
+
+ZWindowVertexSearcher::ZWindowVertexSearcher(DetectorVolume &detectorVolume, VertexSearcher &vertexSearcher, VertexesCallback emitVertexes)
+    : detectorVolume(detectorVolume), vertexSearcher(vertexSearcher), emitVertexes(std::move(emitVertexes))
+{
+    auto cellDimension = detectorVolume.getCellDimension();
+    auto windowDepth = detectorVolume.getWindowZEnd() - detectorVolume.getWindowZBegin();
+    if (windowDepth < detectorVolume.getVolumeDimension() && windowDepth < calculateWindowDepth(vertexSearcher.getConfig(), cellDimension))
+    {
+        throw std::invalid_argument("ERROR arguments: detector volume window is less than needed for the search configuration.");
+    }
+    chunkDepth = calculateChunkDepth(cellDimension);
+    chunkZEnd = detectorVolume.getWindowZBegin() + chunkDepth;
+}
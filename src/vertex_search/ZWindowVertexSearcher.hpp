@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../data_types/Track.hpp"
+#include "../data_types/Vertex.hpp"
+#include "../detector/DetectorVolume.hpp"
+#include "VertexSearcher.hpp"
+
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Streaming vertex search for bricks which do not fit in memory.
+ * Tracks sorted by Z are added in chunks to a detector volume created with Z window (see calculateWindowDepth).
+ * After each chunk vertexes are searched incrementally, vertexes which can not get more tracks or be merged anymore are emitted
+ * and the cells behind them are released, so memory depends on the window depth, not on the brick depth.
+ */
+class ZWindowVertexSearcher
+{
+public:
+    /** @brief Called with finalized vertexes. Vertexes and their tracks pointers are valid only during the call. */
+    using VertexesCallback = std::function<void(std::vector<Vertex *> &vertexes)>;
+
+private:
+    DetectorVolume &detectorVolume;
+    VertexSearcher &vertexSearcher;
+    VertexesCallback emitVertexes;
+
+    u_int chunkDepth;            // Z depth of tracks chunk searched at once, multiple of cell dimension
+    float chunkZEnd;             // tracks below are added to detector volume or pending
+    float lastTrackZ = 0;        // to check tracks order
+    std::vector<Track> pendingTracks; // tracks of the not completed chunk
+    u_long emittedVertexesCount = 0;
+
+    void searchChunk();
+    void emitVertexesBelowZ(float z);
+
+public:
+    /** @brief Window depth needed for the search configuration. Vertexes are final when they are deeper than vertex to track
+     * and merging distances from the searched tracks, their daughter tracks may lie one more vertex to track distance behind.
+     * With secondary search vertexes are final one more decay length behind, so decay vertexes still find their primary ones.
+     */
+    static u_int calculateWindowDepth(const SearchConfig &config, u_int cellDimension);
+
+    /** @brief Add next tracks sorted by Z. Every completed chunk of tracks is searched and final vertexes are emitted.
+     * @throws std::invalid_argument if tracks are not sorted by Z or go below already searched Z.
+     */
+    void addTracks(std::vector<Track> &&zSortedTracks);
+
+    /** @brief Search the rest of tracks and emit all the vertexes left. */
+    void finish();
+
+    u_long getEmittedVertexesCount() const { return emittedVertexesCount; }
+
+public:
+    /** @param detectorVolume empty volume with Z window not less than calculateWindowDepth.
+     * @param vertexSearcher searcher with configuration used for the window depth.
+     */
+    ZWindowVertexSearcher(DetectorVolume &detectorVolume, VertexSearcher &vertexSearcher, VertexesCallback emitVertexes);
+
+    virtual ~ZWindowVertexSearcher() {}
+
+    ZWindowVertexSearcher(const ZWindowVertexSearcher &) = delete;
+    ZWindowVertexSearcher &operator=(const ZWindowVertexSearcher &) = delete;
+};
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/downloaders/FedraDownloader.hpp"
+#include "../src/downloaders/NativeTrackFile.hpp"
+#include "../src/downloaders/NativeVertexFile.hpp"
+#include "../src/main/AppLogic.hpp"
+#include "../src/utility/SyntheticBrick.hpp"
+
+namespace
+{
+    /* Vertexes records count of the text vertexes file. */
+    size_t countTextVertexes(const std::string &fileName)
+    {
+        std::ifstream file(fileName);
+        size_t count = 0;
+        for (std::string line; std::getline(file, line);)
+        {
+            if (line.compare(0, 7, "1ry_vtx") == 0 || line.compare(0, 7, "2ry_vtx") == 0)
+                count++;
+        }
+        return count;
+    }
+
+    bool fileExists(const std::string &fileName)
+    {
+        return std::ifstream(fileName).good();
+    }
+}
+
+TEST(BatchProcessingTest, WritesVertexesOfEveryBrickAndCountsFailedOnes)
+{
+    const std::vector<std::string> tracksFileNames = {"batch_processing_test_brick1.trk", "batch_processing_test_missing.trk",
+                                                      "batch_processing_test_brick2.trk"};
+    for (uint32_t seed : {1, 2})
+    {
+        SyntheticBrickConfig brickConfig;
+        brickConfig.seed = seed;
+        brickConfig.tracksCount = 10000;
+        writeNativeTrackFile(tracksFileNames[seed == 1 ? 0 : 2], generateSyntheticBrick(brickConfig).tracks);
+    }
+
+    const u_int WORKERS_COUNT = 2;
+    std::atomic<u_int> downloadersCount{0};
+    std::atomic<u_int> maxThreadsCount{0};
+    AppLogic app(std::make_unique<FedraDownloader>());
+    auto failedCount = app.findVertexesBatch(tracksFileNames, WORKERS_COUNT, [&](u_int threadsCount)
+                                             {
+                                                 downloadersCount++;
+                                                 maxThreadsCount = std::max<u_int>(maxThreadsCount, threadsCount);
+                                                 return std::make_unique<FedraDownloader>(threadsCount); });
+    EXPECT_EQ(failedCount, 1);
+    EXPECT_EQ(downloadersCount, WORKERS_COUNT);
+
+    // workers share the cores for formatting vertexes files
+    EXPECT_GE(maxThreadsCount, 1);
+    EXPECT_LE(maxThreadsCount, std::max(1u, std::thread::hardware_concurrency() / WORKERS_COUNT));
+
+    // every brick has its own vertexes files, failed brick has none
+    for (auto brickName : {"batch_processing_test_brick1", "batch_processing_test_brick2"})
+    {
+        auto textFileName = std::string(brickName) + "_vertexes.txt";
+        auto nativeFileName = std::string(brickName) + "_vertexes.vtx";
+        {
+            MappedVertexFile vertexFile(nativeFileName);
+            EXPECT_GT(vertexFile.size(), 0);
+            EXPECT_EQ(countTextVertexes(textFileName), vertexFile.size());
+        }
+        std::remove(textFileName.c_str());
+        std::remove(nativeFileName.c_str());
+    }
+    EXPECT_FALSE(fileExists("batch_processing_test_missing_vertexes.txt"));
+    EXPECT_FALSE(fileExists("batch_processing_test_missing_vertexes.vtx"));
+    std::remove(tracksFileNames[0].c_str());
+    std::remove(tracksFileNames[2].c_str());
+}
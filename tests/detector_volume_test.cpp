@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <vector>
+
+#include "../src/data_types/Track.hpp"
+#include "../src/data_types/Vertex.hpp"
+#include "../src/detector/DetectorVolume.hpp"
+
+namespace
+{
+    struct TrackState
+    {
+        ULong_t index;
+        float X, Y, Z;
+        bool excluded;
+        int segmentsCount;
+    };
+
+    struct VertexState
+    {
+        ULong_t index;
+        float X, Y, Z;
+        std::vector<ULong_t> daughters;
+    };
+
+    std::vector<TrackState> getTracksState(DetectorVolume &volume)
+    {
+        std::vector<TrackState> state;
+        for (auto track : volume.getAllTracks())
+            state.push_back(TrackState{track->getIndex(), track->getX(), track->getY(), track->getZ(), track->isExcluded(), track->getSegmentsCount()});
+        return state;
+    }
+
+    std::vector<VertexState> getVertexesState(DetectorVolume &volume)
+    {
+        std::vector<VertexState> state;
+        for (auto vertex : volume.getAllVertexes())
+        {
+            state.push_back(VertexState{vertex->getIndex(), vertex->getX(), vertex->getY(), vertex->getZ(), {}});
+            for (u_int t = 0; t < vertex->getDaughterTracksCount(); t++)
+                state.back().daughters.push_back(vertex->getDaughterTrack(t)->getIndex());
+        }
+        return state;
+    }
+}
+
+TEST(DetectorVolumeTest, SnapshotRestoresCells)
+{
+    const std::string SNAPSHOT_FILE_NAME = "detector_volume_snapshot_test.dvs";
+
+    auto volume = std::make_unique<DetectorVolume>(2000, 100);
+    std::vector<Track> tracks;
+    for (u_long t = 0; t < 300; t++)
+    {
+        Track track(t, (float)(t * 37 % 1900) - 950, (float)(t * 53 % 1900) - 950, (float)(t * 71 % 1999), 0.01f * (t % 7), -0.01f * (t % 5));
+        track.addPlaceholderSegments(t % 3);
+        tracks.push_back(track);
+    }
+    volume->addTracks(std::move(tracks));
+
+    auto volumeTracks = volume->getAllTracks();
+    for (size_t v = 0; v < 10; v++)
+    {
+        Vertex vertex(volumeTracks[v * 3]->getX(), volumeTracks[v * 3]->getY(), volumeTracks[v * 3]->getZ());
+        for (size_t t = v * 3; t < v * 3 + 3; t++)
+        {
+            vertex.addDaughterTrack(volumeTracks[t]);
+            volumeTracks[t]->setAsExcluded();
+        }
+        volume->addNewUnindexedVertex(vertex);
+    }
+    volume->clearDirtyCells();
+    std::vector<Track> newTracks = {Track(1000, 10, 20, 30, 0, 0)};
+    volume->addTracks(std::move(newTracks));
+
+    auto tracksBefore = getTracksState(*volume);
+    auto vertexesBefore = getVertexesState(*volume);
+    auto dirtyCellsCount = volume->getDirtyCellsCount();
+    volume->writeSnapshot(SNAPSHOT_FILE_NAME);
+    volume.reset();
+
+    auto restored = DetectorVolume::restoreSnapshot(SNAPSHOT_FILE_NAME);
+    std::remove(SNAPSHOT_FILE_NAME.c_str());
+
+    EXPECT_EQ(restored->getTracksCount(), 301);
+    EXPECT_EQ(restored->getVertexesCount(), 10);
+    EXPECT_EQ(restored->getDirtyCellsCount(), dirtyCellsCount);
+    EXPECT_EQ(restored->getTracksFromDirtyCells().size(), 1);
+
+    auto tracksAfter = getTracksState(*restored);
+    ASSERT_EQ(tracksAfter.size(), tracksBefore.size());
+    for (size_t t = 0; t < tracksBefore.size(); t++)
+    {
+        EXPECT_EQ(tracksAfter[t].index, tracksBefore[t].index);
+        EXPECT_EQ(tracksAfter[t].X, tracksBefore[t].X);
+        EXPECT_EQ(tracksAfter[t].Y, tracksBefore[t].Y);
+        EXPECT_EQ(tracksAfter[t].Z, tracksBefore[t].Z);
+        EXPECT_EQ(tracksAfter[t].excluded, tracksBefore[t].excluded);
+        EXPECT_EQ(tracksAfter[t].segmentsCount, tracksBefore[t].segmentsCount);
+    }
+
+    // segments are not stored, they are recreated as the tracks files loader creates them
+    for (auto track : restored->getAllTracks())
+    {
+        for (int s = 0; s < track->getSegmentsCount(); s++)
+        {
+            EXPECT_EQ(track->getSegment(s).getTrackId(), track->getIndex());
+            EXPECT_EQ(track->getSegment(s).getX(), 111);
+            EXPECT_EQ(track->getSegment(s).getTanY(), 222);
+        }
+    }
+
+    auto vertexesAfter = getVertexesState(*restored);
+    ASSERT_EQ(vertexesAfter.size(), vertexesBefore.size());
+    for (size_t v = 0; v < vertexesBefore.size(); v++)
+    {
+        EXPECT_EQ(vertexesAfter[v].index, vertexesBefore[v].index);
+        EXPECT_EQ(vertexesAfter[v].Z, vertexesBefore[v].Z);
+        EXPECT_EQ(vertexesAfter[v].daughters, vertexesBefore[v].daughters);
+    }
+
+    // the next vertex continues unique indexes
+    Vertex vertex(0, 0, 500);
+    restored->addNewUnindexedVertex(vertex);
+    EXPECT_EQ(vertex.getIndex(), 10);
+}
+
+TEST(DetectorVolumeTest, SnapshotRejectsOtherFiles)
+{
+    EXPECT_THROW(DetectorVolume::restoreSnapshot("not_existing_snapshot.dvs"), std::runtime_error);
+}
+
+TEST(DetectorVolumeTest, IndexStatisticsCountQueries)
+{
+    DetectorVolume volume(2000, 100);
+    std::vector<Track> tracks = {Track(0, -950, -950, 50, 0, 0), Track(1, -945, -955, 55, 0, 0), Track(2, -920, -950, 50, 0, 0),
+                                 Track(3, 500, 500, 1500, 0, 0)};
+    volume.addTracks(std::move(tracks));
+    EXPECT_EQ(volume.getIndexStatistics(), nullptr);
+
+    volume.setIndexStatisticsEnabled(true);
+    auto around = volume.getTracksAround(-950, -950, 50, 10, 10); // inside one cell, the third track of the cell is too far
+    EXPECT_EQ(around.size(), 2);
+    volume.getVertexesAround(0, 0, 1000, 150, 150);
+
+    auto statistics = volume.getIndexStatistics();
+    ASSERT_NE(statistics, nullptr);
+    EXPECT_EQ(statistics->trackQueries.queries, 1);
+    EXPECT_EQ(statistics->trackQueries.cellsVisited, 1);
+    EXPECT_EQ(statistics->trackQueries.candidates, 3);
+    EXPECT_EQ(statistics->trackQueries.accepted, 2);
+    EXPECT_EQ(statistics->trackQueries.acceptedPerQuery.buckets[2], 1); // 2 is in [2, 3]
+    EXPECT_EQ(statistics->vertexQueries.queries, 1);
+    EXPECT_GT(statistics->vertexQueries.cellsVisited, 1);
+    EXPECT_EQ(statistics->vertexQueries.candidates, 0);
+    EXPECT_EQ(statistics->vertexQueries.candidatesPerQuery.buckets[0], 1);
+
+    volume.setIndexStatisticsEnabled(true); // reset
+    EXPECT_EQ(volume.getIndexStatistics()->trackQueries.queries, 0);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/utility/Metrics.hpp"
+
+namespace
+{
+    const Metric *findMetric(const std::vector<Metric> &metrics, const std::string &scope, const std::string &name)
+    {
+        for (auto &metric : metrics)
+        {
+            if (metric.scope == scope && metric.name == name)
+                return &metric;
+        }
+        return nullptr;
+    }
+
+    std::string readFile(const std::string &fileName)
+    {
+        std::ifstream file(fileName);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+}
+
+TEST(MetricsTest, ThreadsAreMergedByScopeAndName)
+{
+    auto &metrics = getMetrics();
+    metrics.reset();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 4; w++)
+    {
+        workers.emplace_back([w]()
+                             {
+            MetricsScope scope(w % 2 == 0 ? "even.trk" : "odd.trk");
+            for (int i = 0; i < 100; i++)
+                getMetrics().addCount("search.testedPairs", 2);
+            getMetrics().addTime("search", 10 + w); });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    metrics.addCount("search.testedPairs", 1); // this thread is alive and has the default scope
+
+    auto collected = metrics.collect();
+    ASSERT_EQ(collected.size(), 5u);
+
+    auto evenPairs = findMetric(collected, "even.trk", "search.testedPairs");
+    ASSERT_NE(evenPairs, nullptr);
+    EXPECT_EQ(evenPairs->kind, MetricKind::Counter);
+    EXPECT_EQ(evenPairs->calls, 200u);
+    EXPECT_EQ(evenPairs->total, 400);
+
+    auto oddSearch = findMetric(collected, "odd.trk", "search");
+    ASSERT_NE(oddSearch, nullptr);
+    EXPECT_EQ(oddSearch->kind, MetricKind::Timer);
+    EXPECT_EQ(oddSearch->calls, 2u);
+    EXPECT_EQ(oddSearch->total, 11 + 13);
+    EXPECT_EQ(oddSearch->min, 11);
+    EXPECT_EQ(oddSearch->max, 13);
+
+    auto defaultPairs = findMetric(collected, "", "search.testedPairs");
+    ASSERT_NE(defaultPairs, nullptr);
+    EXPECT_EQ(defaultPairs->total, 1);
+
+    metrics.reset();
+    EXPECT_TRUE(metrics.collect().empty());
+}
+
+TEST(MetricsTest, WriteJsonAndCsv)
+{
+    auto &metrics = getMetrics();
+    metrics.reset();
+    {
+        MetricsScope scope("brick \"1\",a.trk");
+        metrics.addTime("load", 1.5);
+        metrics.addCount("prefilter.input", 1000);
+    }
+
+    const std::string jsonFileName = "metrics_test.json", csvFileName = "metrics_test.csv";
+    ASSERT_TRUE(metrics.write(jsonFileName));
+    ASSERT_TRUE(metrics.write(csvFileName));
+
+    auto json = readFile(jsonFileName);
+    EXPECT_NE(json.find("\"scope\": \"brick \\\"1\\\",a.trk\""), std::string::npos);
+    EXPECT_NE(json.find("\"load\": {\"calls\": 1, \"totalMs\": 1.500, \"minMs\": 1.500, \"maxMs\": 1.500}"), std::string::npos);
+    EXPECT_NE(json.find("\"prefilter.input\": 1000"), std::string::npos);
+
+    auto csv = readFile(csvFileName);
+    EXPECT_EQ(csv, "scope,kind,name,calls,total,min,max\n"
+                   "\"brick \"\"1\"\",a.trk\",timer,load,1,1.500,1.500,1.500\n"
+                   "\"brick \"\"1\"\",a.trk\",counter,prefilter.input,1,1000.000,1000.000,1000.000\n");
+
+    std::remove(jsonFileName.c_str());
+    std::remove(csvFileName.c_str());
+    metrics.reset();
+}
+
+TEST(MetricsTest, GaugesKeepTheLastValuePerScope)
+{
+    auto &metrics = getMetrics();
+    metrics.reset();
+    std::thread brick([]()
+                      {
+        MetricsScope scope("a.trk");
+        getMetrics().setGauge("index.cellSize", 500); });
+    brick.join();
+    metrics.setGauge("index.cellSize", 1000); // the volume reported by every search of the default scope
+    metrics.setGauge("index.cellSize", 1000);
+    metrics.setGauge("index.emptyCells", 30);
+    metrics.setGauge("index.emptyCells", 20);
+
+    auto collected = metrics.collect();
+    auto brickCellSize = findMetric(collected, "a.trk", "index.cellSize");
+    ASSERT_NE(brickCellSize, nullptr);
+    EXPECT_EQ(brickCellSize->kind, MetricKind::Gauge);
+    EXPECT_EQ(brickCellSize->total, 500);
+
+    auto cellSize = findMetric(collected, "", "index.cellSize");
+    ASSERT_NE(cellSize, nullptr);
+    EXPECT_EQ(cellSize->calls, 2u);
+    EXPECT_EQ(cellSize->total, 1000);
+
+    auto emptyCells = findMetric(collected, "", "index.emptyCells");
+    ASSERT_NE(emptyCells, nullptr);
+    EXPECT_EQ(emptyCells->total, 20);
+    EXPECT_EQ(emptyCells->min, 20);
+    EXPECT_EQ(emptyCells->max, 30);
+
+    const std::string jsonFileName = "metrics_test_gauges.json", csvFileName = "metrics_test_gauges.csv";
+    ASSERT_TRUE(metrics.write(jsonFileName));
+    ASSERT_TRUE(metrics.write(csvFileName));
+    EXPECT_NE(readFile(jsonFileName).find("\"gauges\": {\n      \"index.cellSize\": 1000"), std::string::npos);
+    EXPECT_NE(readFile(csvFileName).find(",gauge,index.emptyCells,2,20.000,20.000,30.000\n"), std::string::npos);
+
+    std::remove(jsonFileName.c_str());
+    std::remove(csvFileName.c_str());
+    metrics.reset();
+}
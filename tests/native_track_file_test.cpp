@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../src/downloaders/FedraDownloader.hpp"
+#include "../src/downloaders/NativeTrackFile.hpp"
+#include "../src/vertex_search/TrackPrefilter.hpp"
+
+namespace
+{
+    const u_int VOLUME_DIMENSION = 20000;
+    const u_int CELL_DIMENSION = 1000;
+
+    TrackColumns createColumns(size_t count)
+    {
+        std::mt19937 engine(3);
+        std::uniform_real_distribution<float> position(-9999, 9999), depth(0, 19999), slope(-0.3, 0.3);
+        TrackColumns columns;
+        for (size_t t = 0; t < count; t++)
+        {
+            columns.X.push_back(position(engine));
+            columns.Y.push_back(position(engine));
+            columns.Z.push_back(depth(engine));
+            columns.tanX.push_back(slope(engine));
+            columns.tanY.push_back(slope(engine));
+        }
+        return columns;
+    }
+
+    /* Linear cell index of the detector volume, for tracks inside the volume. */
+    uint32_t getLinearCellIndex(float x, float y, float z)
+    {
+        const u_int CELLS_IN_DIMENSION = VOLUME_DIMENSION / CELL_DIMENSION;
+        auto cell = [](float coordinate)
+        { return (u_int)std::floor(coordinate / CELL_DIMENSION); };
+        return (cell(z) * CELLS_IN_DIMENSION + cell(y + VOLUME_DIMENSION / 2)) * CELLS_IN_DIMENSION + cell(x + VOLUME_DIMENSION / 2);
+    }
+
+    /* Every track of the file is the source track of its index. */
+    void expectSourceTracks(const MappedTrackFile &file, const TrackColumns &source)
+    {
+        ASSERT_EQ(file.size(), source.size());
+        std::vector<bool> seen(source.size());
+        for (size_t t = 0; t < file.size(); t++)
+        {
+            auto index = file.getIndex()[t];
+            ASSERT_LT(index, source.size());
+            EXPECT_FALSE(seen[index]);
+            seen[index] = true;
+            EXPECT_EQ(file.getX()[t], source.X[index]);
+            EXPECT_EQ(file.getY()[t], source.Y[index]);
+            EXPECT_EQ(file.getZ()[t], source.Z[index]);
+            EXPECT_EQ(file.getTanX()[t], source.tanX[index]);
+            EXPECT_EQ(file.getTanY()[t], source.tanY[index]);
+        }
+    }
+}
+
+TEST(NativeTrackFileTest, WriteAndReadEveryOrder)
+{
+    const std::string fileName = "native_track_file_test.trk";
+    auto source = createColumns(5000);
+
+    writeNativeTrackFile(fileName, source);
+    {
+        MappedTrackFile file(fileName);
+        EXPECT_EQ(file.getOrder(), TrackFileOrder::Unsorted);
+        EXPECT_EQ(file.getCell(), nullptr);
+        EXPECT_EQ(file.getCellRows(), nullptr);
+        expectSourceTracks(file, source);
+        EXPECT_EQ(file.getIndex()[10], 10);
+
+        // read ahead hints are clamped to the tracks and do not change the columns
+        file.prefetchTracks(0, file.size() + 100, true);
+        file.prefetchTracks(file.size(), file.size() + 1, false);
+        file.prefetchTracks(10, 5, false);
+        expectSourceTracks(file, source);
+        EXPECT_EQ(file.getHeader().minZ, *std::min_element(source.Z.begin(), source.Z.end()));
+        EXPECT_EQ(file.getHeader().maxX, *std::max_element(source.X.begin(), source.X.end()));
+
+        TrackColumns copied;
+        file.copyColumns(copied);
+        EXPECT_EQ(copied.X, source.X);
+        EXPECT_EQ(copied.tanY, source.tanY);
+        EXPECT_TRUE(copied.index.empty()); // track index is its number
+    }
+
+    writeNativeTrackFile(fileName, source, TrackFileOrder::ByZ);
+    {
+        MappedTrackFile file(fileName);
+        EXPECT_EQ(file.getOrder(), TrackFileOrder::ByZ);
+        expectSourceTracks(file, source);
+        EXPECT_TRUE(std::is_sorted(file.getZ(), file.getZ() + file.size()));
+
+        TrackColumns copied;
+        file.copyColumns(copied);
+        ASSERT_EQ(copied.index.size(), source.size());
+        EXPECT_EQ(copied.getIndex(7), file.getIndex()[7]);
+    }
+
+    writeNativeTrackFile(fileName, source, TrackFileOrder::ByCell, CELL_DIMENSION, VOLUME_DIMENSION);
+    {
+        MappedTrackFile file(fileName);
+        EXPECT_EQ(file.getOrder(), TrackFileOrder::ByCell);
+        EXPECT_EQ(file.getHeader().cellDimension, CELL_DIMENSION);
+        expectSourceTracks(file, source);
+        ASSERT_NE(file.getCell(), nullptr);
+        ASSERT_NE(file.getCellRows(), nullptr);
+        EXPECT_TRUE(std::is_sorted(file.getCell(), file.getCell() + file.size()));
+        for (size_t t = 0; t < file.size(); t++)
+        {
+            ASSERT_EQ(file.getCell()[t], getLinearCellIndex(file.getX()[t], file.getY()[t], file.getZ()[t]));
+        }
+    }
+
+    EXPECT_THROW(writeNativeTrackFile(fileName, source, TrackFileOrder::ByCell, 300, VOLUME_DIMENSION), std::invalid_argument);
+    std::remove(fileName.c_str());
+}
+
+TEST(NativeTrackFileTest, RejectsDamagedFiles)
+{
+    const std::string fileName = "native_track_file_test_damaged.trk";
+    auto source = createColumns(1000);
+
+    EXPECT_THROW(MappedTrackFile("native_track_file_test_missing.trk"), std::runtime_error);
+
+    writeNativeTrackFile(fileName, source, TrackFileOrder::ByCell, CELL_DIMENSION, VOLUME_DIMENSION);
+    auto fileSize = std::filesystem::file_size(fileName);
+    std::filesystem::resize_file(fileName, fileSize - 64); // cell rows index is cut
+    EXPECT_THROW(MappedTrackFile file(fileName), std::invalid_argument);
+    std::filesystem::resize_file(fileName, fileSize / 2);
+    EXPECT_THROW(MappedTrackFile file(fileName), std::invalid_argument);
+    std::filesystem::resize_file(fileName, 100); // shorter than header
+    EXPECT_THROW(MappedTrackFile file(fileName), std::invalid_argument);
+
+    writeNativeTrackFile(fileName, source);
+    {
+        std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+        file.write("DSTAUVTX", 8); // magic of the vertex file
+    }
+    EXPECT_THROW(MappedTrackFile file(fileName), std::invalid_argument);
+
+    writeNativeTrackFile(fileName, source);
+    {
+        std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(TrackFileHeader, version));
+        uint32_t version = TRACK_FILE_VERSION + 1;
+        file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    }
+    EXPECT_THROW(MappedTrackFile file(fileName), std::invalid_argument);
+    std::remove(fileName.c_str());
+}
+
+TEST(NativeTrackFileTest, RegionOfCellSortedFileIsExact)
+{
+    const std::string fileName = "native_track_file_test_region.trk";
+    auto source = createColumns(5000);
+    for (size_t t = 0; t < source.size(); t++)
+    {
+        // Z layers [5000, 8000) and rows of Y above 6000 are empty
+        if (source.Z[t] >= 5000 && source.Z[t] < 8000)
+            source.Z[t] -= 3000;
+        if (source.Y[t] > 6000)
+            source.Y[t] -= 6000;
+    }
+    // tracks on the volume borders and outside of the volume belong to the border cells
+    const float borderTracks[][3] = {{-10000, 0, 100}, {10000, 10000, 0}, {9999.99, -10000, 19999.99}, {10500, 2000, 3000}, {0, -10700, 20400}};
+    for (auto &track : borderTracks)
+    {
+        source.X.push_back(track[0]);
+        source.Y.push_back(track[1]);
+        source.Z.push_back(track[2]);
+        source.tanX.push_back(0.1);
+        source.tanY.push_back(0.1);
+    }
+    writeNativeTrackFile(fileName, source, TrackFileOrder::ByCell, CELL_DIMENSION, VOLUME_DIMENSION);
+
+    const float boxes[][6] = {{-10000, 10000, -10000, 10000, 0, 20000}, // whole volume
+                              {-15000, 15000, -15000, 15000, -500, 25000}, // beyond the volume borders
+                              {-2000, 3000, -1000, 1000, 4000, 9000},   // through empty layers
+                              {-3000, 3000, 6500, 10000, 0, 20000},     // only empty rows
+                              {9000, 10000, -10000, -9000, 19000, 20000}, // volume corner
+                              {-1000, 1000, -2000, 2000, 1000, 9000},   // borders on cells borders
+                              {2000, 1000, 0, 1000, 0, 1000}};          // empty box
+    FedraDownloader downloader;
+    for (auto &box : boxes)
+    {
+        std::vector<u_long> expected, found;
+        for (size_t t = 0; t < source.size(); t++)
+        {
+            if (source.X[t] >= box[0] && source.X[t] <= box[1] && source.Y[t] >= box[2] && source.Y[t] <= box[3] && source.Z[t] >= box[4] &&
+                source.Z[t] <= box[5])
+                expected.push_back(t);
+        }
+        for (auto &track : downloader.downloadTracksFromFileInRegion(fileName, box[0], box[1], box[2], box[3], box[4], box[5]))
+        {
+            found.push_back(track.getIndex());
+        }
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected) << "box X [" << box[0] << ", " << box[1] << "] Y [" << box[2] << ", " << box[3] << "] Z [" << box[4]
+                                   << ", " << box[5] << "]";
+    }
+
+    MappedTrackFile file(fileName);
+    auto ranges = file.findRegionRanges(-10000, 10000, -10000, 10000, 0, 20000);
+    ASSERT_EQ(ranges.size(), 1); // rows of the whole volume width are merged
+    EXPECT_EQ(ranges[0].first, 0);
+    EXPECT_EQ(ranges[0].second, file.size());
+    EXPECT_TRUE(file.findRegionRanges(-3000, 3000, 6500, 10000, 0, 20000).empty());
+
+    for (auto &range : file.findRegionRanges(-2000, 3000, -1000, 1000, 4000, 9000))
+    {
+        file.prefetchTracks(range.first, range.second, false);
+    }
+    expectSourceTracks(file, source);
+    std::remove(fileName.c_str());
+}
+
+TEST(NativeTrackFileTest, ChunksArePrefilteredBeforeTracksAreCreated)
+{
+    const std::string fileName = "native_track_file_test_chunks.trk";
+    const float SLOPE_CUT = 0.1;
+    const u_long CHUNK_SIZE = 700;
+    auto source = createColumns(5000);
+    writeNativeTrackFile(fileName, source, TrackFileOrder::ByCell, CELL_DIMENSION, VOLUME_DIMENSION);
+    auto isRejected = [&](u_long index)
+    { return source.tanX[index] * source.tanX[index] + source.tanY[index] * source.tanY[index] < SLOPE_CUT * SLOPE_CUT; };
+
+    FedraDownloader downloader;
+    for (bool sortedByZ : {false, true})
+    {
+        for (bool createRejected : {false, true})
+        {
+            TrackPrefilter prefilter;
+            prefilter.addSlopeCut(std::atan(SLOPE_CUT));
+            auto partition = [&prefilter](TrackColumns &chunkColumns)
+            { return prefilter.partition(chunkColumns); };
+
+            std::vector<bool> seen(source.size());
+            u_long passedTotal = 0, tracksTotal = 0;
+            float lastZ = -1;
+            auto sink = [&](std::vector<Track> &&chunk, size_t passedCount)
+            {
+                ASSERT_LE(passedCount, chunk.size());
+                if (!createRejected)
+                    ASSERT_EQ(chunk.size(), passedCount);
+                for (size_t t = 0; t < chunk.size(); t++)
+                {
+                    auto index = chunk[t].getIndex();
+                    ASSERT_LT(index, source.size());
+                    EXPECT_FALSE(seen[index]);
+                    seen[index] = true;
+                    EXPECT_EQ(isRejected(index), t >= passedCount);
+                    EXPECT_EQ(chunk[t].getX(), source.X[index]);
+                    EXPECT_EQ(chunk[t].getZ(), source.Z[index]);
+                    EXPECT_EQ(chunk[t].getTanY(), source.tanY[index]);
+                    if (sortedByZ && t < passedCount)
+                    {
+                        EXPECT_GE(chunk[t].getZ(), lastZ);
+                        lastZ = chunk[t].getZ();
+                    }
+                }
+                passedTotal += passedCount;
+                tracksTotal += chunk.size();
+            };
+            if (sortedByZ)
+                downloader.downloadTracksFromFileSortedByZ(fileName, CHUNK_SIZE, sink, partition, createRejected);
+            else
+                downloader.downloadTracksFromFileInChunks(fileName, CHUNK_SIZE, sink, partition, createRejected);
+
+            u_long expectedPassed = 0;
+            for (size_t t = 0; t < source.size(); t++)
+            {
+                expectedPassed += !isRejected(t);
+            }
+            EXPECT_GT(expectedPassed, 0);
+            EXPECT_LT(expectedPassed, source.size());
+            EXPECT_EQ(passedTotal, expectedPassed);
+            EXPECT_EQ(tracksTotal, createRejected ? source.size() : expectedPassed);
+            EXPECT_EQ(prefilter.getRejectedCount(0), source.size() - expectedPassed);
+        }
+    }
+    std::remove(fileName.c_str());
+}
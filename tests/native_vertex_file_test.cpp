@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/data_types/Track.hpp"
+#include "../src/data_types/Vertex.hpp"
+#include "../src/downloaders/NativeVertexFile.hpp"
+
+namespace
+{
+    /* Vertexes with 0 to 6 daughter tracks, every fifth vertex is a decay vertex with a parent track. */
+    struct VertexesSet
+    {
+        std::vector<Track> tracks;
+        std::vector<Vertex> vertexes;
+
+        VertexesSet(size_t count)
+        {
+            tracks.reserve(count * 7);
+            vertexes.reserve(count);
+            for (size_t v = 0; v < count; v++)
+            {
+                vertexes.emplace_back(v * 0.5f - 1000, 2000 - v * 0.25f, v * 1.5f);
+                vertexes.back().setIndex(v * 3 + 1);
+                for (size_t d = 0; d < v % 7; d++)
+                {
+                    tracks.emplace_back(tracks.size() * 11 + 2, v, v, v, 0.1, 0.1);
+                    vertexes.back().addDaughterTrack(&tracks.back());
+                }
+                if (v % 5 == 0)
+                {
+                    tracks.emplace_back(tracks.size() * 11 + 2, v, v, v - 500.0f, 0.1, 0.1);
+                    vertexes.back().addParentTrack(&tracks.back());
+                }
+            }
+        }
+
+        std::vector<Vertex *> getPointers(size_t begin, size_t end)
+        {
+            std::vector<Vertex *> pointers;
+            for (size_t v = begin; v < end; v++)
+            {
+                pointers.push_back(&vertexes[v]);
+            }
+            return pointers;
+        }
+    };
+
+    void expectVertexFile(const std::string &fileName, VertexesSet &expected)
+    {
+        MappedVertexFile file(fileName);
+        ASSERT_EQ(file.size(), expected.vertexes.size());
+        for (size_t v = 0; v < file.size(); v++)
+        {
+            auto &vertex = expected.vertexes[v];
+            EXPECT_EQ(file.getIndex()[v], vertex.getIndex());
+            EXPECT_EQ(file.getX()[v], vertex.getX());
+            EXPECT_EQ(file.getY()[v], vertex.getY());
+            EXPECT_EQ(file.getZ()[v], vertex.getZ());
+            ASSERT_EQ(file.getDaughtersCount(v), vertex.getDaughterTracksCount());
+            for (u_int t = 0; t < vertex.getDaughterTracksCount(); t++)
+            {
+                EXPECT_EQ(file.getDaughters(v)[t], vertex.getDaughterTrack(t)->getIndex());
+            }
+            ASSERT_EQ(file.getParentsCount(v), vertex.getParentTracksCount());
+            for (u_int t = 0; t < vertex.getParentTracksCount(); t++)
+            {
+                EXPECT_EQ(file.getParents(v)[t], vertex.getParentTrack(t)->getIndex());
+            }
+        }
+    }
+
+    std::string readFile(const std::string &fileName)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string &fileName, const std::string &content)
+    {
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    VertexFileHeader *getHeader(std::string &content)
+    {
+        return reinterpret_cast<VertexFileHeader *>(&content[0]);
+    }
+}
+
+TEST(NativeVertexFileTest, WritesSeveralAppendsAndMapsThem)
+{
+    const std::string fileName = "native_vertex_file_test.vtx";
+    VertexesSet expected(1000);
+    const size_t callEnds[] = {1, 300, 300, 777, 1000};
+    {
+        NativeVertexFileWriter writer(fileName);
+        size_t begin = 0;
+        for (auto end : callEnds)
+        {
+            auto vertexes = expected.getPointers(begin, end);
+            writer.writeVertexes(vertexes); // empty call too
+            begin = end;
+        }
+        EXPECT_TRUE(writer.close());
+        EXPECT_TRUE(writer.close());
+    }
+    expectVertexFile(fileName, expected);
+
+    // file without vertexes has empty columns
+    VertexesSet noVertexes(0);
+    {
+        NativeVertexFileWriter writer(fileName);
+        auto vertexes = noVertexes.getPointers(0, 0);
+        writer.writeVertexes(vertexes);
+    }
+    expectVertexFile(fileName, noVertexes);
+    std::remove(fileName.c_str());
+}
+
+TEST(NativeVertexFileTest, RejectsTruncatedAndCorruptFiles)
+{
+    const std::string fileName = "native_vertex_file_test_corrupt.vtx";
+    VertexesSet vertexesSet(100);
+    {
+        NativeVertexFileWriter writer(fileName);
+        auto vertexes = vertexesSet.getPointers(0, vertexesSet.vertexes.size());
+        writer.writeVertexes(vertexes);
+    }
+    auto content = readFile(fileName);
+    ASSERT_GT(getHeader(content)->parentsCount, 0);
+
+    auto expectRejected = [&](const std::string &corrupted)
+    {
+        writeFile(fileName, corrupted);
+        EXPECT_THROW(MappedVertexFile file(fileName), std::invalid_argument);
+    };
+
+    expectRejected(content.substr(0, sizeof(VertexFileHeader) - 1)); // truncated header
+    expectRejected(content.substr(0, content.size() - sizeof(uint64_t))); // truncated parents column
+
+    auto corrupted = content;
+    corrupted[0] = 'X';
+    expectRejected(corrupted);
+
+    corrupted = content;
+    getHeader(corrupted)->version = VERTEX_FILE_VERSION + 1;
+    expectRejected(corrupted);
+
+    corrupted = content;
+    getHeader(corrupted)->columnOffsets[2] += 4; // misaligned column
+    expectRejected(corrupted);
+
+    corrupted = content;
+    getHeader(corrupted)->vertexesCount *= 1000; // columns beyond the file end
+    expectRejected(corrupted);
+
+    corrupted = content;
+    getHeader(corrupted)->daughtersCount -= 1; // tracks lists beyond the daughters column
+    expectRejected(corrupted);
+
+    corrupted = content;
+    auto daughtersBegin = reinterpret_cast<uint64_t *>(&corrupted[getHeader(corrupted)->columnOffsets[4]]);
+    std::swap(daughtersBegin[10], daughtersBegin[11]); // not sorted tracks lists
+    expectRejected(corrupted);
+
+    writeFile(fileName, content);
+    EXPECT_NO_THROW(MappedVertexFile file(fileName));
+    std::remove(fileName.c_str());
+    EXPECT_THROW(MappedVertexFile file(fileName), std::runtime_error);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "../src/vertex_search/SearchConfig.hpp"
+#include "../src/vertex_search/SearchKernels.hpp"
+
+namespace
+{
+    void writeFile(const std::string &fileName, const std::string &content)
+    {
+        std::ofstream file(fileName);
+        file << content;
+    }
+}
+
+TEST(SearchConfigTest, LoadsParametersFromFile)
+{
+    const std::string fileName = "search_config_test.cfg";
+    writeFile(fileName, "# comment line\n"
+                        "\n"
+                        "impactParameter = 20   # microns\n"
+                        "  daughtersCountCut=3\r\n"
+                        "cutDirectTracks = false\n"
+                        "searchSecondaryVertexes = 1\n"
+                        "decayLengthZ = 4000.5\n");
+    auto config = SearchConfig::loadFromFile(fileName);
+    std::remove(fileName.c_str());
+
+    EXPECT_EQ(config.impactParameter, 20);
+    EXPECT_EQ(config.daughtersCountCut, 3);
+    EXPECT_FALSE(config.cutDirectTracks);
+    EXPECT_TRUE(config.searchSecondaryVertexes);
+    EXPECT_EQ(config.decayLengthZ, 4000.5);
+
+    // parameters absent in the file keep the standard values
+    SearchConfig expected;
+    expected.impactParameter = 20;
+    expected.daughtersCountCut = 3;
+    expected.cutDirectTracks = false;
+    expected.searchSecondaryVertexes = true;
+    expected.decayLengthZ = 4000.5;
+    EXPECT_EQ(config, expected);
+}
+
+TEST(SearchConfigTest, StandardConfigFileIsStandardConfig)
+{
+    EXPECT_EQ(SearchConfig::loadFromFile(SEARCH_CONFIG_FILE), STANDARD_SEARCH_CONFIG);
+}
+
+TEST(SearchConfigTest, RejectsWrongParameters)
+{
+    SearchConfig config;
+    EXPECT_THROW(config.setParameter("impactParam", "15"), std::invalid_argument);
+    EXPECT_THROW(config.setParameter("impactParameter", "far"), std::invalid_argument);
+    EXPECT_THROW(config.setParameter("daughtersCountCut", ""), std::invalid_argument);
+    EXPECT_THROW(config.setParameter("cutDirectTracks", "yes"), std::invalid_argument);
+    EXPECT_THROW(config.setParameter("searchSecondaryVertexes", "True"), std::invalid_argument);
+    EXPECT_THROW(config.setParameter("searchSecondaryVertexes", "2"), std::invalid_argument);
+    EXPECT_EQ(config, SearchConfig());
+
+    config.setParameter("cutDirectTracks", "0");
+    EXPECT_FALSE(config.cutDirectTracks);
+    config.setParameter("cutDirectTracks", "true");
+    EXPECT_TRUE(config.cutDirectTracks);
+
+    const std::string fileName = "search_config_test_wrong.cfg";
+    writeFile(fileName, "impactParameter 15\n");
+    EXPECT_THROW(SearchConfig::loadFromFile(fileName), std::invalid_argument);
+    writeFile(fileName, "searchSecondaryVertexes = on\n");
+    EXPECT_THROW(SearchConfig::loadFromFile(fileName), std::invalid_argument);
+    std::remove(fileName.c_str());
+    EXPECT_THROW(SearchConfig::loadFromFile(fileName), std::invalid_argument);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/utility/SyntheticBrick.hpp"
+
+namespace
+{
+    void expectSameBricks(const SyntheticBrick &brick1, const SyntheticBrick &brick2)
+    {
+        EXPECT_EQ(brick1.tracks.X, brick2.tracks.X);
+        EXPECT_EQ(brick1.tracks.Y, brick2.tracks.Y);
+        EXPECT_EQ(brick1.tracks.Z, brick2.tracks.Z);
+        EXPECT_EQ(brick1.tracks.tanX, brick2.tracks.tanX);
+        EXPECT_EQ(brick1.tracks.tanY, brick2.tracks.tanY);
+        ASSERT_EQ(brick1.truthVertexes.size(), brick2.truthVertexes.size());
+        for (size_t v = 0; v < brick1.truthVertexes.size(); v++)
+        {
+            EXPECT_EQ(brick1.truthVertexes[v].X, brick2.truthVertexes[v].X);
+            EXPECT_EQ(brick1.truthVertexes[v].Y, brick2.truthVertexes[v].Y);
+            EXPECT_EQ(brick1.truthVertexes[v].Z, brick2.truthVertexes[v].Z);
+            EXPECT_EQ(brick1.truthVertexes[v].daughters, brick2.truthVertexes[v].daughters);
+        }
+    }
+
+    /* Every track is a daughter of one vertex at most, vertexes have at least 2 daughters. */
+    void expectConsistentVertexes(const SyntheticBrick &brick, const SyntheticBrickConfig &config)
+    {
+        std::vector<bool> isDaughter(brick.tracks.size());
+        for (auto &vertex : brick.truthVertexes)
+        {
+            EXPECT_GE(vertex.daughters.size(), 2);
+            EXPECT_LE(vertex.daughters.size(), config.maxDaughters);
+            for (auto daughter : vertex.daughters)
+            {
+                ASSERT_LT(daughter, brick.tracks.size());
+                EXPECT_FALSE(isDaughter[daughter]);
+                isDaughter[daughter] = true;
+                EXPECT_GE(brick.tracks.Z[daughter], vertex.Z);
+            }
+        }
+    }
+}
+
+TEST(SyntheticBrickTest, SameSeedGivesSameBrick)
+{
+    SyntheticBrickConfig config;
+    config.seed = 5;
+    config.tracksCount = 20000;
+    auto brick = generateSyntheticBrick(config);
+    expectSameBricks(generateSyntheticBrick(config), brick);
+
+    config.vertexesCount = 300;
+    expectSameBricks(generateSyntheticBrick(config), generateSyntheticBrick(config));
+
+    config.vertexesCount = 0;
+    config.seed = 6;
+    auto otherBrick = generateSyntheticBrick(config);
+    EXPECT_NE(otherBrick.tracks.X, brick.tracks.X);
+}
+
+TEST(SyntheticBrickTest, GeneratesRequestedCounts)
+{
+    SyntheticBrickConfig config;
+    config.seed = 7;
+    config.tracksCount = 12345;
+    auto brick = generateSyntheticBrick(config);
+    EXPECT_EQ(brick.tracks.size(), config.tracksCount);
+    EXPECT_GT(brick.truthVertexes.size(), 0);
+    expectConsistentVertexes(brick, config);
+
+    // small volume loses many daughters through the borders, lost vertexes are replaced
+    for (u_long vertexesCount : {1, 100, 1234})
+    {
+        config.volumeDimension = 5000;
+        config.vertexesCount = vertexesCount;
+        brick = generateSyntheticBrick(config);
+        EXPECT_EQ(brick.tracks.size(), config.tracksCount);
+        EXPECT_EQ(brick.truthVertexes.size(), vertexesCount);
+        expectConsistentVertexes(brick, config);
+    }
+
+    config.setParameter("vertexesCount", "10");
+    EXPECT_EQ(config.vertexesCount, 10);
+    config.vertexesCount = config.tracksCount / config.maxDaughters + 1;
+    EXPECT_THROW(generateSyntheticBrick(config), std::invalid_argument);
+}
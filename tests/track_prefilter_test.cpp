@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/data_types/Track.hpp"
+#include "../src/vertex_search/TrackPrefilter.hpp"
+
+namespace
+{
+    /* Straight tracks cut as AppLogic did it before the prefilter. */
+    bool checkTrackAngleLessThanCut(Track *track, float angleCut)
+    {
+        return atan(sqrt(track->getTanX() * track->getTanX() + track->getTanY() * track->getTanY())) < angleCut;
+    }
+
+    const float ANGLE_CUT = 0.02;
+    const float REGION_BORDER = 5000;
+    const size_t TRACKS_COUNT = 10000; // several prefilter chunks
+
+    /* Tracks with slopes near the cut border and positions on the region border. */
+    std::vector<Track> createTracks()
+    {
+        std::mt19937 engine(7);
+        std::uniform_real_distribution<float> position(-10000, 10000), slope(-0.1, 0.1), unit(-1, 1);
+        std::vector<Track> tracks;
+        for (size_t t = 0; t < TRACKS_COUNT; t++)
+        {
+            float tanX = slope(engine), tanY = slope(engine);
+            if (t % 3 == 0)
+            {
+                // slope within a few float steps of the cut border
+                float direction = unit(engine) * M_PI;
+                float tangent = std::tan(ANGLE_CUT) * (1 + ((int)(t % 101) - 50) * 1e-7f);
+                tanX = tangent * std::cos(direction);
+                tanY = tangent * std::sin(direction);
+            }
+            float X = t % 5 == 0 ? REGION_BORDER : position(engine); // border is included
+            tracks.emplace_back(t, X, position(engine), 1000, tanX, tanY);
+        }
+        return tracks;
+    }
+
+    TrackPrefilter createPrefilter()
+    {
+        TrackPrefilter prefilter;
+        prefilter.addSlopeCut(ANGLE_CUT).addRegionOfInterest(-REGION_BORDER, REGION_BORDER, -REGION_BORDER, REGION_BORDER, 0, 20000);
+        return prefilter;
+    }
+}
+
+TEST(TrackPrefilterTest, PartitionIsStableAndCountsEveryCut)
+{
+    auto tracks = createTracks();
+
+    std::vector<u_long> expectedPassed, expectedRejected;
+    u_long slopeRejected = 0, regionRejected = 0;
+    for (auto &track : tracks)
+    {
+        bool straight = checkTrackAngleLessThanCut(&track, ANGLE_CUT);
+        bool outside = std::abs(track.getX()) > REGION_BORDER || std::abs(track.getY()) > REGION_BORDER;
+        slopeRejected += straight;
+        regionRejected += !straight && outside;
+        (straight || outside ? expectedRejected : expectedPassed).push_back(track.getIndex());
+    }
+
+    auto prefilter = createPrefilter();
+    auto passedCount = prefilter.partition(tracks);
+
+    ASSERT_EQ(tracks.size(), TRACKS_COUNT);
+    ASSERT_EQ(passedCount, expectedPassed.size());
+    EXPECT_EQ(prefilter.getRejectedCount(0), slopeRejected);
+    EXPECT_EQ(prefilter.getRejectedCount(1), regionRejected);
+    for (size_t t = 0; t < passedCount; t++)
+    {
+        ASSERT_EQ(tracks[t].getIndex(), expectedPassed[t]);
+    }
+    for (size_t t = passedCount; t < tracks.size(); t++)
+    {
+        ASSERT_EQ(tracks[t].getIndex(), expectedRejected[t - passedCount]);
+    }
+}
+
+TEST(TrackPrefilterTest, ColumnsPartitionMatchesTracksPartition)
+{
+    auto tracks = createTracks();
+    TrackColumns columns;
+    for (auto &track : tracks)
+    {
+        columns.X.push_back(track.getX());
+        columns.Y.push_back(track.getY());
+        columns.Z.push_back(track.getZ());
+        columns.tanX.push_back(track.getTanX());
+        columns.tanY.push_back(track.getTanY());
+    }
+
+    auto tracksPrefilter = createPrefilter(), columnsPrefilter = createPrefilter();
+    auto passedCount = tracksPrefilter.partition(tracks);
+    ASSERT_EQ(columnsPrefilter.partition(columns), passedCount);
+    EXPECT_EQ(columnsPrefilter.getRejectedCount(0), tracksPrefilter.getRejectedCount(0));
+    EXPECT_EQ(columnsPrefilter.getRejectedCount(1), tracksPrefilter.getRejectedCount(1));
+
+    ASSERT_EQ(columns.size(), tracks.size());
+    ASSERT_EQ(columns.index.size(), tracks.size());
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        ASSERT_EQ(columns.getIndex(t), tracks[t].getIndex());
+        EXPECT_EQ(columns.X[t], tracks[t].getX());
+        EXPECT_EQ(columns.Y[t], tracks[t].getY());
+        EXPECT_EQ(columns.tanX[t], tracks[t].getTanX());
+        EXPECT_EQ(columns.tanY[t], tracks[t].getTanY());
+    }
+}
@@ -37,4 +37,83 @@ TEST(VectorTest, MathematicalAlgorithmsCorrectness)
     float value1m = floor(vectorMagnitudeRegisters * 100) / 100;
     float value2m = floor(std::sqrt(299) * 100) / 100;
     EXPECT_EQ(value1m, value2m);
-}
\ No newline at end of file
+}
+
+TEST(VectorTest, BatchImpactParametersEqualSingle)
+{
+    Vertex vertex(12.5, -40, 3000);
+
+    // 11 tracks: one full batch of 8 and 3 in the scalar tail
+    std::vector<Track> tracks;
+    for (int i = 0; i < 11; i++)
+    {
+        tracks.emplace_back(i, 10.0 + i * 7.3, -35.0 - i * 2.1, 3050.0 + i * 40, 0.01 * i - 0.05, 0.2 - 0.03 * i);
+    }
+    std::vector<Track *> trackPtrs;
+    for (auto &track : tracks)
+    {
+        trackPtrs.push_back(&track);
+    }
+
+    TrackBatch batch;
+    batch.assign(trackPtrs);
+    ASSERT_EQ(batch.size(), tracks.size());
+
+    std::vector<float> impactParameters(batch.size());
+    CalculationAndAlgorithms::calculateImpactParameters(vertex, batch, impactParameters.data());
+
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        EXPECT_EQ(batch.getTrack(i), trackPtrs[i]);
+        EXPECT_EQ(impactParameters[i], (float)CalculationAndAlgorithms::calculateImpactParameter(vertex, trackPtrs[i]));
+    }
+}
+
+TEST(VectorTest, KernelsVariantsEqualScalar)
+{
+    const GeometryKernels &scalar = getScalarGeometryKernels();
+
+    float vertex[3] = {12.5, -40, 3000};
+    float point1[3] = {30.2, -33.7, 3100}, direction1[3] = {0.17, -0.04, 1};
+    float point2[3] = {-5.1, -51.3, 3250}, direction2[3] = {-0.06, -0.08, 1};
+
+    std::vector<Track> tracks;
+    for (int i = 0; i < 37; i++)
+    {
+        tracks.emplace_back(i, 10.0 + i * 7.3, -35.0 - i * 2.1, 3050.0 + i * 40, 0.01 * i - 0.05, 0.2 - 0.03 * i);
+    }
+    TrackBatch batch;
+    for (auto &track : tracks)
+    {
+        batch.add(&track);
+    }
+    std::vector<float> scalarImpactParameters(batch.size()), impactParameters(batch.size());
+    auto columns = CalculationAndAlgorithms::getBatchColumns(batch);
+    scalar.impactParameters(vertex, columns, scalarImpactParameters.data());
+
+    LinesApproach scalarApproach, approach;
+    scalar.linesApproach(point1, direction1, point2, direction2, 1e-4, 100, scalarApproach);
+
+    for (auto kernels : getSupportedGeometryKernels())
+    {
+        float scalarCross[3], cross[3];
+        scalar.crossProduct(direction1, direction2, scalarCross);
+        kernels->crossProduct(direction1, direction2, cross);
+        for (int i = 0; i < 3; i++)
+        {
+            EXPECT_EQ(cross[i], scalarCross[i]) << kernels->name;
+        }
+        EXPECT_EQ(kernels->mixedProduct(point1, direction1, direction2), scalar.mixedProduct(point1, direction1, direction2)) << kernels->name;
+        EXPECT_EQ(kernels->vectorMagnitude(point2), scalar.vectorMagnitude(point2)) << kernels->name;
+        EXPECT_EQ(kernels->impactParameter(vertex, point1, direction1), scalar.impactParameter(vertex, point1, direction1)) << kernels->name;
+
+        kernels->impactParameters(vertex, columns, impactParameters.data());
+        EXPECT_EQ(impactParameters, scalarImpactParameters) << kernels->name;
+
+        kernels->linesApproach(point1, direction1, point2, direction2, 1e-4, 100, approach);
+        EXPECT_EQ(approach.angleSin2, scalarApproach.angleSin2) << kernels->name;
+        EXPECT_EQ(approach.perpendicular, scalarApproach.perpendicular) << kernels->name;
+        EXPECT_EQ(approach.variableS, scalarApproach.variableS) << kernels->name;
+        EXPECT_EQ(approach.variableT, scalarApproach.variableT) << kernels->name;
+    }
+}
@@ -91,4 +91,23 @@ TEST(VertexCoordsTest, CalculateVertexCoordsCorrectness)
         EXPECT_EQ(vertex.getY(), vertexOne.getY());
         EXPECT_EQ(vertex.getZ(), vertexOne.getZ());
     }
-}
\ No newline at end of file
+}
+
+TEST(VertexCoordsTest, NearParallelTracks)
+{
+    // Tracks from vertex (100, -200, 5000) with 3 mrad between them, this pair is calculated in double precision
+    const float X = 100, Y = -200, Z = 5000;
+    Track t1(1, X + 0.1 * 400, Y + 0.05 * 400, Z + 400, 0.1, 0.05);
+    Track t2(2, X + 0.103 * 700, Y + 0.05 * 700, Z + 700, 0.103, 0.05);
+
+    VertexSearcher vs;
+    auto vertexOpt = vs.calculateVertexCoordinates(t1, t2);
+    ASSERT_EQ(vertexOpt.has_value(), true);
+    EXPECT_NEAR(vertexOpt.value().getX(), X, 0.1);
+    EXPECT_NEAR(vertexOpt.value().getY(), Y, 0.1);
+    EXPECT_NEAR(vertexOpt.value().getZ(), Z, 0.1);
+
+    // Parallel tracks have no vertex
+    Track t3(3, X + 5, Y, Z, 0.1, 0.05);
+    EXPECT_EQ(vs.calculateVertexCoordinates(t1, t3).has_value(), false);
+}
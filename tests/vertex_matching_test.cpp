@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "../src/utility/CalculationAndAlgorithms.hpp"
+#include "../src/utility/VertexMatching.hpp"
+
+TEST(VertexMatchingTest, MatchesOneToOneFromClosest)
+{
+    std::vector<VertexPoint> truth = {{0, 0, 1000, 5}, {5000, 5000, 8000, 6}, {-3000, 2000, 4000, 2}, {9000, -9000, 15000, 4},
+                                      {1995, -5, 2990, 5}};
+    std::vector<VertexPoint> reconstructed = {
+        {30, 0, 1100, 5},       // farther from the first truth vertex than the next one, stays unmatched
+        {-10, 0, 1000, 5},      // the closest to the first truth vertex
+        {5010, 5000, 8200, 6},  // second truth vertex
+        {-3000, 2000, 4000, 3}, // truth vertex with less daughters: matched, but not counted in efficiency
+        {0, 0, 12000, 4},       // fake
+        {2005, 5, 3010, 5}};    // higher X, Y and Z cells than its truth vertex
+    // vertexes without daughters far downstream make the truth cells of 1000 microns, so the last pair straddles cells borders
+    for (int v = 0; v < 8000; v++)
+    {
+        truth.push_back(VertexPoint{-9500.0f + v % 80 * 240, -9500.0f + v / 80 * 190, 19000, 0});
+    }
+    ASSERT_EQ(CalculationAndAlgorithms::calculateCellSizeFromTracksCount(VertexMatchingConfig().volumeDimension, truth.size()), 1000);
+
+    auto result = matchVertexes(reconstructed, truth);
+    EXPECT_EQ(result.truthCount, 4);
+    EXPECT_EQ(result.reconstructedCount, 6);
+    EXPECT_EQ(result.matchedTruthCount, 3);
+    EXPECT_EQ(result.matchedReconstructedCount, 4);
+    EXPECT_DOUBLE_EQ(result.getEfficiency(), 3.0 / 4);
+    EXPECT_DOUBLE_EQ(result.getPurity(), 4.0 / 6);
+
+    // residuals X are -10, 10, 0, 10, Y are 0, 0, 0, 10 and Z are 0, 200, 0, 20
+    EXPECT_NEAR(result.biasX, 2.5, 1e-4);
+    EXPECT_NEAR(result.resolutionX, std::sqrt(68.75), 1e-4);
+    EXPECT_NEAR(result.resolutionY, std::sqrt(18.75), 1e-4);
+    EXPECT_NEAR(result.biasZ, 55, 1e-4);
+}
+
+TEST(VertexMatchingTest, EmptyAndWrongConfig)
+{
+    std::vector<VertexPoint> truth = {{0, 0, 1000, 5}};
+    auto result = matchVertexes({}, truth);
+    EXPECT_EQ(result.truthCount, 1);
+    EXPECT_EQ(result.getEfficiency(), 0);
+    EXPECT_EQ(result.getPurity(), 0);
+
+    VertexMatchingConfig config;
+    config.maxZDistance = 0;
+    EXPECT_THROW(matchVertexes(truth, truth, config), std::invalid_argument);
+}
@@ -0,0 +1,511 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../src/data_types/Track.hpp"
+#include "../src/data_types/Vertex.hpp"
+#include "../src/detector/DetectorVolume.hpp"
+#include "../src/downloaders/FedraDownloader.hpp"
+#include "../src/downloaders/NativeTrackFile.hpp"
+#include "../src/utility/SyntheticBrick.hpp"
+#include "../src/vertex_search/VertexSearcher.hpp"
+#include "../src/vertex_search/ZWindowVertexSearcher.hpp"
+
+namespace
+{
+    const u_int VOLUME_DIMENSION = 20000;
+    const u_int CELL_DIMENSION = 500;
+
+    /* Daughter tracks of the vertex starting at startZ, directions are spread around the beam axis. */
+    void addDaughters(std::vector<Track> &tracks, u_long &nextIndex, float X, float Y, float Z, float startZ, u_int firstDaughter, u_int count)
+    {
+        const u_int DIRECTIONS = 8;
+        for (u_int d = firstDaughter; d < firstDaughter + count; d++)
+        {
+            float tanX = 0.2 * std::cos(2 * M_PI * d / DIRECTIONS);
+            float tanY = 0.2 * std::sin(2 * M_PI * d / DIRECTIONS);
+            tracks.emplace_back(nextIndex++, X + tanX * (startZ - Z), Y + tanY * (startZ - Z), startZ, tanX, tanY);
+        }
+    }
+
+    /* Primary vertex with 5 daughters and decay vertex with 3 daughters (too few for the primary search) lying decayLength downstream
+    on the first primary daughter track. Returns the parent track index, decay vertex position is set to secondary.
+     */
+    u_long addPrimaryWithDecayVertex(std::vector<Track> &primaryTracks, std::vector<Track> &decayTracks, u_long &nextIndex, const float primary[3],
+                                     float decayLength, float secondary[3])
+    {
+        addDaughters(primaryTracks, nextIndex, primary[0], primary[1], primary[2], primary[2] + 20, 1, 5);
+        auto &parentTrack = primaryTracks[primaryTracks.size() - 5];
+        secondary[0] = primary[0] + parentTrack.getTanX() * decayLength;
+        secondary[1] = primary[1] + parentTrack.getTanY() * decayLength;
+        secondary[2] = primary[2] + decayLength;
+        u_long parentTrackIndex = parentTrack.getIndex();
+        addDaughters(decayTracks, nextIndex, secondary[0], secondary[1], secondary[2], secondary[2] + 20, 4, 3);
+        return parentTrackIndex;
+    }
+
+    struct FoundVertex
+    {
+        float X, Y, Z;
+        u_int daughtersCount, parentsCount;
+
+        bool operator<(const FoundVertex &other) const { return Z < other.Z; }
+    };
+
+    std::vector<FoundVertex> getFoundVertexes(DetectorVolume &volume)
+    {
+        std::vector<FoundVertex> found;
+        for (auto vertex : volume.getAllVertexes())
+        {
+            found.push_back(FoundVertex{vertex->getX(), vertex->getY(), vertex->getZ(), vertex->getDaughterTracksCount(), vertex->getParentTracksCount()});
+        }
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+
+    /* Primary vertex and decay vertex with the parent track are found. */
+    void expectPrimaryWithDecayVertex(std::vector<FoundVertex> vertexes, const float secondary[3])
+    {
+        ASSERT_EQ(vertexes.size(), 2);
+        std::sort(vertexes.begin(), vertexes.end());
+        EXPECT_EQ(vertexes[0].parentsCount, 0);
+        EXPECT_EQ(vertexes[0].daughtersCount, 5);
+        EXPECT_EQ(vertexes[1].parentsCount, 1);
+        EXPECT_EQ(vertexes[1].daughtersCount, 3);
+        EXPECT_NEAR(vertexes[1].Z, secondary[2], 5);
+    }
+}
+
+TEST(VertexSearchTest, IncrementalSearchFindsVertexesOfFullSearch)
+{
+    // vertexes lie near cells borders, the later daughter track starts in the next Z cell and has to find the vertex in the lower one
+    const float vertexes[][3] = {{-7010, 3000, 990}, {2020, -5990, 3980}, {6000, 6010, 6960}};
+    std::vector<Track> firstBatch, secondBatch;
+    u_long nextIndex = 0;
+    for (auto &vertex : vertexes)
+    {
+        addDaughters(firstBatch, nextIndex, vertex[0], vertex[1], vertex[2], vertex[2] + 20, 0, 4);
+    }
+    for (auto &vertex : vertexes)
+    {
+        addDaughters(secondBatch, nextIndex, vertex[0], vertex[1], vertex[2], vertex[2] + 600, 4, 1);
+    }
+
+    std::vector<FoundVertex> fullSearchVertexes;
+    {
+        DetectorVolume fullVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+        std::vector<Track> allTracks = firstBatch;
+        allTracks.insert(allTracks.end(), secondBatch.begin(), secondBatch.end());
+        fullVolume.addTracks(std::move(allTracks));
+        VertexSearcher().searchVertexes(fullVolume);
+        fullSearchVertexes = getFoundVertexes(fullVolume);
+    }
+
+    DetectorVolume incrementalVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+    VertexSearcher searcher;
+    incrementalVolume.addTracks(std::move(firstBatch));
+    searcher.searchVertexes(incrementalVolume);
+    incrementalVolume.addTracks(std::move(secondBatch));
+    searcher.searchVertexesIncremental(incrementalVolume);
+    auto incrementalVertexes = getFoundVertexes(incrementalVolume);
+
+    ASSERT_EQ(fullSearchVertexes.size(), 3);
+    ASSERT_EQ(incrementalVertexes.size(), fullSearchVertexes.size());
+    for (size_t v = 0; v < fullSearchVertexes.size(); v++)
+    {
+        EXPECT_EQ(fullSearchVertexes[v].daughtersCount, 5);
+        EXPECT_EQ(incrementalVertexes[v].daughtersCount, fullSearchVertexes[v].daughtersCount);
+        EXPECT_NEAR(incrementalVertexes[v].X, vertexes[v][0], 1);
+        EXPECT_NEAR(incrementalVertexes[v].Y, vertexes[v][1], 1);
+        EXPECT_NEAR(incrementalVertexes[v].Z, vertexes[v][2], 5);
+    }
+}
+
+TEST(VertexSearchTest, IncrementalSearchMergesNewVertexIntoClosestFoundOne)
+{
+    // new vertex is close to both vertexes found before, but its tracks start in the next Z cell and miss them by more than the impact
+    // parameter cut
+    const float farVertex[3] = {2250, 2250, 2250}, closeVertex[3] = {2310, 2250, 2250}, newVertex[3] = {2335, 2250, 2600};
+    std::vector<Track> firstBatch, secondBatch;
+    u_long nextIndex = 0;
+    addDaughters(firstBatch, nextIndex, farVertex[0], farVertex[1], farVertex[2], farVertex[2] + 20, 0, 4);
+    addDaughters(firstBatch, nextIndex, closeVertex[0], closeVertex[1], closeVertex[2], closeVertex[2] + 20, 4, 4);
+    addDaughters(secondBatch, nextIndex, newVertex[0], newVertex[1], newVertex[2], newVertex[2] + 20, 1, 5);
+
+    DetectorVolume volume(VOLUME_DIMENSION, CELL_DIMENSION);
+    VertexSearcher searcher;
+    volume.addTracks(std::move(firstBatch));
+    searcher.searchVertexes(volume);
+    ASSERT_EQ(volume.getAllVertexes().size(), 2);
+
+    volume.addTracks(std::move(secondBatch));
+    searcher.searchVertexesIncremental(volume);
+    auto vertexes = getFoundVertexes(volume);
+    ASSERT_EQ(vertexes.size(), 2);
+    std::sort(vertexes.begin(), vertexes.end(), [](const FoundVertex &first, const FoundVertex &second)
+              { return first.X < second.X; });
+    EXPECT_EQ(vertexes[0].daughtersCount, 4);
+    EXPECT_NEAR(vertexes[0].X, farVertex[0], 1);
+    EXPECT_EQ(vertexes[1].daughtersCount, 9);
+    // merged vertex is fitted with the tracks of both
+    EXPECT_GT(vertexes[1].Z, closeVertex[2] + 5);
+}
+
+TEST(VertexSearchTest, TracksMovedByAddedTracksStayAttached)
+{
+    std::vector<Track> firstBatch, secondBatch;
+    u_long nextIndex = 0;
+    addDaughters(firstBatch, nextIndex, 2250, 2250, 2250, 2270, 0, 4);
+    for (u_int t = 0; t < 20; t++) // the cell tracks storage grows and old tracks are moved
+    {
+        secondBatch.emplace_back(nextIndex++, 2050 + 20 * t, 2450, 2300, 0, 0);
+    }
+
+    DetectorVolume volume(VOLUME_DIMENSION, CELL_DIMENSION);
+    VertexSearcher searcher;
+    volume.addTracks(std::move(firstBatch));
+    searcher.searchVertexes(volume);
+    volume.addTracks(std::move(secondBatch));
+
+    auto vertexes = volume.getAllVertexes();
+    ASSERT_EQ(vertexes.size(), 1);
+    ASSERT_EQ(vertexes[0]->getDaughterTracksCount(), 4);
+    for (u_int t = 0; t < 4; t++)
+    {
+        EXPECT_LT(vertexes[0]->getDaughterTrack(t)->getIndex(), 4);
+        EXPECT_TRUE(vertexes[0]->getDaughterTrack(t)->isExcluded());
+    }
+}
+
+TEST(VertexSearchTest, StreamingSearchFindsVertexesOfFullSearch)
+{
+    // daughter tracks of the vertexes start in the next chunks, up to vertex to track distance deeper, and window moves several times
+    // over its depth along the volume
+    const float vertexes[][3] = {{-7010, 3000, 490}, {2020, -5990, 2980}, {6000, 6010, 5510}, {-3000, -3000, 8995},
+                                 {4000, -4000, 12020}, {-5000, 5000, 16490}};
+    const float startZShifts[] = {20, 20, 20, 480, 990};
+    std::vector<Track> tracks;
+    u_long nextIndex = 0;
+    for (auto &vertex : vertexes)
+    {
+        for (u_int d = 0; d < 5; d++)
+        {
+            addDaughters(tracks, nextIndex, vertex[0], vertex[1], vertex[2], vertex[2] + startZShifts[d], d, 1);
+        }
+    }
+    std::sort(tracks.begin(), tracks.end(), [](const Track &first, const Track &second)
+              { return first.getZ() < second.getZ(); });
+
+    VertexSearcher searcher;
+    std::vector<FoundVertex> fullSearchVertexes;
+    {
+        DetectorVolume fullVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+        fullVolume.addTracks(std::vector<Track>(tracks));
+        searcher.searchVertexes(fullVolume);
+        fullSearchVertexes = getFoundVertexes(fullVolume);
+    }
+
+    auto windowDepth = ZWindowVertexSearcher::calculateWindowDepth(searcher.getConfig(), CELL_DIMENSION);
+    ASSERT_LT(windowDepth * 3, VOLUME_DIMENSION);
+    DetectorVolume windowVolume(VOLUME_DIMENSION, CELL_DIMENSION, windowDepth);
+    std::vector<FoundVertex> streamedVertexes;
+    ZWindowVertexSearcher windowSearcher(windowVolume, searcher, [&streamedVertexes](std::vector<Vertex *> &emitted)
+                                         {
+                                             for (auto vertex : emitted)
+                                             {
+                                                 streamedVertexes.push_back(FoundVertex{vertex->getX(), vertex->getY(), vertex->getZ(),
+                                                                                        vertex->getDaughterTracksCount(), vertex->getParentTracksCount()});
+                                             }
+                                         });
+    const size_t CHUNK_TRACKS = 7; // chunks do not match the search slices
+    for (size_t first = 0; first < tracks.size(); first += CHUNK_TRACKS)
+    {
+        auto last = std::min(first + CHUNK_TRACKS, tracks.size());
+        windowSearcher.addTracks(std::vector<Track>(tracks.begin() + first, tracks.begin() + last));
+    }
+    windowSearcher.finish();
+    std::sort(streamedVertexes.begin(), streamedVertexes.end());
+
+    ASSERT_EQ(fullSearchVertexes.size(), 6);
+    EXPECT_EQ(windowSearcher.getEmittedVertexesCount(), fullSearchVertexes.size());
+    ASSERT_EQ(streamedVertexes.size(), fullSearchVertexes.size());
+    for (size_t v = 0; v < fullSearchVertexes.size(); v++)
+    {
+        EXPECT_EQ(fullSearchVertexes[v].daughtersCount, 5);
+        EXPECT_EQ(streamedVertexes[v].daughtersCount, fullSearchVertexes[v].daughtersCount);
+        EXPECT_NEAR(streamedVertexes[v].X, fullSearchVertexes[v].X, 1);
+        EXPECT_NEAR(streamedVertexes[v].Y, fullSearchVertexes[v].Y, 1);
+        EXPECT_NEAR(streamedVertexes[v].Z, fullSearchVertexes[v].Z, 5);
+    }
+}
+
+TEST(VertexSearchTest, SecondaryVertexGetsParentTrackOfPrimary)
+{
+    // decay vertex lies on the first primary daughter track, 3000 microns downstream and in higher X, Y and Z cells than the primary
+    const float primary[3] = {-3010, 2990, 2010};
+    float secondary[3];
+    std::vector<Track> tracks;
+    u_long nextIndex = 0;
+    const u_long parentTrackIndex = addPrimaryWithDecayVertex(tracks, tracks, nextIndex, primary, 3000, secondary);
+
+    SearchConfig config;
+    config.searchSecondaryVertexes = true;
+    VertexSearcher searcher;
+    searcher.setConfig(config);
+    DetectorVolume volume(VOLUME_DIMENSION, CELL_DIMENSION);
+    volume.addTracks(std::move(tracks));
+    searcher.searchVertexes(volume);
+
+    auto vertexes = volume.getAllVertexes();
+    ASSERT_EQ(vertexes.size(), 2);
+    std::sort(vertexes.begin(), vertexes.end(), [](Vertex *first, Vertex *second)
+              { return first->getZ() < second->getZ(); });
+    EXPECT_EQ(vertexes[0]->getParentTracksCount(), 0);
+    EXPECT_EQ(vertexes[0]->getDaughterTracksCount(), 5);
+    ASSERT_EQ(vertexes[1]->getParentTracksCount(), 1);
+    EXPECT_EQ(vertexes[1]->getParentTrack(0)->getIndex(), parentTrackIndex);
+    EXPECT_EQ(vertexes[1]->getDaughterTracksCount(), 3);
+    EXPECT_NEAR(vertexes[1]->getZ(), secondary[2], 5);
+
+    const std::string fileName = "vertex_search_test_secondary.txt";
+    FedraDownloader downloader;
+    ASSERT_TRUE(downloader.downloadVertexesToFile(fileName, vertexes));
+    std::ifstream file(fileName);
+    std::string line;
+    u_int primaryLines = 0, secondaryLines = 0, secondaryTrackLines = 0;
+    while (std::getline(file, line))
+    {
+        primaryLines += line.rfind("1ry_vtx ", 0) == 0;
+        secondaryLines += line.rfind("2ry_vtx ", 0) == 0;
+        secondaryTrackLines += line.rfind("2ry_trk ", 0) == 0;
+    }
+    EXPECT_EQ(primaryLines, 1);
+    EXPECT_EQ(secondaryLines, 1);
+    EXPECT_EQ(secondaryTrackLines, 3);
+    std::remove(fileName.c_str());
+}
+
+TEST(VertexSearchTest, IncrementalSearchFindsSecondaryVertexes)
+{
+    // decay tracks added after the primary vertex was found, and primary tracks added after the decay tracks were searched
+    SearchConfig config;
+    config.searchSecondaryVertexes = true;
+    const float primary[3] = {-3010, 2990, 2010};
+    for (bool decayTracksFirst : {false, true})
+    {
+        float secondary[3];
+        std::vector<Track> primaryTracks, decayTracks;
+        u_long nextIndex = 0;
+        addPrimaryWithDecayVertex(primaryTracks, decayTracks, nextIndex, primary, 3000, secondary);
+
+        DetectorVolume volume(VOLUME_DIMENSION, CELL_DIMENSION);
+        VertexSearcher searcher(config);
+        volume.addTracks(std::move(decayTracksFirst ? decayTracks : primaryTracks));
+        searcher.searchVertexes(volume);
+        ASSERT_EQ(volume.getAllVertexes().size(), decayTracksFirst ? 0 : 1);
+        volume.addTracks(std::move(decayTracksFirst ? primaryTracks : decayTracks));
+        searcher.searchVertexesIncremental(volume);
+        expectPrimaryWithDecayVertex(getFoundVertexes(volume), secondary);
+    }
+}
+
+TEST(VertexSearchTest, StreamingSearchFindsSecondaryVertexes)
+{
+    // primary vertex is kept in the window until its decay vertex is found decay length downstream
+    SearchConfig config;
+    config.searchSecondaryVertexes = true;
+    const float primary[3] = {-3010, 2990, 2010};
+    float secondary[3];
+    std::vector<Track> tracks;
+    u_long nextIndex = 0;
+    addPrimaryWithDecayVertex(tracks, tracks, nextIndex, primary, 4000, secondary);
+
+    VertexSearcher searcher(config);
+    auto windowDepth = ZWindowVertexSearcher::calculateWindowDepth(config, CELL_DIMENSION);
+    ASSERT_LT(windowDepth * 2, VOLUME_DIMENSION);
+    DetectorVolume windowVolume(VOLUME_DIMENSION, CELL_DIMENSION, windowDepth);
+    std::vector<FoundVertex> streamedVertexes;
+    ZWindowVertexSearcher windowSearcher(windowVolume, searcher, [&streamedVertexes](std::vector<Vertex *> &emitted)
+                                         {
+                                             for (auto vertex : emitted)
+                                             {
+                                                 streamedVertexes.push_back(FoundVertex{vertex->getX(), vertex->getY(), vertex->getZ(),
+                                                                                        vertex->getDaughterTracksCount(), vertex->getParentTracksCount()});
+                                             }
+                                         });
+    for (auto &track : tracks)
+    {
+        windowSearcher.addTracks({track});
+    }
+    windowSearcher.finish();
+    expectPrimaryWithDecayVertex(streamedVertexes, secondary);
+}
+
+TEST(VertexSearchTest, RegionSearchWithHaloFindsVertexesOfFullSearch)
+{
+    // tracks of the vertexes on the region borders start outside of it, the primary of the decay vertex lies far upstream of the region
+    const float region[6] = {0, 4000, 0, 4000, 4000, 8000};
+    const float primary[3] = {1000, 1000, 1000};
+    const float decayLength = 4000;
+    std::vector<Track> tracks;
+    u_long nextIndex = 0;
+    addDaughters(tracks, nextIndex, primary[0], primary[1], primary[2], primary[2] + 20, 0, 5);
+    const float secondary[3] = {primary[0] + tracks.front().getTanX() * decayLength, primary[1] + tracks.front().getTanY() * decayLength,
+                                primary[2] + decayLength};
+    addDaughters(tracks, nextIndex, secondary[0], secondary[1], secondary[2], secondary[2] + 20, 2, 3);
+    addDaughters(tracks, nextIndex, 3990, 2000, 6000, 6600, 0, 6); // X border
+    addDaughters(tracks, nextIndex, 2000, 10, 7900, 8500, 0, 6);   // Y and Z border
+    addDaughters(tracks, nextIndex, 6000, 2000, 6000, 6020, 0, 5); // outside of the region
+
+    TrackColumns columns;
+    for (auto &track : tracks)
+    {
+        columns.X.push_back(track.getX());
+        columns.Y.push_back(track.getY());
+        columns.Z.push_back(track.getZ());
+        columns.tanX.push_back(track.getTanX());
+        columns.tanY.push_back(track.getTanY());
+    }
+    const std::string fileName = "vertex_search_test_region.trk";
+    writeNativeTrackFile(fileName, columns, TrackFileOrder::ByCell, CELL_DIMENSION, VOLUME_DIMENSION);
+
+    SearchConfig config;
+    config.searchSecondaryVertexes = true;
+    EXPECT_EQ(config.getSearchHaloXY(), 1000);
+    EXPECT_EQ(config.getSearchHaloZ(), 1000 + config.decayLengthZ);
+    auto inRegion = [&region](const FoundVertex &vertex)
+    {
+        return vertex.X >= region[0] && vertex.X <= region[1] && vertex.Y >= region[2] && vertex.Y <= region[3] && vertex.Z >= region[4] &&
+               vertex.Z <= region[5];
+    };
+
+    VertexSearcher searcher;
+    searcher.setConfig(config);
+    std::vector<FoundVertex> fullSearchVertexes;
+    {
+        DetectorVolume fullVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+        fullVolume.addTracks(std::move(tracks));
+        searcher.searchVertexes(fullVolume);
+        fullSearchVertexes = getFoundVertexes(fullVolume);
+    }
+    fullSearchVertexes.erase(std::remove_if(fullSearchVertexes.begin(), fullSearchVertexes.end(), [&](auto &vertex)
+                                            { return !inRegion(vertex); }),
+                             fullSearchVertexes.end());
+
+    auto haloXY = config.getSearchHaloXY(), haloZ = config.getSearchHaloZ();
+    DetectorVolume regionVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+    regionVolume.addTracks(FedraDownloader().downloadTracksFromFileInRegion(fileName, region[0] - haloXY, region[1] + haloXY, region[2] - haloXY,
+                                                                            region[3] + haloXY, region[4] - haloZ, region[5] + haloZ));
+    searcher.searchVertexes(regionVolume);
+    auto regionVertexes = getFoundVertexes(regionVolume);
+    regionVertexes.erase(std::remove_if(regionVertexes.begin(), regionVertexes.end(), [&](auto &vertex)
+                                        { return !inRegion(vertex); }),
+                         regionVertexes.end());
+
+    ASSERT_EQ(fullSearchVertexes.size(), 3);
+    EXPECT_EQ(fullSearchVertexes[0].parentsCount, 1);
+    ASSERT_EQ(regionVertexes.size(), fullSearchVertexes.size());
+    for (size_t v = 0; v < fullSearchVertexes.size(); v++)
+    {
+        EXPECT_EQ(regionVertexes[v].daughtersCount, fullSearchVertexes[v].daughtersCount);
+        EXPECT_EQ(regionVertexes[v].parentsCount, fullSearchVertexes[v].parentsCount);
+        EXPECT_NEAR(regionVertexes[v].X, fullSearchVertexes[v].X, 1);
+        EXPECT_NEAR(regionVertexes[v].Y, fullSearchVertexes[v].Y, 1);
+        EXPECT_NEAR(regionVertexes[v].Z, fullSearchVertexes[v].Z, 5);
+    }
+    std::remove(fileName.c_str());
+}
+
+TEST(VertexSearchTest, CompileTimeKernelIsChosenOnlyForItsConfig)
+{
+    SearchConfig config;
+    EXPECT_STREQ(VertexSearcher(config).getSearchKernelName(), "compile-time standard");
+    config.searchSecondaryVertexes = true;
+    EXPECT_STREQ(VertexSearcher(config).getSearchKernelName(), "compile-time secondary");
+    config.impactParameter = 16;
+    EXPECT_STREQ(VertexSearcher(config).getSearchKernelName(), "runtime");
+    config = SearchConfig();
+    config.cutDirectTracks = false;
+    EXPECT_STREQ(VertexSearcher(config).getSearchKernelName(), "runtime");
+
+    // secondary daughters cut is not used without the decay vertexes search, so the runtime kernel has to find the same vertexes
+    const float vertexes[][3] = {{-7010, 3000, 990}, {2020, -5990, 3980}, {6000, 6010, 6960}, {6100, 5900, 7200}};
+    std::vector<Track> tracks;
+    u_long nextIndex = 0;
+    for (auto &vertex : vertexes)
+    {
+        addDaughters(tracks, nextIndex, vertex[0], vertex[1], vertex[2], vertex[2] + 20, 0, 5);
+    }
+    config = SearchConfig();
+    config.secondaryDaughtersCountCut = 3;
+    VertexSearcher runtimeSearcher(config);
+    ASSERT_STREQ(runtimeSearcher.getSearchKernelName(), "runtime");
+
+    DetectorVolume compileTimeVolume(VOLUME_DIMENSION, CELL_DIMENSION), runtimeVolume(VOLUME_DIMENSION, CELL_DIMENSION);
+    compileTimeVolume.addTracks(std::vector<Track>(tracks));
+    runtimeVolume.addTracks(std::move(tracks));
+    VertexSearcher compileTimeSearcher;
+    compileTimeSearcher.searchVertexes(compileTimeVolume);
+    runtimeSearcher.searchVertexes(runtimeVolume);
+    auto compileTimeVertexes = getFoundVertexes(compileTimeVolume), runtimeVertexes = getFoundVertexes(runtimeVolume);
+
+    EXPECT_EQ(compileTimeSearcher.getTestedPairsCount(), runtimeSearcher.getTestedPairsCount());
+    ASSERT_EQ(compileTimeVertexes.size(), 4);
+    ASSERT_EQ(runtimeVertexes.size(), compileTimeVertexes.size());
+    for (size_t v = 0; v < compileTimeVertexes.size(); v++)
+    {
+        EXPECT_EQ(runtimeVertexes[v].daughtersCount, compileTimeVertexes[v].daughtersCount);
+        EXPECT_EQ(runtimeVertexes[v].X, compileTimeVertexes[v].X);
+        EXPECT_EQ(runtimeVertexes[v].Y, compileTimeVertexes[v].Y);
+        EXPECT_EQ(runtimeVertexes[v].Z, compileTimeVertexes[v].Z);
+    }
+}
+
+TEST(VertexSearchTest, CachedAssociationPassFindsVertexesOfUncachedOne)
+{
+    SyntheticBrickConfig brickConfig;
+    brickConfig.seed = 3;
+    brickConfig.tracksCount = 20000;
+    auto brick = generateSyntheticBrick(brickConfig);
+
+    /* Vertexes with the input indexes of their daughter tracks, in the order of the vertex positions. */
+    auto searchWithCache = [&brick](size_t pairCacheMaxTracks, u_long &testedPairs)
+    {
+        DetectorVolume volume(VOLUME_DIMENSION, CELL_DIMENSION);
+        volume.addTracks(brick.createTracks());
+        VertexSearcher searcher;
+        searcher.setPairCacheMaxTracks(pairCacheMaxTracks);
+        searcher.searchVertexes(volume);
+        testedPairs = searcher.getTestedPairsCount();
+
+        std::vector<std::tuple<float, float, float, std::vector<u_long>>> vertexes;
+        for (auto vertex : volume.getAllVertexes())
+        {
+            std::vector<u_long> daughters;
+            for (u_int d = 0; d < vertex->getDaughterTracksCount(); d++)
+            {
+                daughters.push_back(vertex->getDaughterTrack(d)->getIndex());
+            }
+            std::sort(daughters.begin(), daughters.end());
+            vertexes.emplace_back(vertex->getZ(), vertex->getX(), vertex->getY(), std::move(daughters));
+        }
+        std::sort(vertexes.begin(), vertexes.end());
+        return vertexes;
+    };
+
+    u_long cachedTestedPairs, uncachedTestedPairs, partlyCachedTestedPairs;
+    auto cachedVertexes = searchWithCache(1 << 22, cachedTestedPairs);
+    auto uncachedVertexes = searchWithCache(0, uncachedTestedPairs);
+    auto partlyCachedVertexes = searchWithCache(200, partlyCachedTestedPairs); // only the first vertexes fit in the cache
+
+    ASSERT_GT(cachedVertexes.size(), 100);
+    EXPECT_EQ(uncachedTestedPairs, cachedTestedPairs);
+    EXPECT_EQ(partlyCachedTestedPairs, cachedTestedPairs);
+    EXPECT_EQ(uncachedVertexes, cachedVertexes);
+    EXPECT_EQ(partlyCachedVertexes, cachedVertexes);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/data_types/Segment.hpp"
+#include "../src/data_types/Track.hpp"
+#include "../src/data_types/Vertex.hpp"
+#include "../src/downloaders/FedraDownloader.hpp"
+
+namespace
+{
+    /* Vertexes text as it was formatted by std::to_string and written by ofstream before the to_chars formatting. */
+    std::string formatVertexesLikeToString(std::vector<Vertex *> &vertexes)
+    {
+        std::ostringstream outFile;
+        for (auto vert : vertexes)
+        {
+            auto vXs1 = std::to_string(vert->getX());
+            auto vXs2 = vXs1.substr(0, vXs1.find(".") + 3);
+            auto vYs1 = std::to_string(vert->getY());
+            auto vYs2 = vYs1.substr(0, vYs1.find(".") + 3);
+            auto vZs1 = std::to_string(vert->getZ());
+            auto vZs2 = vZs1.substr(0, vZs1.find(".") + 3);
+
+            bool secondary = vert->getParentTracksCount() != 0;
+
+            outFile << (secondary ? "2ry_vtx " : "1ry_vtx ") << "0 0 0 0 " << std::to_string(vert->getIndex()) + " " << vXs2 + " " << vYs2 + " "
+                    << vZs2 + " " << "0 0 " << std::to_string(vert->getDaughterTracksCount()) + " " << "0 0 0 0 " << std::endl;
+            for (size_t t = 0; t < vert->getDaughterTracksCount(); t++)
+            {
+                auto tr = vert->getDaughterTrack(t);
+
+                auto tXs1 = std::to_string(tr->getX());
+                auto tXs2 = tXs1.substr(0, tXs1.find(".") + 3);
+                auto tYs1 = std::to_string(tr->getY());
+                auto tYs2 = tYs1.substr(0, tYs1.find(".") + 3);
+                auto tTXs1 = std::to_string(tr->getTanX());
+                auto tTXs2 = tTXs1.substr(0, tTXs1.find(".") + 3);
+                auto tTYs1 = std::to_string(tr->getTanY());
+                auto tTYs2 = tTYs1.substr(0, tTYs1.find(".") + 3);
+
+                outFile << (secondary ? "2ry_trk " : "1ry_trk ") << "0 0 0 0 " << std::to_string(vert->getIndex()) + " " << vXs2 + " "
+                        << vYs2 + " " << vZs2 + " " << "0 " << std::to_string(vert->getDaughterTracksCount()) + " " << "0 0 0 "
+                        << std::to_string(tr->getIndex()) + " " << "0 0 " << tXs2 + " " << tYs2 + " " << tTXs2 + " " << tTYs2 + " "
+                        << std::to_string(tr->getSegmentsCount()) + " " << "0 0 0 0 0 0 " << std::endl;
+            }
+            outFile << std::endl;
+        }
+        return outFile.str();
+    }
+
+    std::string readFile(const std::string &fileName)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /* Negative values, values rounding up at the second decimal and values whose float is just below or above it. */
+    const float COORDINATES[] = {0, -0.0f, 1.005f, -1.005f, 0.999999f, -0.999999f, 2.675f, -2.675f, 0.0049999f, -0.0050001f, 1e-7f, -1e-7f,
+                                 9999.995f, -9999.995f, 12345.678f, -19999.99f, 1e6f + 0.125f, 0.125f, -0.375f, 3.14159265f};
+    const size_t COORDINATES_COUNT = sizeof(COORDINATES) / sizeof(COORDINATES[0]);
+}
+
+TEST(VertexTextFileTest, TextIsIdenticalToToStringFormat)
+{
+    const std::string fileName = "vertex_text_file_test.txt";
+    const size_t VERTEXES_COUNT = 2500; // crosses the formatting blocks of 1024 vertexes
+
+    std::vector<Track> tracks;
+    for (size_t t = 0; t < VERTEXES_COUNT * 3; t++)
+    {
+        tracks.emplace_back(t * 11 + 5, COORDINATES[t % COORDINATES_COUNT], COORDINATES[(t + 3) % COORDINATES_COUNT], 100,
+                            COORDINATES[(t + 7) % COORDINATES_COUNT], COORDINATES[(t + 11) % COORDINATES_COUNT]);
+        for (size_t s = 0; s < t % 4; s++)
+        {
+            Segment segment(t, 1, 2, 3, 0.1, 0.2);
+            tracks.back().addSegment(segment);
+        }
+    }
+    std::vector<Vertex> vertexes;
+    vertexes.reserve(VERTEXES_COUNT);
+    for (size_t v = 0; v < VERTEXES_COUNT; v++)
+    {
+        vertexes.emplace_back(COORDINATES[(v + 1) % COORDINATES_COUNT], COORDINATES[(v + 5) % COORDINATES_COUNT], COORDINATES[(v + 9) % COORDINATES_COUNT]);
+        vertexes.back().setIndex(v * 1000003);
+        for (size_t t = 0; t < v % 4; t++)
+        {
+            vertexes.back().addDaughterTrack(&tracks[v * 3 + t]);
+        }
+        if (v % 7 == 0)
+            vertexes.back().addParentTrack(&tracks[v]); // decay vertex
+    }
+    std::vector<Vertex *> allVertexes, firstVertexes, lastVertexes;
+    for (size_t v = 0; v < VERTEXES_COUNT; v++)
+    {
+        allVertexes.push_back(&vertexes[v]);
+        (v < 1500 ? firstVertexes : lastVertexes).push_back(&vertexes[v]);
+    }
+    auto expected = formatVertexesLikeToString(allVertexes);
+
+    FedraDownloader downloader;
+    ASSERT_TRUE(downloader.downloadVertexesToFile(fileName, allVertexes));
+    EXPECT_EQ(readFile(fileName), expected);
+
+    // appended vertexes continue the file the same way
+    ASSERT_TRUE(downloader.downloadVertexesToFile(fileName, firstVertexes));
+    ASSERT_TRUE(downloader.downloadVertexesToFile(fileName, lastVertexes, true));
+    EXPECT_EQ(readFile(fileName), expected);
+    std::remove(fileName.c_str());
+}
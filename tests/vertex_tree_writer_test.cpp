@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TTreeReader.h>
+#include <TTreeReaderArray.h>
+#include <TTreeReaderValue.h>
+
+#include "../src/data_types/Track.hpp"
+#include "../src/data_types/Vertex.hpp"
+#include "../src/downloaders/VertexTreeWriter.hpp"
+
+namespace
+{
+    const u_int MAX_DAUGHTERS = 12;
+
+    /* Vertexes with 0 to MAX_DAUGHTERS daughter tracks, daughter track indexes are unique. */
+    struct VertexesSet
+    {
+        std::vector<Track> tracks;
+        std::vector<Vertex> vertexes;
+
+        VertexesSet(size_t count)
+        {
+            for (size_t v = 0; v < count; v++)
+            {
+                for (u_int d = 0; d < v % (MAX_DAUGHTERS + 1); d++)
+                {
+                    tracks.emplace_back(tracks.size() * 7 + 3, v, v, v, 0.1, 0.1);
+                }
+            }
+            size_t nextTrack = 0;
+            for (size_t v = 0; v < count; v++)
+            {
+                vertexes.emplace_back(v * 0.5f - 1000, 2000 - v * 0.25f, v * 1.5f);
+                vertexes.back().setIndex(v + 100);
+                for (u_int d = 0; d < v % (MAX_DAUGHTERS + 1); d++)
+                {
+                    vertexes.back().addDaughterTrack(&tracks[nextTrack++]);
+                }
+            }
+        }
+
+        std::vector<Vertex *> getPointers(size_t begin, size_t end)
+        {
+            std::vector<Vertex *> pointers;
+            for (size_t v = begin; v < end; v++)
+            {
+                pointers.push_back(&vertexes[v]);
+            }
+            return pointers;
+        }
+    };
+
+    /* Vertexes are read back from VertexTree as analysis reads them. */
+    void expectVertexTree(const std::string &fileName, VertexesSet &expected)
+    {
+        TFile file(fileName.data());
+        TTreeReader reader("VertexTree", &file);
+        TTreeReaderValue<ULong64_t> index(reader, "vID");
+        TTreeReaderArray<Float_t> position(reader, "position");
+        TTreeReaderValue<Int_t> daughtersCount(reader, "ndau");
+        TTreeReaderArray<Long64_t> daughterIndexes(reader, "dau_id");
+
+        ASSERT_EQ(reader.GetEntries(), expected.vertexes.size());
+        for (auto &vertex : expected.vertexes)
+        {
+            ASSERT_TRUE(reader.Next());
+            EXPECT_EQ(*index, vertex.getIndex());
+            ASSERT_EQ(position.GetSize(), 3);
+            EXPECT_EQ(position[0], vertex.getX());
+            EXPECT_EQ(position[1], vertex.getY());
+            EXPECT_EQ(position[2], vertex.getZ());
+            ASSERT_EQ(*daughtersCount, vertex.getDaughterTracksCount());
+            ASSERT_EQ(daughterIndexes.GetSize(), vertex.getDaughterTracksCount());
+            for (u_int t = 0; t < vertex.getDaughterTracksCount(); t++)
+            {
+                EXPECT_EQ(daughterIndexes[t], vertex.getDaughterTrack(t)->getIndex());
+            }
+        }
+        EXPECT_FALSE(reader.Next());
+        file.Close();
+    }
+}
+
+TEST(VertexTreeWriterTest, WritesSeveralBatchesInOrder)
+{
+    const std::string fileName = "vertex_tree_writer_test.root";
+    VertexesSet expected(20000); // several writer batches, calls do not match them
+    const size_t callEnds[] = {1, 5000, 5000, 8193, 17000, 20000};
+    {
+        VertexTreeWriter writer(fileName);
+        size_t begin = 0;
+        for (auto end : callEnds)
+        {
+            auto vertexes = expected.getPointers(begin, end);
+            writer.writeVertexes(vertexes); // empty call too
+            begin = end;
+        }
+        EXPECT_TRUE(writer.close());
+    }
+    expectVertexTree(fileName, expected);
+    std::remove(fileName.c_str());
+}
+
+TEST(VertexTreeWriterTest, CloseFlushesLastBatchOnce)
+{
+    const std::string fileName = "vertex_tree_writer_test_close.root";
+
+    // file without vertexes has empty tree
+    VertexesSet noVertexes(0);
+    {
+        VertexTreeWriter writer(fileName);
+        auto vertexes = noVertexes.getPointers(0, 0);
+        writer.writeVertexes(vertexes);
+        EXPECT_TRUE(writer.close());
+    }
+    expectVertexTree(fileName, noVertexes);
+
+    // the last not full batch is written by the destructor if writer was not closed
+    VertexesSet expected(100);
+    {
+        VertexTreeWriter writer(fileName);
+        auto vertexes = expected.getPointers(0, expected.vertexes.size());
+        writer.writeVertexes(vertexes);
+    }
+    expectVertexTree(fileName, expected);
+
+    // vertexes written after close are not lost silently, close could be called again
+    {
+        VertexTreeWriter writer(fileName);
+        auto vertexes = expected.getPointers(0, expected.vertexes.size());
+        writer.writeVertexes(vertexes);
+        EXPECT_TRUE(writer.close());
+        EXPECT_TRUE(writer.close());
+        auto lateVertexes = expected.getPointers(0, 1);
+        writer.writeVertexes(lateVertexes);
+        EXPECT_FALSE(writer.close());
+    }
+    expectVertexTree(fileName, expected);
+    std::remove(fileName.c_str());
+}